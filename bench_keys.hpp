@@ -0,0 +1,126 @@
+/**
+* @file     bench_keys.hpp
+* @brief    key sources shared by the benchmark executables
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+/**
+ * @brief read all keys from a file with lines like `*"key"*:*"value"*`
+ */
+inline std::vector<std::string> read_keys(std::istream& input)
+{
+    std::vector<std::string> keys;
+    std::string line;
+    std::size_t first, last;
+    while (std::getline(input, line))
+    {
+        first = line.find('\"');
+        if (first == std::string::npos) continue;
+        last = line.find('\"', first + 1);
+        if (last == std::string::npos) continue;
+        keys.push_back(line.substr(first + 1, last - first - 1));
+    }
+    return keys;
+}
+
+/**
+ * @brief generate keys shaped like the test file, a common "menu." prefix and a random name
+ */
+inline std::vector<std::string> generate_keys(std::size_t count)
+{
+    std::mt19937_64 rng(42);
+    std::vector<std::string> keys;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::string key = "menu.";
+        std::size_t length = 4 + rng() % 20;
+        for (std::size_t j = 0; j < length; j++) key.push_back((char)('a' + rng() % 26));
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+/**
+ * @brief generate keys with 8 to 24 uniformly distributed alphanumeric characters, the keys share almost no prefixes
+ */
+inline std::vector<std::string> generate_uniform_keys(std::size_t count, uint64_t seed = 1)
+{
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    std::mt19937_64 rng(seed);
+    std::vector<std::string> keys;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::string key;
+        std::size_t length = 8 + rng() % 17;
+        for (std::size_t j = 0; j < length; j++) key.push_back(alphabet[rng() % 36]);
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+/**
+ * @brief generate dotted keys like "service07.group12.name" where the first two components come from a small set
+ */
+inline std::vector<std::string> generate_shared_prefix_keys(std::size_t count, uint64_t seed = 2)
+{
+    std::mt19937_64 rng(seed);
+    std::vector<std::string> keys;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::string key = "service" + std::to_string(rng() % 16) + ".group" + std::to_string(rng() % 64) + ".";
+        std::size_t length = 4 + rng() % 8;
+        for (std::size_t j = 0; j < length; j++) key.push_back((char)('a' + rng() % 26));
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+/**
+ * @brief generate keys with 128 to 256 characters, the first 64 characters are one of 8 fixed paths
+ */
+inline std::vector<std::string> generate_long_keys(std::size_t count, uint64_t seed = 3)
+{
+    std::mt19937_64 rng(seed);
+    std::vector<std::string> paths, keys;
+    for (std::size_t i = 0; i < 8; i++)
+    {
+        std::string path = "/srv/data/" + std::to_string(i) + "/";
+        while (path.size() < 64) path.push_back((char)('a' + rng() % 26));
+        paths.push_back(path);
+    }
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::string key = paths[rng() % paths.size()];
+        std::size_t length = 64 + rng() % 129;
+        for (std::size_t j = 0; j < length; j++) key.push_back((char)('a' + rng() % 26));
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+/**
+ * @brief remove duplicate keys, the order of the first occurrences is kept
+ */
+inline std::vector<std::string> unique_keys(const std::vector<std::string>& keys)
+{
+    std::unordered_set<std::string> seen;
+    std::vector<std::string> result;
+    for (const std::string& key : keys)
+    {
+        if (seen.insert(key).second) result.push_back(key);
+    }
+    return result;
+}
@@ -0,0 +1,78 @@
+/**
+* @file     double_array_bench.cpp
+* @brief    benchmark comparing exact-match lookups of the double-array trie against trie256
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include "trie.hpp"
+#include "bench_keys.hpp"
+
+/**
+ * @brief time every lookup of 'keys', repeated 'rounds' times, and print the average and 99th percentile.
+ *  The keys are passed in the form the structure looks up, so building them is not part of the samples.
+ */
+template<typename key_t, typename lookup_t>
+void run_lookups(const std::string& name, const std::vector<key_t>& keys, std::size_t rounds, lookup_t lookup)
+{
+    std::vector<double> samples;
+    std::size_t found = 0;
+    samples.reserve(keys.size() * rounds);
+    auto total_start = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < rounds; round++)
+    {
+        for (const key_t& key : keys)
+        {
+            auto start = std::chrono::steady_clock::now();
+            found += lookup(key) ? 1 : 0;
+            auto stop = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration<double, std::nano>(stop - start).count());
+        }
+    }
+    auto total_stop = std::chrono::steady_clock::now();
+    std::sort(samples.begin(), samples.end());
+    double total = std::chrono::duration<double, std::nano>(total_stop - total_start).count();
+    std::cout << name << ": " << samples.size() << " lookups (" << found << " hits), "
+        << "avg " << total / samples.size() << " ns/op, "
+        << "p50 " << samples.at(samples.size() / 2) << " ns, "
+        << "p99 " << samples.at(samples.size() * 99 / 100) << " ns" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    std::string filename = (argc > 1) ? argv[1] : "test_data.txt";
+    std::ifstream ifile(filename);
+    std::vector<std::string> keys = ifile ? read_keys(ifile) : generate_keys(20000);
+    if (!ifile) std::cout << "could not open " << filename << ", using generated keys" << std::endl;
+    if (keys.empty()) throw std::runtime_error("No keys to benchmark");
+
+    trie::trie256<std::string> source;
+    for (const std::string& key : keys)
+    {
+        source.insert(trie::key256(key), std::make_shared<std::string>(key));
+    }
+
+    auto build_start = std::chrono::steady_clock::now();
+    trie::double_array_trie<std::string> compiled(source);
+    auto build_stop = std::chrono::steady_clock::now();
+    std::cout << "compiled " << compiled.size() << " keys into " << compiled.unit_count() << " units ("
+        << compiled.memory_usage() << " bytes) in "
+        << std::chrono::duration<double, std::milli>(build_stop - build_start).count() << " ms" << std::endl;
+
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(1));
+    std::vector<trie::key256> trie_keys(keys.begin(), keys.end());
+    run_lookups("trie256::find", trie_keys, 5, [&](const trie::key256& key) { return source.find(key) != nullptr; });
+    run_lookups("double_array_trie::find", keys, 5, [&](const std::string& key) { return compiled.find(key) != nullptr; });
+
+    return 0;
+}
@@ -6,9 +6,52 @@
 #include <sstream>
 #include <chrono>
 #include <thread>
+#include <atomic>
+#include <map>
+#include <random>
+#include <limits>
+#include <set>
+#include <tuple>
+#include <regex>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "trie.hpp"
 
+template<std::size_t children_count>
+void print_stats(const trie::basic_trie<children_count, std::string>& data, std::ostream& output_log)
+{
+    auto stats = data.stats();
+    output_log << "[stats] " << stats.node_count << " nodes, " << stats.value_count << " values, " << stats.tail_count << " tails, "
+        << stats.empty_leaf_count << " empty leaf nodes" << std::endl
+        << "[stats] " << stats.node_bytes << " bytes in nodes, " << stats.key_bytes << " bytes in keys, " << stats.value_bytes << " bytes in values" << std::endl
+        << "[stats] " << stats.chain_count << " single-child chains, lengths:";
+    for (std::size_t length = 0; length < stats.chain_histogram.size(); length++)
+    {
+        if (stats.chain_histogram[length] != 0) output_log << " " << length << "x" << stats.chain_histogram[length];
+    }
+    output_log << std::endl << "[stats] values per key length:";
+    for (std::size_t depth = 0; depth < stats.depth_histogram.size(); depth++)
+    {
+        if (stats.depth_histogram[depth] != 0) output_log << " " << depth << ":" << stats.depth_histogram[depth];
+    }
+    output_log << std::endl;
+    for (std::size_t level = 0; level < stats.fanout_histogram.size(); level++)
+    {
+        // only print the fan-outs that occur on this level, as 'children:nodes'
+        output_log << "[stats] level " << level << " fan-out:";
+        for (std::size_t fanout = 0; fanout <= children_count; fanout++)
+        {
+            if (stats.fanout_histogram[level][fanout] != 0) output_log << " " << fanout << ":" << stats.fanout_histogram[level][fanout];
+        }
+        output_log << std::endl;
+    }
+}
+
 template<std::size_t children_count>
 void simple_test(trie::basic_trie<children_count, std::string>& data, std::ostream &output_log)
 {
@@ -51,6 +94,8 @@ void simple_test(trie::basic_trie<children_count, std::string>& data, std::ostre
     }
     output_log << "second.size(): " << second.size() << std::endl;
 
+    print_stats(data, output_log);
+
     output_log << "Running line: data.erase(\"DEF\"):" << std::endl
                << "Running line: data.merge(second);" << std::endl;
     data.erase(trie::basic_key<children_count>("DEF"));
@@ -71,6 +116,1245 @@ void simple_test(trie::basic_trie<children_count, std::string>& data, std::ostre
     data.clear();
 }
 
+/**
+ * @brief throw if a check of a test failed
+ */
+void expect(bool condition, const std::string& message)
+{
+    if (!condition) throw std::runtime_error("Error testing " + message);
+}
+
+/**
+ * @brief orders strings like the keys of a trie: element by element, a key comes before all keys it is a prefix of.
+ *  Only the 256-children keys store whole bytes, the other keys start with the low bits of a byte, so they are not in byte order.
+ */
+template<std::size_t children_count>
+struct key_order
+{
+    bool operator()(const std::string& left, const std::string& right) const
+    {
+        trie::basic_key<children_count> first(left), second(right);
+        for (std::size_t i = 0; i < first.size() && i < second.size(); i++)
+        {
+            if (first.get_element(i) != second.get_element(i)) return first.get_element(i) < second.get_element(i);
+        }
+        return first.size() < second.size();
+    }
+};
+
+template<std::size_t children_count>
+using reference_map = std::map<std::string, std::string, key_order<children_count> >;
+
+/**
+ * @brief insert the same random keys into a trie and into a std::map, the map is the reference the structures are checked against.
+ *  The keys use a small alphabet with characters of different high and low bits, so they share prefixes, some of them are prefixes of others
+ *  and the key order of the smaller fan-outs differs from the byte order.
+ */
+template<std::size_t children_count>
+void fill_random(trie::basic_trie<children_count, std::string>& data, reference_map<children_count>& reference, std::size_t count,
+    std::size_t max_length, unsigned seed)
+{
+    std::mt19937 rng(seed + (unsigned)children_count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::string key;
+        for (std::size_t length = rng() % (max_length + 1); key.size() < length; ) key.push_back("aeiLR.?"[rng() % 7]);
+        data.insert(trie::basic_key<children_count>(key), std::make_shared<std::string>(key + "!"));
+        reference[key] = key + "!";
+    }
+}
+
+template<std::size_t children_count>
+void test_succinct_trie(std::ostream& output_log)
+{
+    using key_t = trie::basic_key<children_count>;
+    trie::basic_trie<children_count, std::string> data;
+    reference_map<children_count> reference;
+    fill_random(data, reference, 3000, 8, 26);
+    trie::succinct_trie<children_count, std::string> succinct(data);
+
+    output_log << "Running succinct trie test: " << succinct.size() << " keys in " << succinct.node_count() << " nodes" << std::endl;
+    expect(succinct.size() == reference.size(), "succinct trie: size does not match");
+    auto iter = succinct.begin();
+    for (const auto& pair : reference)
+    {
+        expect(iter != succinct.end(), "succinct trie: iterator ended early");
+        expect(iter.get_key().to_string() == pair.first, "succinct trie: key order does not match at [" + pair.first + "]");
+        expect(*iter.get_data() == pair.second, "succinct trie: value does not match at [" + pair.first + "]");
+        expect(*succinct.at(key_t(pair.first)) == pair.second, "succinct trie: at() does not match at [" + pair.first + "]");
+        expect(succinct.has_node(key_t(pair.first.substr(0, pair.first.size() / 2))), "succinct trie: prefix of [" + pair.first + "] not found");
+        iter++;
+    }
+    expect(iter == succinct.end(), "succinct trie: iterator did not end");
+    expect(!succinct.has_node(key_t("aez")), "succinct trie: found a missing key");
+    expect(trie::succinct_trie<children_count, std::string>().begin() == trie::succinct_trie<children_count, std::string>().end(),
+        "succinct trie: empty trie is not empty");
+}
+
+template<std::size_t children_count>
+void test_tails(std::ostream& output_log)
+{
+    using key_t = trie::basic_key<children_count>;
+    trie::basic_trie<children_count, std::string> data;
+    reference_map<children_count> reference;
+    fill_random(data, reference, 300, 12, 28);
+    std::mt19937 rng(28 + (unsigned)children_count);
+
+    // storing values at prefixes of stored keys through at() expands the tails the prefixes end in
+    for (std::size_t i = 0; i < 1000; i++)
+    {
+        std::string key;
+        for (std::size_t length = rng() % 13; key.size() < length; ) key.push_back("aeiLR.?"[rng() % 7]);
+        auto below = reference.lower_bound(key);
+        bool exists = below != reference.end() && below->first.compare(0, key.size(), key) == 0;
+        try
+        {
+            std::shared_ptr<std::string>& value = data.at(key_t(key));
+            expect(exists, "tails: at() found a missing key [" + key + "]");
+            if (value == nullptr)
+            {
+                value = std::make_shared<std::string>(key + "?");
+                reference[key] = key + "?";
+            }
+            expect(*value == reference[key], "tails: at() does not match at [" + key + "]");
+        }
+        catch (const std::out_of_range&)
+        {
+            expect(!exists, "tails: at() did not find [" + key + "]");
+        }
+    }
+
+    output_log << "Running tails test: " << reference.size() << " keys, " << data.stats().tail_count << " tails" << std::endl;
+    expect(data.size() == reference.size(), "tails: size does not match");
+    auto iter = data.begin();
+    for (const auto& pair : reference)
+    {
+        expect(iter != data.end() && iter.get_key().to_string() == pair.first, "tails: key order does not match at [" + pair.first + "]");
+        expect(*iter.get_data() == pair.second && *data.find(key_t(pair.first)) == pair.second, "tails: value does not match at [" + pair.first + "]");
+        iter++;
+    }
+    expect(iter == data.end(), "tails: iterator did not end");
+}
+
+void test_double_array_trie(std::ostream& output_log)
+{
+    trie::trie256<std::string> data;
+    std::map<std::string, std::string> reference;
+    std::mt19937 rng(27);
+    for (std::size_t i = 0; i < 20000; i++)
+    {
+        // mostly letters with some arbitrary bytes, so the bases have to be placed around every possible element
+        std::string key;
+        for (std::size_t length = rng() % 10; key.size() < length; ) key.push_back((char)((rng() % 7 == 0) ? rng() % 256 : 'a' + rng() % 5));
+        data.insert(trie::key256(key), std::make_shared<std::string>(key + "!"));
+        reference[key] = key + "!";
+    }
+    trie::double_array_trie<std::string> compiled(data);
+
+    output_log << "Running double-array trie test: " << compiled.size() << " keys in " << compiled.unit_count() << " units" << std::endl;
+    expect(compiled.size() == reference.size(), "double-array trie: size does not match");
+    for (const auto& pair : reference)
+    {
+        const std::shared_ptr<std::string>* result = compiled.find(pair.first);
+        expect(result != nullptr && **result == pair.second, "double-array trie: find() does not match at [" + pair.first + "]");
+    }
+    for (std::size_t i = 0; i < 20000; i++)
+    {
+        std::string key;
+        for (std::size_t length = rng() % 10; key.size() < length; ) key.push_back((char)('a' + rng() % 6));
+        expect(compiled.contains(key) == (reference.count(key) != 0), "double-array trie: contains() does not match at [" + key + "]");
+    }
+    bool thrown = false;
+    try { compiled.at("abcdefff"); }
+    catch (const std::out_of_range&) { thrown = true; }
+    expect(thrown || reference.count("abcdefff") != 0, "double-array trie: at() of a missing key did not throw");
+    expect(!trie::double_array_trie<std::string>().contains(""), "double-array trie: empty trie is not empty");
+
+    // a root without children has the base 0, the byte 0x00 must not lead from it back to the root
+    trie::trie256<std::string> empty_key;
+    empty_key.insert(trie::key256(std::string()), std::make_shared<std::string>("!"));
+    trie::double_array_trie<std::string> only_root(empty_key);
+    expect(only_root.contains("") && !only_root.contains(std::string(1, '\0')) && !only_root.contains(std::string(2, '\0')),
+        "double-array trie: the root is its own child");
+}
+
+template<std::size_t children_count>
+void test_dawg(std::ostream& output_log)
+{
+    using key_t = trie::basic_key<children_count>;
+    trie::basic_trie<children_count, std::string> data;
+    reference_map<children_count> reference;
+    std::mt19937 rng(29 + (unsigned)children_count);
+    const char* suffixes[] = { ".title", ".description", ".tooltip" };
+    for (std::size_t i = 0; i < 3000; i++)
+    {
+        // many keys share their suffixes, some are cut short so keys also end inside of the shared states
+        std::string key = "menu.";
+        for (std::size_t length = rng() % 4; length > 0; length--) key.push_back((char)('a' + rng() % 6));
+        key += suffixes[rng() % 3];
+        if (rng() % 5 == 0) key = key.substr(0, rng() % key.size());
+        data.insert(key_t(key), std::make_shared<std::string>(key + "!"));
+        reference[key] = key + "!";
+    }
+    trie::dawg<children_count, std::string> automaton(data);
+
+    output_log << "Running dawg test: " << automaton.size() << " keys in " << automaton.state_count() << " states" << std::endl;
+    expect(automaton.size() == reference.size(), "dawg: size does not match");
+    std::size_t index = 0;
+    auto iter = automaton.begin();
+    for (const auto& pair : reference)
+    {
+        expect(iter != automaton.end(), "dawg: iterator ended early");
+        expect(iter.get_key().to_string() == pair.first && iter.get_index() == index, "dawg: key order does not match at [" + pair.first + "]");
+        expect(*iter.get_data() == pair.second && *automaton.at(key_t(pair.first)) == pair.second, "dawg: value does not match at [" + pair.first + "]");
+        expect(automaton.index_of(key_t(pair.first)) == index, "dawg: index_of() does not match at [" + pair.first + "]");
+        expect(automaton.key_at(index).to_string() == pair.first, "dawg: key_at() does not match at [" + pair.first + "]");
+        iter++;
+        index++;
+    }
+    expect(iter == automaton.end(), "dawg: iterator did not end");
+    expect(automaton.index_of(key_t("menu.zz")) == trie::dawg<children_count, std::string>::npos, "dawg: found a missing key");
+    expect(automaton.contains(key_t("menu.")) == (reference.count("menu.") != 0), "dawg: contains() does not match at [menu.]");
+}
+
+template<std::size_t children_count>
+void test_hat_trie(std::ostream& output_log)
+{
+    using key_t = trie::basic_key<children_count>;
+    for (std::size_t threshold : { (std::size_t)1, (std::size_t)16, trie::hat_trie<children_count, std::string>::default_burst_threshold, (std::size_t)100000 })
+    {
+        trie::hat_trie<children_count, std::string> data(threshold);
+        reference_map<children_count> reference;
+        std::mt19937 rng(30 + (unsigned)children_count);
+        // inserts, erases and lookups are mixed, so the buckets burst, shrink and compact their buffers while being checked
+        for (std::size_t i = 0; i < 20000; i++)
+        {
+            std::string key;
+            for (std::size_t length = rng() % 6; key.size() < length; ) key.push_back("aeiLR.?"[rng() % 7]);
+            switch (rng() % 3)
+            {
+            case 0:
+                expect(data.insert(key_t(key), std::make_shared<std::string>(key + "!")) == reference.emplace(key, key + "!").second,
+                    "hat trie: insert() does not match at [" + key + "]");
+                break;
+            case 1:
+                expect(data.erase(key_t(key)) == (reference.erase(key) != 0), "hat trie: erase() does not match at [" + key + "]");
+                break;
+            default:
+                expect(data.contains(key_t(key)) == (reference.count(key) != 0), "hat trie: contains() does not match at [" + key + "]");
+                if (reference.count(key) != 0) expect(*data.at(key_t(key)) == reference[key], "hat trie: at() does not match at [" + key + "]");
+                break;
+            }
+            expect(data.size() == reference.size(), "hat trie: size does not match");
+        }
+
+        output_log << "Running hat trie test: " << data.size() << " keys, burst threshold " << threshold << std::endl;
+        auto iter = data.begin();
+        for (const auto& pair : reference)
+        {
+            expect(iter != data.end(), "hat trie: iterator ended early");
+            expect(iter.get_key().to_string() == pair.first, "hat trie: key order does not match at [" + pair.first + "]");
+            expect(*iter.get_data() == pair.second, "hat trie: value does not match at [" + pair.first + "]");
+            iter++;
+        }
+        expect(iter == data.end(), "hat trie: iterator did not end");
+
+        // erasing every key has to remove the empty buckets and merge the burst nodes back into the root bucket
+        for (const auto& pair : reference)
+        {
+            expect(data.erase(key_t(pair.first)), "hat trie: erase() failed at [" + pair.first + "]");
+        }
+        expect(data.size() == 0 && data.begin() == data.end(), "hat trie: keys left after erasing all keys");
+        expect(data.node_count() == 1, "hat trie: " + std::to_string(data.node_count()) + " nodes left after erasing all keys");
+        expect(data.insert(key_t("aeiou"), std::make_shared<std::string>("x")) && data.contains(key_t("aeiou")), "hat trie: insert() after erasing all keys failed");
+    }
+}
+
+/**
+ * @brief load the same pairs from a regular file, which is mapped, and from a pipe, which reports a size of 0 and has to be read in blocks
+ */
+void test_kv_loader(std::ostream& output_log)
+{
+    std::string text;
+    std::map<std::string, std::string> reference;
+    std::mt19937 rng(35);
+    for (std::size_t i = 0; i < 5000; i++)
+    {
+        std::string key = std::to_string(rng()), value = std::to_string(rng());
+        text += "  \"" + key + "\": \"" + value + "\",\n";
+        reference[key] = value;
+    }
+    const std::string filename = "kv_loader_test.txt";
+    std::ofstream(filename, std::ios::binary) << text;
+    std::vector<std::string> sources = { filename };
+#if defined(__unix__) || defined(__APPLE__)
+    const std::string pipename = "kv_loader_test.fifo";
+    unlink(pipename.c_str());
+    if (mkfifo(pipename.c_str(), 0600) == 0) sources.push_back(pipename);
+#endif
+
+    for (const std::string& source : sources)
+    {
+        for (bool pipelined : { false, true })
+        {
+            // opening a pipe for writing blocks until the loader opens it for reading
+            std::thread writer;
+            if (source != filename) writer = std::thread([&source, &text]() { std::ofstream(source, std::ios::binary) << text; });
+            trie::trie256<std::string> data;
+            std::size_t pairs = trie::load_kv_file(source, data, pipelined, 100);
+            if (writer.joinable()) writer.join();
+            output_log << "Running kv loader test: " << pairs << " pairs from " << source << (pipelined ? ", pipelined" : "") << std::endl;
+            expect(pairs == 5000 && data.size() == reference.size(), "kv loader: number of pairs does not match for " + source);
+            for (const auto& pair : reference)
+            {
+                expect(data.find(trie::key256(pair.first)) != nullptr && *data.find(trie::key256(pair.first)) == pair.second,
+                    "kv loader: value does not match at [" + pair.first + "] for " + source);
+            }
+        }
+    }
+    expect(trie::mapped_file(filename).contents() == text, "kv loader: mapped file does not match");
+    std::remove(filename.c_str());
+#if defined(__unix__) || defined(__APPLE__)
+    unlink(pipename.c_str());
+#endif
+}
+
+void test_destruction(std::ostream& output_log)
+{
+    // two long keys that only differ in their last element, every other element is a single-child node of the trie2
+    std::string first(100000, 'a'), second = first;
+    second.back() = 'b';
+    std::shared_ptr<std::string> value = std::make_shared<std::string>("value");
+
+    output_log << "Running destruction test: chains of " << first.size() * 4 << " nodes" << std::endl;
+    {
+        trie::trie2<std::string> data;
+        data.insert(trie::key2(first), value);
+        data.insert(trie::key2(second), value);
+        data.clear(); // a recursive release would overflow the stack here
+        expect(data.size() == 0 && value.use_count() == 1, "destruction: clear() did not release the values");
+        data.insert(trie::key2(first), value);
+        data.insert(trie::key2(second), value);
+    }
+    expect(value.use_count() == 1, "destruction: destructor did not release the values");
+
+    {
+        trie::background_reclaimer reclaimer;
+        trie::trie2<std::string> data;
+        for (std::size_t round = 0; round < 3; round++)
+        {
+            data.insert(trie::key2(first), value);
+            data.insert(trie::key2(second), value);
+            data.clear(reclaimer);
+            expect(data.size() == 0 && data.begin() == data.end(), "destruction: clear(reclaimer) did not empty the trie");
+        }
+        reclaimer.drain();
+        expect(reclaimer.pending() == 0 && value.use_count() == 1, "destruction: the reclaimer did not release the values");
+    }
+
+    // a subtrie shares its nodes with the trie, clearing the trie must not release them
+    trie::trie16<std::string> data;
+    data.insert(trie::key16("abcdef"), value);
+    data.insert(trie::key16("abcxyz"), value);
+    trie::trie16<std::string> sub = data.subtrie(trie::key16("abc"));
+    data.clear();
+    std::size_t counter = 0;
+    for (auto iter = sub.begin(); iter != sub.end(); iter++) counter++;
+    expect(counter == 2 && value.use_count() == 3, "destruction: clear() released the nodes of a subtrie");
+}
+
+template<std::size_t children_count>
+void test_traversal(std::ostream& output_log)
+{
+    using key_t = trie::basic_key<children_count>;
+    trie::basic_trie<children_count, std::string> data;
+    reference_map<children_count> reference;
+    std::mt19937 rng(37 + (unsigned)children_count);
+    fill_random(data, reference, 2000, 8, 37);
+    std::size_t nodes = data.stats().node_count;
+
+    output_log << "Running traversal test: " << reference.size() << " keys" << std::endl;
+    std::vector<std::string> expected, visited;
+    for (auto iter = data.node_begin(); iter != data.node_end(); iter++) expected.push_back(iter.get_key().to_string() + "|" + (iter.get_data() ? *iter.get_data() : "-"));
+    data.for_each_node([&visited](const key_t& key, std::shared_ptr<std::string>& value)
+        {
+            visited.push_back(key.to_string() + "|" + (value ? *value : "-"));
+        });
+    expect(visited == expected, "traversal: for_each_node() does not match the node iterator");
+
+    for (std::size_t query = 0; query < 200; query++)
+    {
+        std::string prefix, last;
+        for (std::size_t length = rng() % 4; prefix.size() < length; ) prefix.push_back("aeiLR.?"[rng() % 7]);
+        for (std::size_t length = rng() % 4; last.size() < length; ) last.push_back("aeiLR.?"[rng() % 7]);
+        expected.clear();
+        for (const auto& pair : reference)
+        {
+            if (pair.first.compare(0, prefix.size(), prefix) == 0) expected.push_back(pair.first);
+        }
+
+        visited.clear();
+        data.for_each(key_t(prefix), [&visited](const key_t& key, std::shared_ptr<std::string>& value)
+            {
+                if (key.to_string() + "!" != *value) throw std::runtime_error("Error testing traversal: key does not match its value");
+                visited.push_back(key.to_string());
+            });
+        expect(visited == expected, "traversal: for_each() does not match at prefix [" + prefix + "]");
+
+        std::size_t counter = 0;
+        bool completed = data.for_each(key_t(prefix), [&counter](const key_t&, std::shared_ptr<std::string>&)
+            {
+                return (++counter == 3) ? trie::visit_result::stop : trie::visit_result::proceed;
+            });
+        expect(counter == std::min<std::size_t>(3, expected.size()) && completed == (expected.size() < 3), "traversal: stop does not end the traversal at prefix [" + prefix + "]");
+
+        // skipping the subtree of every value only visits the values without a shorter stored key as their prefix
+        std::vector<std::string> outermost;
+        for (const std::string& key : expected)
+        {
+            if (outermost.empty() || key.compare(0, outermost.back().size(), outermost.back()) != 0) outermost.push_back(key);
+        }
+        visited.clear();
+        data.for_each(key_t(prefix), [&visited](const key_t& key, std::shared_ptr<std::string>&)
+            {
+                visited.push_back(key.to_string());
+                return trie::visit_result::skip_subtree;
+            });
+        expect(visited == outermost, "traversal: skip_subtree does not match at prefix [" + prefix + "]");
+
+        expected.clear();
+        for (auto iter = reference.lower_bound(prefix); iter != reference.end() && key_order<children_count>()(iter->first, last); iter++) expected.push_back(iter->first);
+        visited.clear();
+        data.for_each_range(key_t(prefix), key_t(last), [&visited](const key_t& key, std::shared_ptr<std::string>&)
+            {
+                visited.push_back(key.to_string());
+            });
+        expect(visited == expected, "traversal: for_each_range() does not match for [" + prefix + ", " + last + ")");
+    }
+    expect(data.stats().node_count == nodes, "traversal: the traversals modified the trie");
+}
+
+template<std::size_t children_count>
+void test_parallel(trie::work_stealing_pool& pool, std::ostream& output_log)
+{
+    using key_t = trie::basic_key<children_count>;
+    trie::basic_trie<children_count, std::string> data;
+    reference_map<children_count> reference;
+    fill_random(data, reference, 3000, 10, 38);
+
+    output_log << "Running parallel traversal test: " << reference.size() << " keys on " << pool.thread_count() << " threads" << std::endl;
+    std::string expected;
+    for (const auto& pair : reference) expected += pair.second + ",";
+    std::string concatenated = data.parallel_reduce(std::string(), [](const key_t& key, std::shared_ptr<std::string>& value)
+        {
+            if (key.to_string() + "!" != *value) throw std::runtime_error("Error testing parallel traversal: key does not match its value");
+            return *value + ",";
+        }, [](std::string left, std::string right) { return left + right; }, true, pool);
+    expect(concatenated == expected, "parallel traversal: ordered parallel_reduce() does not match the key order");
+    std::size_t counter = data.parallel_reduce(std::size_t(0), [](const key_t&, std::shared_ptr<std::string>&) { return std::size_t(1); },
+        [](std::size_t left, std::size_t right) { return left + right; }, false, pool);
+    expect(counter == reference.size(), "parallel traversal: unordered parallel_reduce() does not count every value");
+
+    std::atomic<std::size_t> visited{ 0 };
+    data.parallel_for_each([&visited](const key_t&, std::shared_ptr<std::string>&) { ++visited; }, pool);
+    expect(visited == reference.size(), "parallel traversal: parallel_for_each() does not visit every value");
+    bool thrown = false;
+    try { data.parallel_for_each([](const key_t&, std::shared_ptr<std::string>&) { throw std::logic_error("visitor failed"); }, pool); }
+    catch (const std::logic_error&) { thrown = true; }
+    expect(thrown, "parallel traversal: the exception of a visitor was not rethrown");
+}
+
+template<std::size_t children_count>
+void test_longest_prefix_match(std::ostream& output_log)
+{
+    using key_t = trie::basic_key<children_count>;
+    trie::basic_trie<children_count, std::string> data;
+    std::mt19937 rng(39 + (unsigned)children_count);
+    // the routes are random element sequences, so on the smaller fan-outs they also end inside of a byte
+    std::vector<key_t> routes;
+    for (std::size_t i = 0; i < 500; i++)
+    {
+        key_t route;
+        for (std::size_t length = rng() % 12; route.size() < length; ) route.push_back((uint8_t)(rng() % std::min<std::size_t>(children_count, 3)));
+        data.insert(route, std::make_shared<std::string>(std::to_string(i)));
+        routes.push_back(route);
+    }
+    std::size_t nodes = data.stats().node_count;
+
+    output_log << "Running longest prefix match test: " << data.size() << " routes" << std::endl;
+    std::vector<typename trie::basic_trie<children_count, std::string>::stride_index> indices;
+    for (std::size_t levels : { 0, 1, 2 }) indices.emplace_back(data, levels);
+    for (std::size_t query = 0; query < 2000; query++)
+    {
+        key_t address;
+        for (std::size_t length = rng() % 16; address.size() < length; ) address.push_back((uint8_t)(rng() % std::min<std::size_t>(children_count, 3)));
+        // every stored route that is a prefix of the address, ordered by length
+        std::map<std::size_t, std::shared_ptr<std::string> > expected;
+        for (const key_t& route : routes)
+        {
+            std::size_t i = 0;
+            for (; i < route.size() && i < address.size() && route.get_element(i) == address.get_element(i); i++);
+            if (i == route.size()) expected[i] = data.at(route);
+        }
+
+        auto prefixes = data.all_prefixes_of(address);
+        expect(prefixes.size() == expected.size(), "longest prefix match: all_prefixes_of() does not find every route");
+        std::size_t i = 0;
+        for (const auto& pair : expected)
+        {
+            expect(prefixes[i].first == pair.first && prefixes[i].second == pair.second, "longest prefix match: all_prefixes_of() does not match");
+            i++;
+        }
+        auto match = data.longest_prefix_match(address);
+        if (expected.empty()) expect(match.second == nullptr, "longest prefix match: found a route for an unrouted address");
+        else expect(match.first == expected.rbegin()->first && match.second == expected.rbegin()->second, "longest prefix match: does not find the longest route");
+        for (const auto& index : indices)
+        {
+            auto indexed = index.longest_prefix_match(address);
+            expect(indexed.first == match.first && indexed.second == match.second, "longest prefix match: stride_index does not match the trie");
+        }
+    }
+    expect(data.stats().node_count == nodes, "longest prefix match: the lookups modified the trie");
+}
+
+template<std::size_t children_count, typename integer_t>
+void test_integer_trie(std::ostream& output_log)
+{
+    trie::integer_trie<children_count, integer_t, std::size_t> data;
+    std::map<integer_t, std::size_t> reference;
+    std::mt19937_64 rng(40 + children_count + sizeof(integer_t));
+    for (std::size_t i = 0; i < 20000; i++)
+    {
+        // small keys around zero cross the sign boundary of signed types and share most of their nodes
+        integer_t key = (rng() % 4 == 0) ? (integer_t)(rng() % 64 - 32) : (integer_t)rng();
+        if (rng() % 3 != 0) expect(data.insert(key, std::make_shared<std::size_t>(i)) == reference.emplace(key, i).second, "integer trie: insert() does not match");
+        else expect(data.erase(key) == (reference.erase(key) != 0), "integer trie: erase() does not match");
+    }
+    data.insert(std::numeric_limits<integer_t>::max(), std::make_shared<std::size_t>(0));
+    data.insert(std::numeric_limits<integer_t>::min(), std::make_shared<std::size_t>(0));
+    reference.emplace(std::numeric_limits<integer_t>::max(), 0);
+    reference.emplace(std::numeric_limits<integer_t>::min(), 0);
+
+    output_log << "Running integer trie test: " << data.size() << " keys of " << sizeof(integer_t) * 8 << " bits"
+        << (std::is_signed<integer_t>::value ? ", signed" : ", unsigned") << std::endl;
+    expect(data.size() == reference.size(), "integer trie: size does not match");
+    auto iter = data.begin();
+    for (const auto& pair : reference)
+    {
+        expect(iter && iter.get_key() == pair.first && *iter.get_data() == pair.second, "integer trie: numerical order does not match");
+        iter++;
+    }
+    expect(iter == data.end(), "integer trie: iterator did not end");
+    for (std::size_t i = 0; i < 2000; i++)
+    {
+        integer_t key = (integer_t)rng();
+        auto bound = data.lower_bound(key);
+        auto expected = reference.lower_bound(key);
+        expect((expected == reference.end()) ? !bound : (bound && bound.get_key() == expected->first), "integer trie: lower_bound() does not match");
+        expect(data.contains(key) == (reference.count(key) != 0), "integer trie: contains() does not match");
+    }
+    expect(++data.lower_bound(std::numeric_limits<integer_t>::max()) == data.end(), "integer trie: iterator did not end after the largest key");
+
+    // a value replaced by a nullptr through at() keeps its key stored until it is erased
+    for (auto pair = reference.begin(); pair != reference.end(); )
+    {
+        data.at(pair->first) = nullptr;
+        expect(data.contains(pair->first) && data.lower_bound(pair->first).get_key() == pair->first, "integer trie: a key without value is not found");
+        expect(!data.insert(pair->first, std::make_shared<std::size_t>(0)), "integer trie: inserted a key that is still stored");
+        if (rng() % 2 == 0)
+        {
+            expect(data.erase(pair->first) && !data.contains(pair->first), "integer trie: erase() of a key without value does not match");
+            pair = reference.erase(pair);
+        }
+        else pair++;
+        expect(data.size() == reference.size(), "integer trie: size does not match after clearing a value");
+    }
+    for (const auto& pair : reference) expect(data.erase(pair.first), "integer trie: erase() of a key without value does not match");
+    expect(data.size() == 0 && data.begin() == data.end(), "integer trie: trie is not empty after erasing every key");
+}
+
+template<std::size_t children_count>
+void test_key_encoder(std::ostream& output_log)
+{
+    using key_t = trie::basic_key<children_count>;
+    using time_point = std::chrono::system_clock::time_point;
+    using row = std::tuple<int32_t, double, std::string, time_point, uint8_t>;
+    trie::basic_trie<children_count, std::size_t> data;
+    std::set<row> reference; // tuples compare column by column, which is the order the encoded keys have to keep
+    std::mt19937 rng(41 + (unsigned)children_count);
+    // strings with embedded zero bytes and prefixes of each other test the string terminator
+    const std::string strings[] = { "", "a", "ab", std::string("a\0b", 3), "b", std::string(1, '\0'), "a\xff", "zz" };
+    auto decode = [](const key_t& key) { return trie::decode_key<int32_t, double, std::string, time_point, uint8_t>(key); };
+    for (std::size_t i = 0; i < 3000; i++)
+    {
+        row current{ (int32_t)(rng() % 21) - 10, ((double)(rng() % 2001) - 1000) / 7.0, strings[rng() % 8],
+            time_point(std::chrono::microseconds((int64_t)(rng() % 100000) - 50000)), (uint8_t)(rng() % 3) };
+        data.insert(trie::encode_key<children_count>(std::get<0>(current), std::get<1>(current), std::get<2>(current), std::get<3>(current), std::get<4>(current)),
+            std::make_shared<std::size_t>(i));
+        reference.insert(current);
+    }
+
+    output_log << "Running key encoder test: " << reference.size() << " composite keys" << std::endl;
+    expect(data.size() == reference.size(), "key encoder: distinct rows got the same key");
+    auto expected = reference.begin();
+    for (auto iter = data.begin(); iter != data.end(); iter++, expected++)
+    {
+        expect(expected != reference.end() && decode(iter.get_key()) == *expected, "key encoder: key order does not match the column order");
+    }
+    expect(expected == reference.end(), "key encoder: iterator ended early");
+
+    std::vector<row> visited, matching;
+    auto collect = [&visited, &decode](const key_t& key, std::shared_ptr<std::size_t>&) { visited.push_back(decode(key)); };
+    for (std::size_t query = 0; query < 50; query++)
+    {
+        int32_t first = (int32_t)(rng() % 25) - 12, last = (int32_t)(rng() % 25) - 12;
+        double low = ((double)(rng() % 400) - 200) / 7.0, high = ((double)(rng() % 400) - 200) / 7.0;
+        visited.clear();
+        matching.clear();
+        data.for_each_range(trie::encode_key<children_count>(first), trie::encode_key<children_count>(last), collect);
+        for (const row& current : reference) if (std::get<0>(current) >= first && std::get<0>(current) < last) matching.push_back(current);
+        expect(visited == matching, "key encoder: range over the first column does not match");
+
+        visited.clear();
+        matching.clear();
+        data.for_each_range(trie::encode_key<children_count>(first, low), trie::encode_key<children_count>(first, high), collect);
+        for (const row& current : reference)
+        {
+            if (std::get<0>(current) == first && std::get<1>(current) >= low && std::get<1>(current) < high) matching.push_back(current);
+        }
+        expect(visited == matching, "key encoder: range over the second column does not match");
+
+        visited.clear();
+        matching.clear();
+        trie::key_encoder prefix;
+        prefix.add(first).add(low).add_prefix("a");
+        data.for_each(prefix.key<children_count>(), collect);
+        for (const row& current : reference)
+        {
+            if (std::get<0>(current) == first && std::get<1>(current) == low && std::get<2>(current).compare(0, 1, "a") == 0) matching.push_back(current);
+        }
+        expect(visited == matching, "key encoder: string prefix does not match");
+    }
+
+    const double doubles[] = { -std::numeric_limits<double>::infinity(), -1e300, -1.5, -0.0, 1e-300, 2.5, std::numeric_limits<double>::infinity() };
+    for (std::size_t i = 1; i < sizeof(doubles) / sizeof(doubles[0]); i++)
+    {
+        trie::key_encoder left, right;
+        left.add(doubles[i - 1]);
+        right.add(doubles[i]);
+        expect(left.bytes() < right.bytes() && trie::key_decoder(right.bytes()).read<double>() == doubles[i], "key encoder: doubles are not ordered");
+    }
+    const int64_t integers[] = { std::numeric_limits<int64_t>::min(), -5, -1, 0, 1, std::numeric_limits<int64_t>::max() };
+    for (std::size_t i = 1; i < sizeof(integers) / sizeof(integers[0]); i++)
+    {
+        trie::key_encoder left, right;
+        left.add(integers[i - 1]);
+        right.add(integers[i]);
+        expect(left.bytes() < right.bytes() && trie::key_decoder(right.bytes()).read<int64_t>() == integers[i], "key encoder: integers are not ordered");
+    }
+    bool thrown = false;
+    try { trie::key_decoder(std::string("\x80", 1)).read<int32_t>(); }
+    catch (const std::out_of_range&) { thrown = true; }
+    expect(thrown, "key encoder: reading past the end of a key did not throw");
+}
+
+void test_aho_corasick(std::ostream& output_log)
+{
+    using match = std::tuple<std::size_t, std::size_t, std::string>; // end, length, value
+    std::mt19937 rng(42);
+    std::size_t matches = 0;
+    for (std::size_t round = 0; round < 50; round++)
+    {
+        trie::trie256<std::string> data;
+        std::vector<std::string> patterns;
+        std::size_t alphabet = 2 + rng() % 4;
+        // keys are prefixes and suffixes of each other and contain zero bytes, the empty key is not matched
+        for (std::size_t i = 1 + rng() % 30; i > 0; i--)
+        {
+            std::string key;
+            for (std::size_t length = rng() % 6; key.size() < length; ) key.push_back((key.size() % 2 == 1 && rng() % 5 == 0) ? '\0' : (char)('a' + rng() % alphabet));
+            if (data.insert(trie::key256(key.data(), key.size()), std::make_shared<std::string>(key)) && !key.empty()) patterns.push_back(key);
+        }
+        trie::aho_corasick<std::string> automaton(data);
+        expect(automaton.size() == patterns.size(), "aho-corasick: number of keys does not match");
+
+        std::string text;
+        for (std::size_t length = rng() % 500; text.size() < length; ) text.push_back((rng() % 7 == 0) ? '\0' : (rng() % 9 == 0) ? 'z' : (char)('a' + rng() % alphabet));
+        std::vector<match> expected, found, scanned;
+        for (std::size_t end = 1; end <= text.size(); end++)
+        {
+            std::vector<std::string> ending;
+            for (const std::string& pattern : patterns)
+            {
+                if (pattern.size() <= end && text.compare(end - pattern.size(), pattern.size(), pattern) == 0) ending.push_back(pattern);
+            }
+            std::sort(ending.begin(), ending.end(), [](const std::string& left, const std::string& right) { return left.size() > right.size(); });
+            for (const std::string& pattern : ending) expected.emplace_back(end, pattern.size(), pattern);
+        }
+
+        // the text is fed in buffers of random size, so the matches cross the buffer boundaries
+        trie::aho_corasick<std::string>::stream stream(automaton);
+        for (std::size_t position = 0; position < text.size(); )
+        {
+            std::size_t length = std::min<std::size_t>(rng() % 7, text.size() - position);
+            stream.feed(text.data() + position, length, [&found](std::size_t end, std::size_t length, const std::shared_ptr<std::string>& value)
+                {
+                    found.emplace_back(end, length, *value);
+                });
+            position += length;
+        }
+        expect(stream.position() == text.size(), "aho-corasick: stream position does not match");
+        expect(found == expected, "aho-corasick: matches across buffer boundaries do not match");
+        automaton.scan(text, [&scanned](std::size_t end, std::size_t length, const std::shared_ptr<std::string>& value) { scanned.emplace_back(end, length, *value); });
+        expect(scanned == expected, "aho-corasick: matches of a single buffer do not match");
+        matches += expected.size();
+    }
+    output_log << "Running aho-corasick test: " << matches << " matches found" << std::endl;
+}
+
+/**
+ * @brief Levenshtein distance between two symbol sequences, computed with the full table as reference for the trie search
+ */
+std::size_t edit_distance(const std::vector<uint32_t>& left, const std::vector<uint32_t>& right)
+{
+    std::vector<std::size_t> previous(right.size() + 1), current(right.size() + 1);
+    for (std::size_t j = 0; j <= right.size(); j++) previous[j] = j;
+    for (std::size_t i = 1; i <= left.size(); i++)
+    {
+        current[0] = i;
+        for (std::size_t j = 1; j <= right.size(); j++)
+        {
+            current[j] = std::min({ previous[j] + 1, current[j - 1] + 1, previous[j - 1] + (left[i - 1] != right[j - 1] ? 1 : 0) });
+        }
+        std::swap(previous, current);
+    }
+    return previous[right.size()];
+}
+
+template<std::size_t children_count>
+void test_fuzzy_search(bool utf8, std::ostream& output_log)
+{
+    using key_t = trie::basic_key<children_count>;
+    // the symbols of a key: its key elements, or the code points of valid UTF-8
+    auto symbols = [utf8](const std::string& text)
+    {
+        std::vector<uint32_t> result;
+        key_t key(text);
+        for (std::size_t i = 0; !utf8 && i < key.size(); i++) result.push_back(key.get_element(i));
+        for (std::size_t i = 0; utf8 && i < text.size(); )
+        {
+            unsigned char lead = (unsigned char)text[i];
+            std::size_t length = (lead < 0x80) ? 1 : (lead < 0xE0) ? 2 : (lead < 0xF0) ? 3 : 4;
+            uint32_t code_point = (length == 1) ? lead : (lead & (0x7F >> length));
+            for (std::size_t j = 1; j < length; j++) code_point = (code_point << 6) | ((unsigned char)text[i + j] & 0x3F);
+            result.push_back(code_point);
+            i += length;
+        }
+        return result;
+    };
+    const char* alphabet[] = { "a", "b", "c", "\xC3\xA4", "\xE2\x82\xAC", "\xF0\x9F\x98\x80" };
+    std::mt19937 rng(43 + (unsigned)children_count + (utf8 ? 1 : 0));
+    std::size_t matches = 0;
+    for (std::size_t round = 0; round < 30; round++)
+    {
+        trie::basic_trie<children_count, std::string> data;
+        reference_map<children_count> reference;
+        for (std::size_t i = 0; i < 150; i++)
+        {
+            std::string key;
+            for (std::size_t length = rng() % 6; length > 0; length--) key += alphabet[rng() % (utf8 ? 6 : 3)];
+            data.insert(key_t(key), std::make_shared<std::string>(key));
+            reference.emplace(key, key);
+        }
+        std::size_t nodes = data.stats().node_count;
+        for (std::size_t query = 0; query < 30; query++)
+        {
+            std::string text;
+            for (std::size_t length = rng() % 6; length > 0; length--) text += alphabet[rng() % (utf8 ? 6 : 3)];
+            std::size_t bound = rng() % 4;
+            // ordered by distance, then by key
+            std::vector<std::pair<std::size_t, std::string> > expected;
+            for (const auto& pair : reference)
+            {
+                std::size_t distance = edit_distance(symbols(pair.first), symbols(text));
+                if (distance <= bound) expected.emplace_back(distance, pair.first);
+            }
+            std::stable_sort(expected.begin(), expected.end(), [](const auto& left, const auto& right) { return left.first < right.first; });
+
+            auto found = data.fuzzy_search(key_t(text), bound, utf8);
+            expect(found.size() == expected.size(), "fuzzy search: number of matches does not match for [" + text + "]");
+            for (std::size_t i = 0; i < found.size(); i++)
+            {
+                expect(found[i].distance == expected[i].first && found[i].key.to_string() == expected[i].second && *found[i].data == expected[i].second,
+                    "fuzzy search: match does not match for [" + text + "]");
+            }
+            matches += found.size();
+        }
+        expect(data.stats().node_count == nodes, "fuzzy search: the search modified the trie");
+    }
+    output_log << "Running fuzzy search test" << (utf8 ? " (UTF-8)" : "") << ": " << matches << " matches found" << std::endl;
+    if (children_count == 256) return;
+    bool thrown = false;
+    try { trie::basic_trie<children_count, std::string>().fuzzy_search(key_t("a"), 1, true); }
+    catch (const std::invalid_argument&) { thrown = true; }
+    expect(thrown, "fuzzy search: UTF-8 symbols were accepted for a trie with less than 256 children");
+}
+
+template<std::size_t children_count>
+void test_scored_trie(std::ostream& output_log)
+{
+    using key_t = trie::basic_key<children_count>;
+    trie::scored_trie<children_count, std::string, int> data;
+    std::map<std::string, int, key_order<children_count> > reference; // key -> score
+    std::mt19937 rng(44 + (unsigned)children_count);
+    std::size_t completions = 0;
+    // completions are checked between inserts, erases and score updates, so the cached subtree scores have to follow every change
+    for (std::size_t i = 0; i < 20000; i++)
+    {
+        std::string key;
+        for (std::size_t length = rng() % 5; key.size() < length; ) key.push_back("aeiLR.?"[rng() % 7]);
+        int score = (int)(rng() % 10);
+        switch (rng() % 4)
+        {
+        case 0:
+            expect(data.insert(key_t(key), std::make_shared<std::string>(key), score) == reference.emplace(key, score).second, "scored trie: insert() does not match at [" + key + "]");
+            break;
+        case 1:
+            expect(data.erase(key_t(key)) == (reference.erase(key) != 0), "scored trie: erase() does not match at [" + key + "]");
+            break;
+        case 2:
+            expect(data.update_score(key_t(key), score) == (reference.count(key) != 0), "scored trie: update_score() does not match at [" + key + "]");
+            if (reference.count(key) != 0) reference[key] = score;
+            break;
+        default:
+        {
+            std::string prefix = key.substr(0, rng() % (key.size() + 1));
+            std::size_t k = rng() % 6;
+            // ordered by score from best to worst, then by key
+            std::vector<std::pair<int, std::string> > expected;
+            for (const auto& pair : reference)
+            {
+                if (pair.first.compare(0, prefix.size(), prefix) == 0) expected.emplace_back(pair.second, pair.first);
+            }
+            std::stable_sort(expected.begin(), expected.end(), [](const auto& left, const auto& right) { return left.first > right.first; });
+            if (expected.size() > k) expected.resize(k);
+            auto found = data.complete(key_t(prefix), k);
+            expect(found.size() == expected.size(), "scored trie: number of completions does not match for [" + prefix + "]");
+            for (std::size_t j = 0; j < found.size(); j++)
+            {
+                expect(found[j].score == expected[j].first && found[j].key.to_string() == expected[j].second && *found[j].data == expected[j].second,
+                    "scored trie: completion does not match for [" + prefix + "]");
+            }
+            completions += found.size();
+            break;
+        }
+        }
+        expect(data.size() == reference.size(), "scored trie: size does not match");
+    }
+    for (const auto& pair : reference) expect(data.score(key_t(pair.first)) == pair.second, "scored trie: score() does not match at [" + pair.first + "]");
+    output_log << "Running scored trie test: " << completions << " completions checked" << std::endl;
+}
+
+/**
+ * @brief match a glob with only '*' and '?' by backtracking, as reference for the glob automaton
+ */
+bool glob_matches(const std::string& pattern, std::size_t i, const std::string& text, std::size_t j)
+{
+    if (i == pattern.size()) return j == text.size();
+    if (pattern[i] == '*') return glob_matches(pattern, i + 1, text, j) || (j < text.size() && glob_matches(pattern, i, text, j + 1));
+    if (j == text.size()) return false;
+    return (pattern[i] == '?' || pattern[i] == text[j]) && glob_matches(pattern, i + 1, text, j + 1);
+}
+
+template<std::size_t children_count>
+void test_key_pattern(std::ostream& output_log)
+{
+    using key_t = trie::basic_key<children_count>;
+    const char* expressions[] = { "^btn_(ok|cancel)_[0-9]+$", "a.b", "^a*$", "b{2,3}", "^(ab|ba)+c?$", "[^a-c]", "x|^b", "^\\d\\w?$", "a$|^c", "^$", "(a|b)*c{1}", "^[a-c]{0,2}$" };
+    const char* globs[] = { "menu.*.title", "a*b", "*", "?", "a?c*", "*_ok", "b*a*" };
+    const char* fragments[] = { "a", "b", "c", "_", "ok", "cancel", "btn_", "1", "23", "x", "menu.", ".title", "file" };
+    std::mt19937 rng(45 + (unsigned)children_count);
+    std::size_t matches = 0;
+    for (std::size_t round = 0; round < 10; round++)
+    {
+        trie::basic_trie<children_count, std::string> data;
+        reference_map<children_count> reference;
+        for (std::size_t i = 0; i < 400; i++)
+        {
+            std::string key;
+            for (std::size_t length = rng() % 5; length > 0; length--) key += fragments[rng() % 13];
+            data.insert(key_t(key), std::make_shared<std::string>(key));
+            reference.emplace(key, key);
+        }
+        std::vector<std::string> found, expected;
+        auto collect = [&found](const key_t& key, std::shared_ptr<std::string>& value)
+        {
+            if (key.to_string() != *value) throw std::runtime_error("Error testing key pattern: key does not match its value");
+            found.push_back(*value);
+        };
+        for (const char* expression : expressions)
+        {
+            std::regex reference_expression(expression);
+            found.clear();
+            expected.clear();
+            data.for_each_match(trie::key_pattern::regex(expression), collect);
+            for (const auto& pair : reference) if (std::regex_search(pair.first, reference_expression)) expected.push_back(pair.first);
+            expect(found == expected, std::string("key pattern: regex matches do not match std::regex for [") + expression + "]");
+            matches += found.size();
+        }
+        for (const char* glob : globs)
+        {
+            found.clear();
+            expected.clear();
+            data.for_each_match(trie::key_pattern::glob(glob), collect);
+            for (const auto& pair : reference) if (glob_matches(glob, 0, pair.first, 0)) expected.push_back(pair.first);
+            expect(found == expected, std::string("key pattern: glob matches do not match for [") + glob + "]");
+            matches += found.size();
+        }
+    }
+    output_log << "Running key pattern test: " << matches << " matches found" << std::endl;
+
+    for (const char* invalid : { "(a", "a)", "[a", "*a", "a{3,1}", "\\" })
+    {
+        bool thrown = false;
+        try { trie::key_pattern::regex(invalid); }
+        catch (const std::invalid_argument&) { thrown = true; }
+        expect(thrown, std::string("key pattern: invalid regex was accepted [") + invalid + "]");
+    }
+    expect(trie::key_pattern::glob("[!a-c]x").matches("dx") && !trie::key_pattern::glob("[!a-c]x").matches("bx"), "key pattern: negated glob class does not match");
+}
+
+/**
+ * @brief get all keys and values of a trie in iteration order, as "key=value"
+ */
+template<std::size_t children_count>
+std::vector<std::string> pairs_of(trie::basic_trie<children_count, std::string>& data)
+{
+    std::vector<std::string> result;
+    for (auto iter = data.begin(); iter != data.end(); iter++) result.push_back(iter.get_key().to_string() + "=" + *iter.get_data());
+    return result;
+}
+
+template<std::size_t children_count>
+void test_set_operations(std::ostream& output_log)
+{
+    using key_t = trie::basic_key<children_count>;
+    std::mt19937 rng(46 + (unsigned)children_count);
+    std::size_t checked = 0;
+    for (std::size_t round = 0; round < 100; round++)
+    {
+        trie::basic_trie<children_count, std::string> left, right;
+        reference_map<children_count> left_reference, right_reference;
+        for (std::size_t i = rng() % 60; i > 0; i--)
+        {
+            std::string key;
+            for (std::size_t length = rng() % 6; key.size() < length; ) key.push_back("aeiLR.?"[rng() % 7]);
+            bool both = rng() % 4 == 0;
+            if (both || rng() % 2 == 0)
+            {
+                left.insert(key_t(key), std::make_shared<std::string>("L" + key));
+                left_reference.emplace(key, "L" + key);
+            }
+            if (both || rng() % 2 == 0)
+            {
+                right.insert(key_t(key), std::make_shared<std::string>("R" + key));
+                right_reference.emplace(key, "R" + key);
+            }
+        }
+        std::size_t left_nodes = left.stats().node_count, right_nodes = right.stats().node_count;
+        // the data of the left trie wins for keys stored in both
+        std::vector<std::string> united, common, difference, visited;
+        reference_map<children_count> all = left_reference;
+        all.insert(right_reference.begin(), right_reference.end());
+        for (const auto& pair : all)
+        {
+            bool in_right = right_reference.count(pair.first) != 0;
+            united.push_back(pair.first + "=" + pair.second);
+            if (left_reference.count(pair.first) != 0) (in_right ? common : difference).push_back(pair.first + "=" + pair.second);
+        }
+
+        trie::basic_trie<children_count, std::string> result = left.set_union(right);
+        expect(pairs_of(result) == united, "set operations: set_union() does not match");
+        result = left.set_intersection(right);
+        expect(pairs_of(result) == common, "set operations: set_intersection() does not match");
+        result = left.set_difference(right);
+        expect(pairs_of(result) == difference, "set operations: set_difference() does not match");
+        left.set_union(right, [&](const key_t& key, std::shared_ptr<std::string>& first, std::shared_ptr<std::string>& second)
+            {
+                if ((first != nullptr) != (left_reference.count(key.to_string()) != 0) || (second != nullptr) != (right_reference.count(key.to_string()) != 0))
+                {
+                    throw std::runtime_error("Error testing set operations: set_union() visitor got the wrong data");
+                }
+                visited.push_back(key.to_string() + "=" + *(first != nullptr ? first : second));
+            });
+        expect(visited == united, "set operations: set_union() visitor does not match");
+        std::size_t counter = 0;
+        bool completed = left.set_union(right, [&counter](const key_t&, std::shared_ptr<std::string>&, std::shared_ptr<std::string>&)
+            {
+                return (++counter == 2) ? trie::visit_result::stop : trie::visit_result::proceed;
+            });
+        expect(counter == std::min<std::size_t>(2, united.size()) && completed == (united.size() < 2), "set operations: stop does not end the walk");
+        expect(left.stats().node_count == left_nodes && right.stats().node_count == right_nodes, "set operations: the source tries were modified");
+        checked += united.size();
+    }
+    output_log << "Running set operations test: " << checked << " keys checked" << std::endl;
+}
+
+template<std::size_t children_count>
+void test_diff(std::ostream& output_log)
+{
+    using key_t = trie::basic_key<children_count>;
+    using change = std::pair<std::string, trie::diff_kind>;
+    std::mt19937 rng(47 + (unsigned)children_count);
+    std::size_t changes = 0;
+    for (std::size_t round = 0; round < 200; round++)
+    {
+        trie::basic_trie<children_count, std::string> older, newer;
+        std::map<std::string, std::shared_ptr<std::string>, key_order<children_count> > older_reference, newer_reference;
+        for (std::size_t i = rng() % 60; i > 0; i--)
+        {
+            std::string key;
+            for (std::size_t length = rng() % 5; key.size() < length; ) key.push_back("aeiLR.?"[rng() % 7]);
+            std::shared_ptr<std::string> value = std::make_shared<std::string>(key);
+            if (older_reference.emplace(key, value).second) older.insert(key_t(key), value);
+        }
+        // the newer version drops some keys, replaces the data of some keys and adds new keys
+        for (const auto& pair : older_reference)
+        {
+            std::size_t action = rng() % 6;
+            if (action == 0) continue;
+            std::shared_ptr<std::string> value = (action == 1) ? std::make_shared<std::string>(pair.first) : pair.second;
+            newer_reference.emplace(pair.first, value);
+            newer.insert(key_t(pair.first), value);
+        }
+        for (std::size_t i = 0; i < 5; i++)
+        {
+            std::string key;
+            for (std::size_t length = rng() % 5; key.size() < length; ) key.push_back("aeiLR.?"[rng() % 7]);
+            std::shared_ptr<std::string> value = std::make_shared<std::string>(key);
+            if (newer_reference.emplace(key, value).second) newer.insert(key_t(key), value);
+        }
+
+        std::map<std::string, trie::diff_kind, key_order<children_count> > changed;
+        for (const auto& pair : older_reference)
+        {
+            auto found = newer_reference.find(pair.first);
+            if (found == newer_reference.end()) changed.emplace(pair.first, trie::diff_kind::removed);
+            else if (found->second != pair.second) changed.emplace(pair.first, trie::diff_kind::changed);
+        }
+        for (const auto& pair : newer_reference)
+        {
+            if (older_reference.count(pair.first) == 0) changed.emplace(pair.first, trie::diff_kind::added);
+        }
+        std::vector<change> expected(changed.begin(), changed.end()), found;
+        trie::diff(older, newer, [&found](const key_t& key, trie::diff_kind kind, std::shared_ptr<std::string>& old_data, std::shared_ptr<std::string>& new_data)
+            {
+                if ((kind == trie::diff_kind::added) != (old_data == nullptr) || (kind == trie::diff_kind::removed) != (new_data == nullptr))
+                {
+                    throw std::runtime_error("Error testing diff: data pointers do not match the kind of the change");
+                }
+                found.emplace_back(key.to_string(), kind);
+            });
+        expect(found == expected, "diff: changes do not match");
+        std::size_t unchanged = 0;
+        older.diff(older, [&unchanged](const key_t&, trie::diff_kind, std::shared_ptr<std::string>&, std::shared_ptr<std::string>&) { unchanged++; });
+        expect(unchanged == 0, "diff: a trie differs from itself");
+        changes += expected.size();
+    }
+    output_log << "Running diff test: " << changes << " changes found" << std::endl;
+}
+
+template<std::size_t children_count>
+void test_filter(std::ostream& output_log)
+{
+    using key_t = trie::basic_key<children_count>;
+    std::mt19937 rng(48 + (unsigned)children_count);
+    auto random_key = [&rng]()
+    {
+        std::string key;
+        for (std::size_t length = rng() % 6; key.size() < length; ) key.push_back("aeiLR.?"[rng() % 7]);
+        return key_t(key);
+    };
+    std::size_t lookups = 0;
+    for (std::size_t round = 0; round < 150; round++)
+    {
+        // the filtered trie and the unfiltered reference trie get the same operations, a filter must never hide a stored key
+        trie::basic_trie<children_count, int> data, reference;
+        std::vector<std::size_t> prefix_lengths;
+        for (std::size_t i = rng() % 3; i > 0; i--) prefix_lengths.push_back(rng() % 12);
+        std::sort(prefix_lengths.begin(), prefix_lengths.end());
+        if (round % 2 == 1) data.enable_filter(4.0 + (double)(rng() % 10), prefix_lengths);
+        for (std::size_t step = 0; step < 200; step++)
+        {
+            key_t key = random_key();
+            if (step == 100 && !data.has_filter()) data.enable_filter(8.0, prefix_lengths);
+            if (step == 150) data.rebuild_filter();
+            switch (rng() % 10)
+            {
+            case 0: case 1: case 2:
+            {
+                std::shared_ptr<int> value = std::make_shared<int>((int)step);
+                expect(data.insert(key, value) == reference.insert(key, value), "filter: insert() does not match");
+                break;
+            }
+            case 3:
+                if (key.size() > 0) expect(data.erase(key) == reference.erase(key), "filter: erase() does not match");
+                break;
+            case 4:
+                data[key] = reference[key] = std::make_shared<int>(-(int)step);
+                break;
+            case 5:
+            {
+                std::vector<key_t> keys;
+                for (std::size_t i = 0; i < 8; i++) keys.push_back(random_key());
+                std::vector<std::shared_ptr<int> > found = data.find_batch(keys);
+                for (std::size_t i = 0; i < keys.size(); i++) expect(found[i] == reference.find(keys[i]), "filter: find_batch() does not match");
+                break;
+            }
+            case 6:
+                // a value stored through the reference returned by at() bypasses the filter
+                if (data.has_node(key) && data.at(key) == nullptr) data.at(key) = reference[key] = std::make_shared<int>(1000 + (int)step);
+                break;
+            case 7:
+            {
+                // values stored through a subtrie and through a node iterator bypass the filter as well
+                key_t prefix, rest;
+                for (std::size_t i = 0; i < key.size(); i++) (i < 1 ? prefix : rest).push_back(key.get_element(i));
+                if (data.has_node(prefix))
+                {
+                    trie::basic_trie<children_count, int> part = data.subtrie(prefix);
+                    std::shared_ptr<int> value = std::make_shared<int>(2000 + (int)step);
+                    expect(part.insert(rest, value) == reference.insert(key, value), "filter: insert() into a subtrie does not match");
+                }
+                for (auto iter = data.node_begin(); iter != data.node_end(); iter++)
+                {
+                    if (iter.get_data() != nullptr || rng() % 4 != 0) continue;
+                    iter.get_data() = reference[iter.get_key()] = std::make_shared<int>(3000 + (int)step);
+                    break;
+                }
+                break;
+            }
+            default:
+                expect(data.has_node(key) == reference.has_node(key), "filter: has_node() does not match");
+                expect(data.find(key) == reference.find(key), "filter: find() does not match");
+                break;
+            }
+        }
+        if (round == 10)
+        {
+            trie::basic_trie<children_count, int> source, copy;
+            source.insert(key_t("Le"), std::make_shared<int>(1));
+            copy.insert(key_t("Le"), source.find(key_t("Le")));
+            data.merge(source);
+            reference.merge(copy);
+        }
+        for (std::size_t i = 0; i < 200; i++, lookups++)
+        {
+            key_t key = random_key();
+            expect(data.has_node(key) == reference.has_node(key) && data.find(key) == reference.find(key), "filter: lookup after the updates does not match");
+        }
+    }
+    output_log << "Running filter test: " << lookups << " lookups checked" << std::endl;
+}
+
+template<std::size_t children_count>
+void test_compact(std::ostream& output_log)
+{
+    using key_t = trie::basic_key<children_count>;
+    std::mt19937 rng(49 + (unsigned)children_count);
+    for (std::size_t round = 0; round < 100; round++)
+    {
+        trie::basic_trie<children_count, std::string> data;
+        reference_map<children_count> reference;
+        fill_random(data, reference, rng() % 300, 8, 49 + (unsigned)round);
+        auto stats = data.stats();
+        std::vector<std::string> expected = pairs_of(data);
+        if (round % 2 == 0)
+        {
+            data.compact(rng() % 20000);
+        }
+        else
+        {
+            trie::background_reclaimer reclaimer;
+            data.compact(reclaimer, rng() % 20000);
+            reclaimer.drain();
+        }
+        auto compacted = data.stats();
+        expect(pairs_of(data) == expected, "compact: keys or values changed");
+        expect(compacted.node_count == stats.node_count && compacted.tail_count == stats.tail_count, "compact: the trie shape changed");
+        expect(compacted.arena_bytes >= compacted.node_bytes / 2, "compact: the nodes were not moved into an arena");
+
+        // arena nodes and heap nodes are mixed by the updates after the compaction
+        for (std::size_t i = 0; i < 100; i++)
+        {
+            std::string key;
+            for (std::size_t length = rng() % 8; key.size() < length; ) key.push_back("aeiLR.?"[rng() % 7]);
+            if (rng() % 2 == 0)
+            {
+                data.insert(key_t(key), std::make_shared<std::string>(key + "!"));
+                reference.emplace(key, key + "!");
+            }
+            else if (!key.empty())
+            {
+                // erasing a key also erases all keys below it
+                data.erase(key_t(key));
+                for (auto iter = reference.lower_bound(key); iter != reference.end() && iter->first.compare(0, key.size(), key) == 0; ) iter = reference.erase(iter);
+            }
+        }
+        expected.clear();
+        for (const auto& pair : reference) expected.push_back(pair.first + "=" + pair.second);
+        expect(pairs_of(data) == expected, "compact: updates after the compaction do not match");
+        data.compact();
+        expect(pairs_of(data) == expected, "compact: a second compaction changed the keys");
+    }
+    output_log << "Running compact test" << std::endl;
+}
+
+template<std::size_t children_count>
+void test_huge_pages(std::ostream& output_log)
+{
+    using page_mode = trie::node_arena::page_mode;
+    std::mt19937 rng(50 + (unsigned)children_count);
+    for (page_mode mode : { page_mode::normal, page_mode::transparent_huge, page_mode::explicit_huge })
+    {
+        // every allocation has to be aligned and must not overlap the previous one of the same chunk
+        {
+            trie::node_arena arena(rng() % 10000, mode);
+            char* last_end = nullptr;
+            std::size_t last_chunks = 0;
+            for (std::size_t i = 0; i < 2000; i++)
+            {
+                std::size_t bytes = rng() % 700 + 1, alignment = std::size_t(1) << (rng() % 5);
+                char* address = static_cast<char*>(arena.allocate(bytes, alignment));
+                expect(reinterpret_cast<std::uintptr_t>(address) % alignment == 0, "huge pages: an arena allocation is not aligned");
+                expect(arena.chunk_count() != last_chunks || address >= last_end, "huge pages: arena allocations overlap");
+                std::fill(address, address + bytes, (char)i);
+                last_end = address + bytes;
+                last_chunks = arena.chunk_count();
+            }
+            std::size_t backed = arena.backed_bytes(page_mode::normal) + arena.backed_bytes(page_mode::transparent_huge) + arena.backed_bytes(page_mode::explicit_huge);
+            expect(backed == arena.memory_usage(), "huge pages: the backed bytes do not add up to the arena memory");
+            expect(arena.promoted_bytes() <= arena.memory_usage(), "huge pages: more bytes promoted than the arena holds");
+            expect(mode == page_mode::normal || arena.memory_usage() % trie::node_arena::huge_page_size == 0, "huge pages: a mapped chunk is not rounded to huge pages");
+        }
+
+        trie::basic_trie<children_count, std::string> data;
+        reference_map<children_count> reference;
+        fill_random(data, reference, 2000, 10, 50 + (unsigned)mode);
+        std::vector<std::string> expected = pairs_of(data);
+        data.compact(rng() % 20000, mode);
+        auto stats = data.stats();
+        expect(pairs_of(data) == expected, "huge pages: keys or values changed by the compaction");
+        expect(stats.arena_bytes > 0 && stats.huge_page_bytes <= stats.arena_bytes, "huge pages: wrong arena statistics");
+        for (const auto& pair : reference)
+        {
+            auto value = data.find(trie::basic_key<children_count>(pair.first));
+            expect(value != nullptr && *value == pair.second, "huge pages: find() after the compaction: " + pair.first);
+        }
+    }
+    output_log << "Running huge pages test" << std::endl;
+}
+
 std::string limit_string(std::string input, std::size_t limit)
 {
     return input.substr(0, std::min(input.length() - 1, limit));
@@ -82,15 +1366,10 @@ void test_trie(trie::basic_trie<children_count, std::string>& data, std::ostream
 {
     std::size_t pairs = 0, nodes = 0;
     std::size_t counter_forward_iterator, counter_reverse_iterator;
-    std::ifstream ifile("../../../test_data.txt");
-
-    if (!ifile)
-    {
-        throw std::runtime_error("Error opening file");
-    }
-
-    read_test_file(ifile, data);
-    output_log << std::endl;
+    // the file is parsed on a second thread while the parsed pairs are inserted
+    pairs = trie::load_kv_file("../../../test_data.txt", data, true);
+    output_log << "read " << pairs << " pairs from input file" << std::endl;
+    print_stats(data, output_log);
 
     for (auto iter = data.node_begin(); iter != data.node_end(); iter++)
     {
@@ -17,52 +17,6 @@
 #include "trie.hpp"
 #include "test_trie.hpp"
 
-template<std::size_t children_count>
-void read_test_file(std::istream& input, trie::basic_trie<children_count, std::string>& output)
-{
-    std::string stringbuffer, key, value;
-    std::size_t index, length, line_number = 0, pair_count = 0;
-    bool valid_line;
-    // read everything from the istream
-    while(!input.eof())
-    {
-        // get one line at the time
-        // the lines can be taken from a *.json file, with the a format like `*"key"*:*"value*"*`
-        std::getline(input, stringbuffer);
-        std::cout << "reading file line #" << ++line_number << "\r";
-        valid_line = false;
-
-        // read key string
-        index = stringbuffer.find('\"');
-        if (index < stringbuffer.size())
-        {
-            stringbuffer = stringbuffer.substr(index + 1, stringbuffer.size() - 1);
-            length = stringbuffer.find('\"');
-            if (length < stringbuffer.size())
-            {
-                key = stringbuffer.substr(0, length);
-                stringbuffer = stringbuffer.substr(length + 1, stringbuffer.size() - 1);
-
-                // read value string
-                index = stringbuffer.find('\"');
-                if (index < stringbuffer.size())
-                {
-                    stringbuffer = stringbuffer.substr(index + 1, stringbuffer.size() - 1);
-                    length = stringbuffer.find('\"');
-                    if (length < stringbuffer.size())
-                    {
-                        value = stringbuffer.substr(0, length);
-
-                        output.insert(key, std::make_shared<std::string>(value));
-                        pair_count++;
-                    }
-                }
-            }
-        }
-    }
-    std::cout << "\nread " << pair_count << " pairs from input file" << std::endl;
-}
-
 int main()
 {
     //std::ofstream logfile("latest.log", std::ios::binary);
@@ -92,6 +46,148 @@ int main()
 
 
 
+    std::cout << std::endl << "Testing succinct trie" << std::endl
+        << "================================" << std::endl;
+    test_succinct_trie<256>(output);
+    test_succinct_trie<16>(output);
+    test_succinct_trie<4>(output);
+    test_succinct_trie<2>(output);
+
+    std::cout << std::endl << "Testing double-array trie" << std::endl
+        << "================================" << std::endl;
+    test_double_array_trie(output);
+
+    std::cout << std::endl << "Testing node tails" << std::endl
+        << "================================" << std::endl;
+    test_tails<256>(output);
+    test_tails<16>(output);
+    test_tails<4>(output);
+    test_tails<2>(output);
+
+    std::cout << std::endl << "Testing dawg" << std::endl
+        << "================================" << std::endl;
+    test_dawg<256>(output);
+    test_dawg<16>(output);
+    test_dawg<4>(output);
+    test_dawg<2>(output);
+
+    std::cout << std::endl << "Testing hat trie" << std::endl
+        << "================================" << std::endl;
+    test_hat_trie<256>(output);
+    test_hat_trie<16>(output);
+    test_hat_trie<4>(output);
+    test_hat_trie<2>(output);
+
+    std::cout << std::endl << "Testing kv loader" << std::endl
+        << "================================" << std::endl;
+    test_kv_loader(output);
+
+    std::cout << std::endl << "Testing destruction" << std::endl
+        << "================================" << std::endl;
+    test_destruction(output);
+
+    std::cout << std::endl << "Testing traversal" << std::endl
+        << "================================" << std::endl;
+    test_traversal<256>(output);
+    test_traversal<16>(output);
+    test_traversal<4>(output);
+    test_traversal<2>(output);
+
+    std::cout << std::endl << "Testing parallel traversal" << std::endl
+        << "================================" << std::endl;
+    trie::work_stealing_pool pool(3), single(1);
+    test_parallel<256>(pool, output);
+    test_parallel<16>(pool, output);
+    test_parallel<4>(pool, output);
+    test_parallel<2>(pool, output);
+    test_parallel<16>(single, output);
+
+    std::cout << std::endl << "Testing longest prefix match" << std::endl
+        << "================================" << std::endl;
+    test_longest_prefix_match<256>(output);
+    test_longest_prefix_match<16>(output);
+    test_longest_prefix_match<4>(output);
+    test_longest_prefix_match<2>(output);
+
+    std::cout << std::endl << "Testing integer trie" << std::endl
+        << "================================" << std::endl;
+    test_integer_trie<256, uint32_t>(output);
+    test_integer_trie<16, int32_t>(output);
+    test_integer_trie<4, uint64_t>(output);
+    test_integer_trie<2, int64_t>(output);
+    test_integer_trie<256, int8_t>(output);
+    test_integer_trie<2, uint16_t>(output);
+
+    std::cout << std::endl << "Testing key encoder" << std::endl
+        << "================================" << std::endl;
+    test_key_encoder<256>(output);
+    test_key_encoder<16>(output);
+    test_key_encoder<4>(output);
+    test_key_encoder<2>(output);
+
+    std::cout << std::endl << "Testing aho-corasick" << std::endl
+        << "================================" << std::endl;
+    test_aho_corasick(output);
+
+    std::cout << std::endl << "Testing fuzzy search" << std::endl
+        << "================================" << std::endl;
+    test_fuzzy_search<256>(false, output);
+    test_fuzzy_search<256>(true, output);
+    test_fuzzy_search<16>(false, output);
+    test_fuzzy_search<4>(false, output);
+    test_fuzzy_search<2>(false, output);
+
+    std::cout << std::endl << "Testing scored trie" << std::endl
+        << "================================" << std::endl;
+    test_scored_trie<256>(output);
+    test_scored_trie<16>(output);
+    test_scored_trie<4>(output);
+    test_scored_trie<2>(output);
+
+    std::cout << std::endl << "Testing key pattern" << std::endl
+        << "================================" << std::endl;
+    test_key_pattern<256>(output);
+    test_key_pattern<16>(output);
+    test_key_pattern<4>(output);
+    test_key_pattern<2>(output);
+
+    std::cout << std::endl << "Testing set operations" << std::endl
+        << "================================" << std::endl;
+    test_set_operations<256>(output);
+    test_set_operations<16>(output);
+    test_set_operations<4>(output);
+    test_set_operations<2>(output);
+
+    std::cout << std::endl << "Testing diff" << std::endl
+        << "================================" << std::endl;
+    test_diff<256>(output);
+    test_diff<16>(output);
+    test_diff<4>(output);
+    test_diff<2>(output);
+
+    std::cout << std::endl << "Testing filter" << std::endl
+        << "================================" << std::endl;
+    test_filter<256>(output);
+    test_filter<16>(output);
+    test_filter<4>(output);
+    test_filter<2>(output);
+
+    std::cout << std::endl << "Testing compact" << std::endl
+        << "================================" << std::endl;
+    test_compact<256>(output);
+    test_compact<16>(output);
+    test_compact<4>(output);
+    test_compact<2>(output);
+
+    std::cout << std::endl << "Testing huge pages" << std::endl
+        << "================================" << std::endl;
+    test_huge_pages<256>(output);
+    test_huge_pages<16>(output);
+    test_huge_pages<4>(output);
+    test_huge_pages<2>(output);
+
+
+
     std::cout << std::endl << "Testing 256-children trie" << std::endl
         << "================================" << std::endl;
     test_trie(trie256, output);
@@ -0,0 +1,128 @@
+/**
+* @file     trie/aho_corasick.hpp
+* @brief    include file for the multi-pattern matching automaton built from a trie256
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "basic_key.hpp"
+#include "basic_trie.hpp"
+
+namespace trie
+{
+    /**
+     * @brief Aho-Corasick automaton finding all keys of a trie256 in a byte stream in a single pass.
+     *  The goto function, the failure links and the bytes are compiled into one flat transition table, so every input byte costs
+     *  exactly one table lookup. Bytes that do not occur in any key share one column of the table (byte classes),
+     *  which keeps the table small for keyword sets over a small alphabet.
+     *  Every state links to the next state on its failure chain that ends a key (output link), so all keys ending at an input byte
+     *  are reported without walking the failure chain.
+     *
+     * @tparam value_t the datatype stored by the std::shared_ptr's
+     */
+    template<typename value_t>
+    class aho_corasick
+    {
+    public:
+        static constexpr uint32_t npos = static_cast<uint32_t>(-1);
+    protected:
+        std::array<uint16_t, 256> _byte_class; // column of every byte in the transition table, 0 for bytes not used by any key
+        std::size_t _class_count;
+        std::vector<uint32_t> _transitions; // state * _class_count + byte class -> next state, state 0 is the root state
+        std::vector<uint32_t> _first_output; // first state ending a key on the failure chain of a state (including itself), npos if none
+        std::vector<uint32_t> _next_output; // next state ending a key on the failure chain of a state ending a key, npos if none
+        std::vector<uint32_t> _pattern; // index of the key ending at a state, npos if none
+        std::vector<std::size_t> _lengths; // length of every key in bytes
+        std::vector<std::shared_ptr<value_t> > _values; // value of every key
+
+    public:
+        aho_corasick() { this->clear(); }
+        /**
+         * @brief construct an automaton matching all keys of the source trie
+         * @throws std::bad_alloc
+         */
+        aho_corasick(trie::basic_trie<256, value_t>& source) { this->build(source); }
+        ~aho_corasick() {}
+
+        /**
+         * @brief rebuild this automaton from all keys stored in the source trie, the source trie is not modified. An empty key is ignored.
+         *
+         * @param source which trie to convert
+         * @throws std::bad_alloc
+         * @throws std::length_error if the automaton exceeds the 32-bit state range
+         */
+        void build(trie::basic_trie<256, value_t>& source);
+        /**
+         * @brief resets the automaton into the valid empty state, it does not match anything
+         */
+        void clear();
+
+        /**
+         * @brief get the number of keys matched by the automaton
+         */
+        std::size_t size() const { return this->_values.size(); }
+        /**
+         * @brief get the number of states of the automaton
+         */
+        std::size_t state_count() const { return this->_pattern.size(); }
+        /**
+         * @brief get the number of bytes used by the tables (not including the values themselves)
+         */
+        std::size_t memory_usage() const;
+
+        /**
+         * @brief matching state of one byte stream. The stream can be fed in buffers of any size,
+         *  keys spanning a buffer boundary are found like all other keys.
+         */
+        class stream
+        {
+        protected:
+            const aho_corasick* _automaton;
+            uint32_t _state{ 0 };
+            std::size_t _position{ 0 }; // number of bytes fed since the last reset
+
+        public:
+            /**
+             * @param automaton the automaton has to outlive the stream and must not be rebuilt while the stream is used
+             */
+            stream(const aho_corasick& automaton) : _automaton(&automaton) {}
+            ~stream() {}
+
+            /**
+             * @brief scan the next buffer of the stream and report every key ending in it
+             *
+             * @param callback callable like `void(std::size_t end, std::size_t length, const std::shared_ptr<value_t>& data)`,
+             *  the key was found at the stream offsets [end - length, end). Keys ending at the same byte are reported from the longest to the shortest key.
+             */
+            template<typename callback_t>
+            void feed(const void* data, std::size_t length, callback_t callback);
+            template<typename callback_t>
+            void feed(std::string_view data, callback_t callback) { this->feed(data.data(), data.size(), callback); }
+            /**
+             * @brief start a new stream, a key can not span the reset
+             */
+            void reset() { this->_state = 0; this->_position = 0; }
+            /**
+             * @brief get the number of bytes fed since the last reset
+             */
+            std::size_t position() const { return this->_position; }
+        }; // class stream
+
+        /**
+         * @brief scan a single buffer, see stream::feed
+         */
+        template<typename callback_t>
+        void scan(std::string_view text, callback_t callback) const { stream(*this).feed(text, callback); }
+    }; // class aho_corasick
+} // namespace trie
@@ -0,0 +1,63 @@
+/**
+* @file     trie/background_reclaimer.hpp
+* @brief    include file for the reclaimer class destroying detached data on a background thread
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace trie
+{
+    /**
+     * @brief owns a thread that releases retired pointers. Handing a detached trie root to the reclaimer moves the
+     *  (possibly long) teardown of all its nodes off the calling thread, e.g. basic_trie::clear(reclaimer).
+     *  Everything that is still queued when the reclaimer is destroyed is released before the destructor returns.
+     */
+    class background_reclaimer
+    {
+    protected:
+        std::mutex _mutex;
+        std::condition_variable _changed;
+        std::deque<std::shared_ptr<void> > _queue;
+        std::size_t _busy{ 0 }; // number of pointers the thread is releasing right now
+        bool _stopping{ false };
+        std::thread _thread; // has to be the last member, the thread uses all other members
+
+        void run();
+
+    public:
+        /**
+         * @throws std::system_error if the thread can not be started
+         */
+        background_reclaimer() : _thread(&background_reclaimer::run, this) {}
+        ~background_reclaimer();
+
+        background_reclaimer(const background_reclaimer& src) = delete; // disable copy constructing
+        background_reclaimer& operator=(const background_reclaimer& src) = delete; // disable copy assignments
+
+        /**
+         * @brief queue a pointer to be released on the reclaimer thread. If it is the last owner, the object is destroyed there.
+         * @throws std::bad_alloc from std::deque::push_back
+         */
+        void retire(std::shared_ptr<void> pointer);
+        /**
+         * @brief block until all pointers retired so far have been released
+         */
+        void drain();
+        /**
+         * @brief get the number of pointers that are waiting to be released
+         */
+        std::size_t pending();
+    };
+} // namespace trie
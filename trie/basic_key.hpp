@@ -16,6 +16,7 @@
 #include <memory>
 #include <vector>
 #include <cstddef>
+#include <cstring>
 
 namespace trie
 {
@@ -54,6 +55,10 @@ namespace trie
         * @brief copy ctor
         */
         basic_key(const basic_key& other) { this->_key = other._key; this->_size = other._size; }
+        /**
+        * @brief copy assignment
+        */
+        basic_key& operator=(const basic_key& other) = default;
         ~basic_key() {}
 
         /**
@@ -12,9 +12,35 @@
 #pragma once
 
 #include "basic_key.hpp"
+#include "instrumentation.hpp"
+#include "key_pattern.hpp"
+#include "background_reclaimer.hpp"
+#include "work_stealing_pool.hpp"
+#include "bloom_filter.hpp"
+#include "node_arena.hpp"
 
 namespace trie
 {
+    /**
+     * @brief return value of the visitors passed to basic_trie::for_each and basic_trie::for_each_node
+     */
+    enum class visit_result
+    {
+        proceed, // continue with the children of the visited node
+        skip_subtree, // continue with the next sibling, the children of the visited node are not visited
+        stop // end the traversal
+    };
+
+    /**
+     * @brief kind of a change reported by basic_trie::diff
+     */
+    enum class diff_kind
+    {
+        added, // the key is only stored in the newer trie
+        removed, // the key is only stored in the older trie
+        changed // the key is stored in both tries with different data pointers
+    };
+
     /**
      * @brief the main trie class. This class is a assiciative container mapping from a byte sequence to a pointer. 
      *  The byte sequence is managed by the trie key class and the pointer is managed by the std::shared_ptr
@@ -29,11 +55,55 @@ namespace trie
     {
     public:
         using key_t = trie::basic_key<children_count>;
+
+        /**
+         * @brief shape and memory statistics of a trie, collected by basic_trie::stats()
+         *  The byte counts only include the objects themselves, allocation overhead (e.g. the std::shared_ptr control blocks) is not included.
+         */
+        struct statistics
+        {
+            std::size_t node_count{ 0 };
+            std::size_t value_count{ 0 };
+            std::size_t tail_count{ 0 }; // number of nodes storing a key tail
+            std::size_t empty_leaf_count{ 0 }; // nodes without children, data and tail (the root of an empty trie is not counted)
+            std::size_t node_bytes{ 0 }; // sizeof(node) for every node
+            std::size_t key_bytes{ 0 }; // key objects and packed key elements of all tails
+            std::size_t value_bytes{ 0 }; // sizeof(value_t) for every value, memory owned by the values is not included
+            std::vector<std::size_t> depth_histogram; // [key length in key elements] -> number of values
+            std::vector<std::vector<std::size_t> > fanout_histogram; // [level][number of children] -> number of nodes
+            std::size_t chain_count{ 0 }; // number of maximal runs of nodes with exactly one child and no data
+            std::vector<std::size_t> chain_histogram; // [chain length in nodes] -> number of chains
+            std::size_t filter_bytes{ 0 }; // memory of the negative lookup filter, 0 if the trie has no filter
+            double filter_false_positive_rate{ 0.0 }; // estimated from the filter's fill ratio
+            std::size_t arena_bytes{ 0 }; // memory of the arena of the last compact(), 0 if the trie was not compacted
+            std::size_t huge_page_bytes{ 0 }; // bytes of the arena that are backed by huge pages, see node_arena::promoted_bytes()
+        };
+        /**
+         * @brief a key found by basic_trie::fuzzy_search()
+         */
+        struct fuzzy_match
+        {
+            key_t key;
+            std::size_t distance; // edit distance to the query
+            std::shared_ptr<value_t> data;
+        };
     protected:
         struct node
         {
             std::array<std::shared_ptr<node>, children_count> children;
             std::shared_ptr<value_t> data;
+            /**
+             * @brief packed remaining key elements of the only key stored below this node, nullptr if the node has no tail.
+             *  A node with a tail never has children, its data belongs to the key 'node path + tail'.
+             *  The tail is expanded into real nodes as soon as another key diverges from it.
+             */
+            std::shared_ptr<key_t> tail;
+
+            node() { TRIE_INSTRUMENT_COUNT(node_allocations); }
+            /**
+             * @brief releases the subtree without recursion, the depth of a trie2 can be many thousand nodes
+             */
+            ~node();
 
             /**
              * @brief get the node's child with the index key_element
@@ -43,21 +113,61 @@ namespace trie
         };
 
         std::shared_ptr<node> _root;
+        std::unique_ptr<trie::bloom_filter> _filter; // negative lookup filter, nullptr if it is not enabled
+        std::vector<std::size_t> _filter_prefix_lengths; // ascending prefix lengths stored in the filter besides the complete keys
+        double _filter_bits_per_key{ 10.0 };
+        std::shared_ptr<bool> _filter_stale; // set while values might be stored that the filter does not know, the filter is then skipped until rebuild_filter()
+        std::vector<std::shared_ptr<bool> > _outer_filters_stale; // stale flags of the filters of the tries this subtrie was taken from
+        std::shared_ptr<trie::node_arena> _arena; // arena of the last compact(), only kept for the statistics
 
         /**
-         * @brief Get a pointer pointing tho the node at the key _key, nullptr if the node does not exist
+         * @brief get the number of key elements that a tail and a key have in common, starting at the key element 'offset' of the key
+         */
+        static std::size_t common_length(const key_t& tail, const key_t& _key, std::size_t offset);
+        /**
+         * @brief copy the key elements starting at index 'first' into a new key
+         * @throws std::bad_alloc from basic_key::push_back
+         */
+        static key_t make_tail(const key_t& _key, std::size_t first);
+        /**
+         * @brief expand the first 'levels' key elements of a node's tail into real nodes, the data and the remaining tail are moved to the deepest new node
+         *
+         * @param _node the node with the tail
+         * @param levels how many tail elements to expand, must be in the range [1, tail size]
+         * @return pointer to the deepest new node
+         * @throws std::bad_alloc from std::make_shared()
+         */
+        std::shared_ptr<node> split_tail(std::shared_ptr<node> _node, std::size_t levels);
+        /**
+         * @brief Get a pointer pointing tho the node at the key _key without modifying the trie
          * @param _key which node to get
-         * @return nullptr if the node is not present in the trie, pointer to the node otherwise
+         * @param in_tail set to true if the key ends inside of the returned node's tail, this position is a node of the trie
+         *  without a node object, it never stores data. Set to false otherwise.
+         * @return nullptr if the node is not present in the trie, pointer to the node (or the node with the tail) otherwise
+         */
+        std::shared_ptr<node> get_node(const key_t& _key, bool& in_tail) const;
+        /**
+         * @brief Get a pointer pointing tho the node at the key _key, nullptr if there is no node object for the key
+         *  (the key is not present or ends inside of a node's tail). The trie is not modified.
          */
-        std::shared_ptr<node> get_node(const key_t& _key);
+        std::shared_ptr<node> get_node(const key_t& _key) const;
         /**
          * @brief Get a pointer pointing to the node at key _key, create that node (and all required parent nodes) if the node does not exists
          * 
          * @param _key which node to add to the trie
+         * @param use_tail if true, the remaining key elements of a new node are stored as the node's tail instead of creating a node for every element
          * @return pointer pointing to the node, if this is a nullptr, something went really wrong
          * @throws std::bad_alloc from std::make_shared()
          */
-        std::shared_ptr<node> add_node(const key_t& _key);
+        std::shared_ptr<node> add_node(const key_t& _key, bool use_tail = true);
+        /**
+         * @brief unlink a node and all its children nodes from the trie and return it
+         *
+         * @param _key which node to unlink
+         * @return the unlinked node, nullptr if the node did not exist
+         * @throws std::bad_alloc from std::make_shared() if the node was part of a tail
+         */
+        std::shared_ptr<node> extract_node(const key_t& _key);
         /**
          * @brief unlink a node and all its children nodes from the trie, after this method call the node will no longer exist
          * 
@@ -65,6 +175,74 @@ namespace trie
          * @return true to indicate that the node was unlinked, false to indicate that the node did not exist
          */
         bool unlink_node(const key_t& _key);
+        /**
+         * @brief depth-first traversal of the subtree of 'start' with an explicit stack, in key order
+         *
+         * @param start first node to visit, the key buffer has to hold the complete key of this node (including its tail)
+         * @param key reused key buffer, it always holds the key of the visited node
+         * @param values_only if true, nodes without data are not passed to the visitor (but their children are visited)
+         * @return false if the visitor stopped the traversal
+         */
+        template<typename visitor_t>
+        bool traverse(node* start, key_t& key, bool values_only, visitor_t& visitor);
+        /**
+         * @brief walk down along a key without modifying the trie and call callback(length, data) for every value stored at a prefix of the key,
+         *  in order of increasing prefix length. The walk starts at the position 'offset' inside of the tail of 'start', which is 'depth' key elements deep.
+         */
+        template<typename callback_t>
+        static void walk_prefixes(const node* start, std::size_t offset, std::size_t depth, const key_t& key, callback_t callback);
+        /**
+         * @brief FNV-1a step over one key element, the hash of a key prefix is the hash of the key elements up to it
+         */
+        static uint64_t filter_hash(uint64_t hash, uint8_t key_element) { return (hash ^ key_element) * 0x100000001b3ULL; }
+        static constexpr uint64_t filter_seed = 0xcbf29ce484222325ULL;
+        /**
+         * @brief add a key and its prefixes of the configured lengths to the filter, nothing happens if the trie has no filter
+         */
+        void filter_add(const key_t& key);
+        /**
+         * @brief skip the filter until rebuild_filter(), because a value might be stored without filter_add(), e.g. through a returned reference.
+         *  The filters of the tries this subtrie was taken from are marked as well.
+         */
+        void filter_mark_stale();
+        bool filter_usable() const { return this->_filter != nullptr && !*this->_filter_stale; }
+        /**
+         * @brief check if the filter proves that the trie has no node at the key. Inner nodes exist for every prefix of a stored key,
+         *  so only the longest configured prefix length not longer than the key can be checked.
+         */
+        bool filter_rejects_node(const key_t& key) const;
+        /**
+         * @brief copy all nodes and tails into a new node_arena, which is kept for the statistics. The data pointers are shared with this trie.
+         *  The levels below the root are laid out breadth-first as long as they fit into 'hot_bytes',
+         *  every subtree below them is laid out in depth-first pre-order, so a lookup walks forward through the memory.
+         * @throws std::bad_alloc
+         */
+        std::shared_ptr<node> compacted_copy(std::size_t hot_bytes, trie::node_arena::page_mode pages);
+        /**
+         * @brief walk this trie and the other trie in lockstep in key order and call visitor(key, left, right) for every key that is
+         *  only stored in this trie (left_only), only in the other trie (right_only) or in both tries (both). The data pointer of a trie that
+         *  does not store the key is a nullptr. Subtrees that only exist in a trie whose keys are not wanted are not entered
+         *  and subtrees shared by both tries (the same node) are skipped if keys stored in both tries are not wanted.
+         *  With changed_only keys stored in both tries are only wanted if they store different data pointers, so shared subtrees are always skipped.
+         */
+        template<typename visitor_t>
+        bool walk_pair(basic_trie& other, bool left_only, bool right_only, bool both, visitor_t& visitor, bool changed_only = false);
+
+        /**
+         * @brief part of the trie that is handled by one task of a parallel traversal
+         */
+        struct segment
+        {
+            node* current;
+            key_t key; // complete key of the node, including its tail
+            bool subtree; // if false, only the node's own value belongs to the segment, its children are separate segments
+        };
+        /**
+         * @brief split the trie into segments by expanding the top levels until there are at least 'target' segments
+         *  or the trie can not be split any further. The segments are ordered by key and together they cover every value exactly once.
+         * @throws std::bad_alloc
+         */
+        std::vector<segment> split_segments(std::size_t target);
 
         /**
          * @brief internal helper constructor
@@ -75,8 +253,8 @@ namespace trie
         basic_trie() { this->clear(); }
         ~basic_trie() {}
 
-        basic_trie(basic_trie&& src) noexcept { this->_root = std::move(src._root); } // move constructing
-        basic_trie& operator=(basic_trie&& src) noexcept { this->_root = std::move(src._root); return *this; } // move assignment
+        basic_trie(basic_trie&& src) noexcept = default; // move constructing
+        basic_trie& operator=(basic_trie&& src) noexcept = default; // move assignment
         basic_trie(const basic_trie& src) = delete; // disable copy constructing
         basic_trie& operator=(const basic_trie& src) = delete; // disable copy assignments
 
@@ -89,6 +267,8 @@ namespace trie
         bool has_node(const key_t& _key);
         /**
          * @brief get the pointer to the value stored at a key, this pointer can be a nullptr!
+         *  A key ending inside of a node's tail has no node object yet, the tail is expanded up to the key so the returned reference can be assigned to.
+         *  A value assigned to a node without value bypasses the filter, so at() of such a node marks the filter stale, see enable_filter().
          * 
          * @param key the key to the value
          * @return reference to a std::shared_ptr of value type
@@ -110,6 +290,56 @@ namespace trie
          * @return true if the value could be inserted, false if the value already stored data
          */
         bool insert(const key_t& key, std::shared_ptr<value_t> value);
+        /**
+         * @brief insert many pointers at once, the pairs are inserted in the order of the vector
+         *
+         * @param pairs the keys and the pointers to store at them
+         * @return the number of pairs that could be inserted, pairs with keys that already store a value are skipped
+         * @throws std::bad_alloc
+         */
+        std::size_t insert_batch(const std::vector<std::pair<key_t, std::shared_ptr<value_t> > >& pairs);
+        /**
+         * @brief get the value stored at a key without modifying the trie, the filter is checked before the trie is searched
+         *
+         * @return the data pointer stored at the key, a nullptr if the trie does not store a value at the key
+         */
+        std::shared_ptr<value_t> find(const key_t& key) const;
+        /**
+         * @brief get the values of many keys, see find(). The filter is checked for all keys first,
+         *  only the keys that pass it are searched in the trie.
+         *
+         * @return the data pointers in the order of the keys
+         * @throws std::bad_alloc
+         */
+        std::vector<std::shared_ptr<value_t> > find_batch(const std::vector<key_t>& keys) const;
+        /**
+         * @brief maintain a bloom filter of the stored keys, so lookups of missing keys can return before the trie is searched.
+         *  find() and find_batch() check the complete key. at() and has_node() also find inner nodes, so they can only use the filter
+         *  if prefix lengths are configured: a key is rejected if its prefix of the longest configured length not longer than the key is missing.
+         *  INFO: with the default empty prefix_lengths, at() and has_node() never consult the filter, only find() and find_batch() are sped up.
+         *  Configure at least one prefix length (e.g. {4}) if missing keys are looked up through has_node() or at().
+         *  The filter is sized for the current keys, keys inserted later are added and raise the false positive rate,
+         *  erased keys stay in the filter. Call rebuild_filter() after bulk loads or erases, merge() rebuilds it on its own.
+         *  Values stored where the filter can not see them mark it stale, find() and the other lookups then skip the filter until rebuild_filter():
+         *  at() of a node without value, node iterators and for_each_node() of a non-const trie, and values stored through a subtrie().
+         *  Rebuild the filter after such writes are done, a reference kept from before the rebuild must not be used to store a new key.
+         *
+         * @param bits_per_key filter bits per stored key (or prefix), 10 bits give a false positive rate of about 1%
+         * @param prefix_lengths key prefix lengths in key elements that are added to the filter besides the complete keys
+         * @throws std::bad_alloc
+         */
+        void enable_filter(double bits_per_key = 10.0, std::vector<std::size_t> prefix_lengths = {});
+        /**
+         * @brief rebuild the filter for the current keys with the settings of enable_filter(), nothing happens if the trie has no filter
+         * @throws std::bad_alloc
+         */
+        void rebuild_filter();
+        void disable_filter() { this->_filter = nullptr; }
+        bool has_filter() const { return this->_filter != nullptr; }
+        /**
+         * @brief check if the filter is skipped by the lookups until the next rebuild_filter(), see enable_filter()
+         */
+        bool filter_stale() const { return this->_filter != nullptr && *this->_filter_stale; }
         /**
          * @brief erade a node and all of it's children nodes
          * 
@@ -124,6 +354,58 @@ namespace trie
          * @param source which trie to merge into this
          */
         void merge(::trie::basic_trie<children_count, value_t>& source);
+        /**
+         * @brief get a new trie with all keys stored in this or in the other trie, the data of this trie is used for keys stored in both.
+         *  Both tries are walked in lockstep, the new trie shares the data pointers but no nodes with the source tries.
+         * @throws std::bad_alloc
+         */
+        trie::basic_trie<children_count, value_t> set_union(basic_trie& other);
+        /**
+         * @brief call visitor(key, left, right) for every key stored in this or in the other trie, in key order.
+         *  'left' is the data of this trie and 'right' the data of the other trie, the data of a trie not storing the key is a nullptr.
+         *
+         * @param visitor callable like `visit_result(const key_t& key, std::shared_ptr<value_t>& left, std::shared_ptr<value_t>& right)`,
+         *  returning void means visit_result::proceed. The visitor must not modify the structure of the tries.
+         * @return false if the visitor stopped the walk, true otherwise
+         * @throws std::bad_alloc
+         */
+        template<typename visitor_t>
+        bool set_union(basic_trie& other, visitor_t visitor);
+        /**
+         * @brief get a new trie with all keys stored in both tries and the data of this trie. Subtrees that only exist in one trie are not entered.
+         * @throws std::bad_alloc
+         */
+        trie::basic_trie<children_count, value_t> set_intersection(basic_trie& other);
+        /**
+         * @brief call visitor(key, left, right) for every key stored in both tries, see set_union
+         */
+        template<typename visitor_t>
+        bool set_intersection(basic_trie& other, visitor_t visitor);
+        /**
+         * @brief get a new trie with all keys stored in this trie but not in the other trie. Subtrees only stored in the other trie
+         *  and subtrees shared by both tries (e.g. a subtrie()) are not entered.
+         * @throws std::bad_alloc
+         */
+        trie::basic_trie<children_count, value_t> set_difference(basic_trie& other);
+        /**
+         * @brief call visitor(key, left, right) for every key stored in this trie but not in the other trie (right is a nullptr), see set_union
+         */
+        template<typename visitor_t>
+        bool set_difference(basic_trie& other, visitor_t visitor);
+        /**
+         * @brief call visitor(key, kind, old_data, new_data) in key order for every key that was added, removed or changed between this trie
+         *  and the newer trie. A key is changed if both tries store a different data pointer, the values themselves are not compared.
+         *  Both tries are walked in lockstep and subtrees shared by both tries (the same node) are not entered,
+         *  so the cost only depends on the parts of the tries that are not shared.
+         *
+         * @param newer the newer version of this trie
+         * @param visitor callable like `visit_result(const key_t& key, diff_kind kind, std::shared_ptr<value_t>& old_data, std::shared_ptr<value_t>& new_data)`,
+         *  returning void means visit_result::proceed. The data of the trie not storing the key is a nullptr.
+         * @return false if the visitor stopped the walk, true otherwise
+         * @throws std::bad_alloc
+         */
+        template<typename visitor_t>
+        bool diff(basic_trie& newer, visitor_t visitor);
         /**
          * @brief get a subtrie of this trie. INFO: the subtrie is NOT a copy of this trie, all modifications of the subtrie will also modify this trie!
          * 
@@ -141,10 +423,138 @@ namespace trie
          * @brief removes all nodes from the trie and resets it into the valid empty state
          */
         void clear();
+        /**
+         * @brief removes all nodes from the trie like clear(), but the old nodes are handed to the reclaimer,
+         *  so they are destroyed on the reclaimer's thread instead of the calling thread
+         * @throws std::bad_alloc
+         */
+        void clear(trie::background_reclaimer& reclaimer);
+        /**
+         * @brief rebuild the trie into one contiguous arena allocation in a cache friendly order, the top levels are packed together
+         *  and every subtree below them follows in depth-first order. The old nodes are only read while the copy is built and are released
+         *  once the new root replaced them, so readers of a read-mostly table only have to be excluded for the final swap.
+         *  Nodes added after the compaction are allocated on the heap again, erased nodes keep their arena memory until all nodes of the arena are released.
+         *
+         * @param hot_bytes size of the breadth-first packed top levels in bytes
+         * @param pages the preferred backing of the arena, huge pages cut the TLB misses of lookups in very large tries.
+         *  If huge pages are not available the arena falls back to normal pages, stats() reports how much of it is backed by huge pages.
+         * @throws std::bad_alloc
+         */
+        void compact(std::size_t hot_bytes = 256 * 1024, trie::node_arena::page_mode pages = trie::node_arena::page_mode::normal);
+        /**
+         * @brief compact the trie like compact(), but the old nodes are handed to the reclaimer
+         *  so they are destroyed on the reclaimer's thread instead of the calling thread
+         * @throws std::bad_alloc
+         */
+        void compact(trie::background_reclaimer& reclaimer, std::size_t hot_bytes = 256 * 1024, trie::node_arena::page_mode pages = trie::node_arena::page_mode::normal);
         /**
          * @brief returns the number of elements stored in the trie, INFO: this method currently has a complexity of O(n)
          */
         std::size_t size();
+        /**
+         * @brief collect the memory and shape statistics of this trie in a single traversal over all nodes
+         * @throws std::bad_alloc
+         */
+        statistics stats() const;
+        /**
+         * @brief find the longest stored key that is a prefix of (or equal to) the key, e.g. the most specific route of an address in a trie2.
+         *  This is a single descent along the key, the trie is not modified.
+         *
+         * @return the length of the matching key in key elements and its data pointer, the data pointer is a nullptr if no prefix of the key is stored
+         */
+        std::pair<std::size_t, std::shared_ptr<value_t> > longest_prefix_match(const key_t& key) const;
+        /**
+         * @brief get all stored keys that are a prefix of (or equal to) the key, ordered from the shortest to the longest prefix
+         *
+         * @return pairs of the prefix length in key elements and the prefix's data pointer
+         * @throws std::bad_alloc
+         */
+        std::vector<std::pair<std::size_t, std::shared_ptr<value_t> > > all_prefixes_of(const key_t& key) const;
+        /**
+         * @brief call a visitor for every value stored at or below a prefix, in key order. Unlike the iterators, this does not search
+         *  the parent node from the root node when going back up and the key is not copied for every value.
+         *  The trie is not modified, a prefix ending inside of a key tail does not expand the tail.
+         *
+         * @param prefix only keys starting with this prefix are visited, an empty prefix visits the whole trie
+         * @param visitor callable like `visit_result(const key_t& key, std::shared_ptr<value_t>& data)`, returning void means visit_result::proceed.
+         *  The key is a buffer that is reused for all calls, it must be copied to keep it. The visitor must not modify the trie's structure.
+         * @return false if the visitor stopped the traversal, true otherwise
+         * @throws std::bad_alloc
+         */
+        template<typename visitor_t>
+        bool for_each(const key_t& prefix, visitor_t visitor);
+        /**
+         * @brief call a visitor for every value with first <= key < last, in key order. Subtrees below 'first' are skipped without visiting
+         *  their values and the traversal ends at the first node after 'last', so a narrow range only walks down to it.
+         *  Keys are compared element by element in the order of the trie's key elements (see trie::key_encoder for order preserving keys).
+         *
+         * @param visitor callable like `visit_result(const key_t& key, std::shared_ptr<value_t>& data)`, returning void means visit_result::proceed.
+         *  The key is a buffer that is reused for all calls, it must be copied to keep it. The visitor must not modify the trie's structure.
+         * @return false if the visitor stopped the traversal, true otherwise
+         * @throws std::bad_alloc
+         */
+        template<typename visitor_t>
+        bool for_each_range(const key_t& first, const key_t& last, visitor_t visitor);
+        /**
+         * @brief find all keys within a Levenshtein distance of the query in a single traversal. Every visited node carries the
+         *  distance row of its key to all prefixes of the query, subtrees whose row minimum exceeds the bound are not visited.
+         *
+         * @param max_distance the maximum number of inserted, removed or substituted symbols
+         * @param utf8 only for a trie256: the symbols are UTF-8 code points instead of bytes, invalid bytes are symbols of their own
+         * @return the matches ordered by distance, then by key
+         * @throws std::invalid_argument if utf8 is set for a trie with less than 256 children per node
+         * @throws std::bad_alloc
+         */
+        std::vector<fuzzy_match> fuzzy_search(const key_t& query, std::size_t max_distance, bool utf8 = false) const;
+        /**
+         * @brief call a visitor for every value whose key matches a pattern, in key order. The pattern's automaton runs along the trie
+         *  and subtrees in which it can not reach a match any more are skipped, so the time depends on the matches and not on the trie size.
+         *  The pattern reads the bytes of the keys, for tries with less than 256 children the key elements are collected into bytes
+         *  and a subtree is already skipped when no byte starting with the collected elements can lead to a match.
+         *
+         * @param visitor callable like `visit_result(const key_t& key, std::shared_ptr<value_t>& data)`, returning void means visit_result::proceed.
+         *  The key is a buffer that is reused for all calls, it must be copied to keep it. The visitor must not modify the trie's structure.
+         * @return false if the visitor stopped the traversal, true otherwise
+         * @throws std::bad_alloc
+         */
+        template<typename visitor_t>
+        bool for_each_match(const trie::key_pattern& pattern, visitor_t visitor);
+        /**
+         * @brief call a visitor for every node of the trie in key order, including the root node and nodes without data (data is a nullptr then).
+         *  A node with a tail is visited once, with the key including the tail.
+         *
+         * @param visitor callable like `visit_result(const key_t& key, std::shared_ptr<value_t>& data)`, returning void means visit_result::proceed.
+         *  The key is a buffer that is reused for all calls, it must be copied to keep it. The visitor must not modify the trie's structure.
+         * @return false if the visitor stopped the traversal, true otherwise
+         * @throws std::bad_alloc
+         */
+        template<typename visitor_t>
+        bool for_each_node(visitor_t visitor);
+        /**
+         * @brief call a visitor for every value of the trie, the top levels of the trie are split into subtrees that are visited in parallel.
+         *  The visitor is called from several threads at once and the calls are not ordered.
+         *
+         * @param visitor callable like `void(const key_t& key, std::shared_ptr<value_t>& data)`, it has to be thread safe
+         *  and must not modify the trie's structure. The key buffer is reused for all calls of one thread.
+         * @param pool the thread pool running the subtrees, this method must not be called from inside of a task of the same pool
+         * @throws the first exception thrown by the visitor
+         */
+        template<typename visitor_t>
+        void parallel_for_each(visitor_t visitor, trie::work_stealing_pool& pool = trie::work_stealing_pool::shared());
+        /**
+         * @brief map every value of the trie to a result and combine all results, the subtrees are reduced in parallel
+         *
+         * @param identity result of an empty trie, every partial result starts with this value
+         * @param map callable like `result_t(const key_t& key, std::shared_ptr<value_t>& data)`, called from several threads at once
+         * @param combine callable like `result_t(result_t left, result_t right)`, it has to be associative
+         * @param ordered if true, the results are combined in key order (e.g. to concatenate an export),
+         *  otherwise every worker combines its results in the order it visits them and combine also has to be commutative
+         * @param pool the thread pool running the subtrees, this method must not be called from inside of a task of the same pool
+         * @throws the first exception thrown by map or combine
+         */
+        template<typename result_t, typename map_t, typename combine_t>
+        result_t parallel_reduce(result_t identity, map_t map, combine_t combine, bool ordered = true,
+            trie::work_stealing_pool& pool = trie::work_stealing_pool::shared());
 
     protected:
         /**
@@ -159,6 +569,7 @@ namespace trie
             mutable std::shared_ptr<node> cur_node{ nullptr };
             mutable key_t cur_key;
             mutable std::ptrdiff_t child_element{ 0 };
+            mutable std::size_t cur_tail{ 0 }; // number of tail elements at the end of cur_key
 
         public:
             basic_node_iterator() {}
@@ -193,6 +604,11 @@ namespace trie
             inline const std::shared_ptr<value_t>& get_data() const { return this->cur_node->data; }
 
         protected:
+            /**
+             * @brief append / remove the tail of the current node to / from the current key
+             */
+            void push_tail() const;
+            void pop_tail() const;
             void next_node() const;
             void prev_node() const;
         }; // struct basic_node_iterator
@@ -259,16 +675,56 @@ namespace trie
             const reverse_value_iterator operator--(int) const { reverse_value_iterator copy = *this; this->next_value(); return copy; }
         }; // class reverse_value_iterator
     public:
-        node_iterator node_begin() { return ++node_iterator(_root); }
+        node_iterator node_begin() { this->filter_mark_stale(); return ++node_iterator(_root); } // node iterators can store values the filter does not know
         const node_iterator node_begin() const { return ++node_iterator(_root); }
         node_iterator node_end() { return node_iterator(_root); }
         const node_iterator node_end() const { return node_iterator(_root); }
 
-        reverse_node_iterator node_rbegin() { return ++reverse_node_iterator(_root); }
+        reverse_node_iterator node_rbegin() { this->filter_mark_stale(); return ++reverse_node_iterator(_root); }
         const reverse_node_iterator node_rbegin() const { return ++reverse_node_iterator(_root); }
         reverse_node_iterator node_rend() { return reverse_node_iterator(_root); }
         const reverse_node_iterator node_rend() const { return reverse_node_iterator(_root); }
 
+        /**
+         * @brief accelerator for longest prefix matches. The first 'levels' key elements are resolved with one lookup in a
+         *  table with children_count^levels entries (a multi-bit stride, e.g. 16 bits for a trie2), the rest of the key is matched in the trie.
+         *  The index is a snapshot: it keeps the nodes it points to alive, but it has to be rebuilt after the trie is modified.
+         */
+        class stride_index
+        {
+        protected:
+            struct entry
+            {
+                std::shared_ptr<node> current; // position after the first 'levels' key elements, nullptr if no key continues there
+                std::size_t offset; // position inside of the tail of current
+                std::shared_ptr<value_t> best; // data of the longest stored prefix with at most 'levels' key elements
+                std::size_t best_length;
+            };
+            std::shared_ptr<node> _root;
+            std::size_t _levels;
+            std::vector<entry> _table;
+
+            void fill(const std::shared_ptr<node>& current, std::size_t offset, std::size_t depth, std::size_t index, std::shared_ptr<value_t> best, std::size_t best_length);
+
+        public:
+            /**
+             * @param source the trie to index
+             * @param levels number of key elements resolved by the table, 0 selects a table with 2^16 entries
+             * @throws std::length_error if the table would have more than 2^24 entries
+             * @throws std::bad_alloc
+             */
+            stride_index(const basic_trie& source, std::size_t levels = 0);
+
+            /**
+             * @brief same as basic_trie::longest_prefix_match on the indexed trie
+             */
+            std::pair<std::size_t, std::shared_ptr<value_t> > longest_prefix_match(const key_t& key) const;
+            /**
+             * @brief get the number of bytes used by the table
+             */
+            std::size_t memory_usage() const { return this->_table.capacity() * sizeof(entry); }
+        }; // class stride_index
+
         value_iterator begin() { return ++value_iterator(_root); }
         const value_iterator begin() const { return ++value_iterator(_root); }
         value_iterator end() { return value_iterator(_root); }
@@ -279,4 +735,10 @@ namespace trie
         reverse_value_iterator rend() { return reverse_value_iterator(_root); }
         const reverse_value_iterator rend() const { return reverse_value_iterator(_root); }
     }; // class basic_trie
+
+    /**
+     * @brief call callback(key, kind, old_data, new_data) for every key that differs between two versions of a trie, see basic_trie::diff
+     */
+    template<std::size_t children_count, typename value_t, typename visitor_t>
+    bool diff(basic_trie<children_count, value_t>& old_trie, basic_trie<children_count, value_t>& new_trie, visitor_t callback);
 } // namespace trie
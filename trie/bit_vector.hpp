@@ -0,0 +1,94 @@
+/**
+* @file     trie/bit_vector.hpp
+* @brief    include file for the bit vector class with rank/select support
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace trie
+{
+    /**
+     * @brief append-only bit container used by the succinct data structures.
+     *  After all bits have been pushed, 'build_index' has to be called once to create the rank directory.
+     *  The rank directory stores the number of set bits in front of every 512 bit block, which costs 12.5% of extra space
+     *  and allows rank in O(1) and select in O(log n)
+     */
+    class bit_vector
+    {
+    protected:
+        static constexpr std::size_t word_bits = 64;
+        static constexpr std::size_t block_words = 8;
+        static constexpr std::size_t block_bits = word_bits * block_words;
+
+        std::vector<uint64_t> _words;
+        std::vector<uint64_t> _blocks; // number of set bits in front of each block
+        std::size_t _size;
+
+        static inline std::size_t popcount(uint64_t word);
+        /**
+         * @brief get the position of the n-th (0-based) set bit inside a single word, the word must have more than n set bits
+         */
+        static inline std::size_t select_in_word(uint64_t word, std::size_t n);
+
+    public:
+        bit_vector() { this->clear(); }
+        ~bit_vector() {}
+
+        /**
+         * @brief append a single bit to the end of the bit vector
+         * @throws std::bad_alloc from std::vector::push_back
+         */
+        inline void push_back(bool bit);
+        /**
+         * @brief get the bit at index 'index'
+         * @throws std::out_of_range from std::vector::at
+         */
+        inline bool get(std::size_t index) const;
+        /**
+         * @brief get the number of bits stored in the bit vector
+         */
+        inline std::size_t size() const { return this->_size; }
+        /**
+         * @brief resets the bit vector into the empty state
+         */
+        inline void clear();
+        /**
+         * @brief (re)creates the rank directory, this has to be called after the last push_back and before any rank/select call
+         */
+        inline void build_index();
+
+        /**
+         * @brief get the number of set bits in the range [0, pos)
+         */
+        inline std::size_t rank1(std::size_t pos) const;
+        /**
+         * @brief get the number of cleared bits in the range [0, pos)
+         */
+        inline std::size_t rank0(std::size_t pos) const { return pos - this->rank1(pos); }
+        /**
+         * @brief get the position of the n-th (0-based) set bit
+         * @throws std::out_of_range if the bit vector has less than n+1 set bits
+         */
+        inline std::size_t select1(std::size_t n) const;
+        /**
+         * @brief get the position of the n-th (0-based) cleared bit
+         * @throws std::out_of_range if the bit vector has less than n+1 cleared bits
+         */
+        inline std::size_t select0(std::size_t n) const;
+
+        /**
+         * @brief get the number of bytes used by the bits and the rank directory
+         */
+        inline std::size_t memory_usage() const;
+    }; // class bit_vector
+} // namespace trie
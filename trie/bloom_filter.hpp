@@ -0,0 +1,64 @@
+/**
+* @file     trie/bloom_filter.hpp
+* @brief    include file for the bloom filter used to reject lookups of missing keys
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace trie
+{
+    /**
+     * @brief bloom filter over 64-bit hashes. The bit positions are derived from the hash by double hashing,
+     *  so the caller only has to hash its items once. A filter never forgets an item, items can not be removed.
+     */
+    class bloom_filter
+    {
+    protected:
+        std::vector<uint64_t> _words;
+        std::size_t _bit_count;
+        std::size_t _hash_count;
+        std::size_t _item_count{ 0 }; // number of add() calls since the last clear()
+
+        /**
+         * @brief the finalizer of MurmurHash3, spreads every input bit over the whole result
+         */
+        static uint64_t mix(uint64_t hash);
+
+    public:
+        /**
+         * @param expected_items number of items the filter is sized for, adding more items increases the false positive rate
+         * @param bits_per_item number of filter bits per expected item, 10 bits give a false positive rate of about 1%
+         * @throws std::bad_alloc
+         */
+        bloom_filter(std::size_t expected_items, double bits_per_item = 10.0);
+
+        void add(uint64_t hash);
+        /**
+         * @brief check if a hash might have been added, false means that it was never added
+         */
+        bool may_contain(uint64_t hash) const;
+        /**
+         * @brief remove all items, the size of the filter is kept
+         */
+        void clear();
+
+        std::size_t bit_count() const { return this->_bit_count; }
+        std::size_t hash_count() const { return this->_hash_count; }
+        std::size_t item_count() const { return this->_item_count; }
+        std::size_t memory_usage() const { return this->_words.size() * sizeof(uint64_t); }
+        /**
+         * @brief estimate the false positive rate from the fraction of set bits, this has a complexity of O(bit count)
+         */
+        double false_positive_rate() const;
+    };
+} // namespace trie
@@ -0,0 +1,171 @@
+/**
+* @file     trie/dawg.hpp
+* @brief    include file for the minimal acyclic automaton (directed acyclic word graph) class
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include "basic_key.hpp"
+#include "basic_trie.hpp"
+
+namespace trie
+{
+    /**
+     * @brief read-only key set built from a basic_trie as a minimal acyclic automaton.
+     *  In addition to the common prefixes shared by a trie, all identical suffix subtrees are merged into one state,
+     *  which makes the automaton a lot smaller for key sets with many common endings.
+     *  Since a state can be reached by many keys, values can not be stored in the states. Instead every state counts
+     *  the keys that can be reached from it, which maps every key to its index in key order (a minimal perfect hash).
+     *  The values are stored in an array indexed by that key index.
+     *
+     * @tparam children_count number of possible states for one key element. MUST be one of: 2, 4, 16, 256
+     * @tparam value_t the datatype stored by the std::shared_ptr's
+     */
+    template<std::size_t children_count, typename value_t>
+    class dawg
+    {
+    public:
+        using key_t = trie::basic_key<children_count>;
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    protected:
+        struct state
+        {
+            uint32_t first_edge; // index of the first outgoing edge in the edge array
+            uint32_t edge_count; // number of outgoing edges, the edges are sorted by their label
+            uint32_t count; // number of keys that can be reached from this state
+            bool final; // true if a key ends at this state
+        };
+        struct edge
+        {
+            uint32_t target; // state this edge leads to
+            uint32_t before; // number of keys from the source state that are ordered before all keys using this edge
+            uint8_t label;
+        };
+
+        std::vector<state> _states; // state 0 is the root state
+        std::vector<edge> _edges;
+        std::vector<std::shared_ptr<value_t> > _values; // values in key order
+
+        /**
+         * @brief get the edge leaving 'from' with the label 'key_element', nullptr if there is no such edge
+         */
+        const edge* find_edge(uint32_t from, uint8_t key_element) const;
+
+    public:
+        dawg() { this->clear(); }
+        /**
+         * @brief construct an automaton holding all keys and values of the source trie
+         * @throws std::bad_alloc
+         */
+        dawg(trie::basic_trie<children_count, value_t>& source) { this->build(source); }
+        ~dawg() {}
+
+        /**
+         * @brief rebuild this automaton from all values stored in the source trie. The source trie is not modified.
+         *  The keys are added in key order and every finished state is merged with an equivalent registered state (Daciuk et al.)
+         *
+         * @param source which trie to convert
+         * @throws std::bad_alloc
+         * @throws std::length_error if the key set exceeds the 32-bit counter range
+         */
+        void build(trie::basic_trie<children_count, value_t>& source);
+        /**
+         * @brief resets the automaton into the valid empty state
+         */
+        void clear();
+
+        /**
+         * @brief check if a key is part of the key set
+         */
+        bool contains(const key_t& key) const { return this->index_of(key) != npos; }
+        /**
+         * @brief get the index of a key in key order, npos if the key is not part of the key set
+         */
+        std::size_t index_of(const key_t& key) const;
+        /**
+         * @brief get the key with the index 'index' in key order
+         * @throws std::out_of_range if the index is not smaller than size()
+         */
+        key_t key_at(std::size_t index) const;
+        /**
+         * @brief get the pointer to the value stored at a key
+         *
+         * @param key the key to the value
+         * @return reference to a std::shared_ptr of value type
+         * @throws std::out_of_range if the key is not part of the key set
+         */
+        const std::shared_ptr<value_t>& at(const key_t& key) const;
+
+        /**
+         * @brief get the number of keys stored in the automaton, this has a complexity of O(1)
+         */
+        std::size_t size() const { return this->_values.size(); }
+        /**
+         * @brief get the number of states of the automaton
+         */
+        std::size_t state_count() const { return this->_states.size(); }
+        /**
+         * @brief get the number of edges of the automaton
+         */
+        std::size_t edge_count() const { return this->_edges.size(); }
+        /**
+         * @brief get the number of bytes used by the states, edges and the value array (not including the values themselves)
+         */
+        std::size_t memory_usage() const;
+
+        /**
+         * @brief forward iterator over all keys in key order
+         */
+        class value_iterator
+        {
+        protected:
+            struct frame
+            {
+                uint32_t state, next_edge;
+            };
+            const dawg* _dawg{ nullptr };
+            std::vector<frame> _stack;
+            key_t cur_key;
+            std::size_t cur_index{ npos };
+
+            void next_value();
+
+        public:
+            value_iterator() {}
+            value_iterator(const dawg* source, bool at_begin);
+            ~value_iterator() {}
+
+            inline bool operator==(const value_iterator& other) const { return this->cur_index == other.cur_index; }
+            inline bool operator!=(const value_iterator& other) const { return !(*this == other); }
+
+            inline bool is_null() const { return this->cur_index == npos; }
+            inline operator bool() const { return !this->is_null(); }
+            inline bool operator!() const { return this->is_null(); }
+
+            /**
+             * @brief Get the key of where the iterator is currently at
+             */
+            inline const key_t& get_key() const { return this->cur_key; }
+            /**
+             * @brief Get the index of the current key in key order
+             */
+            inline std::size_t get_index() const { return this->cur_index; }
+            /**
+             * @brief Get the data pointer of where the iterator is currently at
+             */
+            inline const std::shared_ptr<value_t>& get_data() const { return this->_dawg->_values.at(this->cur_index); }
+
+            value_iterator& operator++() { this->next_value(); return *this; }
+            value_iterator operator++(int) { value_iterator copy = *this; this->next_value(); return copy; }
+        }; // class value_iterator
+
+        value_iterator begin() const { return value_iterator(this, true); }
+        value_iterator end() const { return value_iterator(this, false); }
+    }; // class dawg
+} // namespace trie
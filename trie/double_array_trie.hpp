@@ -0,0 +1,109 @@
+/**
+* @file     trie/double_array_trie.hpp
+* @brief    include file for the compiled double-array trie class
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <limits>
+#include <string_view>
+
+#include "basic_trie.hpp"
+
+namespace trie
+{
+    /**
+     * @brief read-only trie compiled from a trie256 into a double-array (BASE/CHECK) representation.
+     *  The transition from state s with the byte c leads to state t = base[s] + c, which is valid if check[t] == s.
+     *  BASE and CHECK are interleaved in one array, so every transition only touches one array slot.
+     *  This class is meant for exact-match lookups on hot read-only tables, it does not support modifications after building.
+     *
+     * @tparam value_t the datatype stored by the std::shared_ptr's
+     */
+    template<typename value_t>
+    class double_array_trie
+    {
+    protected:
+        struct unit
+        {
+            int32_t base; // offset of the children of this state, 0 for states without children
+            int32_t check; // parent state of this state, -1 for unused slots, root_check for the root
+            int32_t value; // index into the value array, -1 for states without value
+        };
+
+        static constexpr int32_t root_check = std::numeric_limits<int32_t>::max(); // reserve_units() keeps every state index below it
+
+        std::vector<unit> _units;
+        std::vector<std::shared_ptr<value_t> > _values;
+
+        /**
+         * @brief makes sure that the unit array holds at least 'count' units
+         * @throws std::bad_alloc from std::vector::resize
+         */
+        void reserve_units(std::size_t count);
+        /**
+         * @brief get the state reached from the root state by consuming all bytes of 'key', -1 if the state does not exist
+         */
+        int32_t find_state(std::string_view key) const;
+
+    public:
+        double_array_trie() { this->clear(); }
+        /**
+         * @brief construct a double-array trie holding all values of the source trie
+         * @throws std::bad_alloc
+         */
+        double_array_trie(trie::basic_trie<256, value_t>& source) { this->build(source); }
+        ~double_array_trie() {}
+
+        /**
+         * @brief rebuild this trie from all values stored in the source trie. The source trie is not modified.
+         *  The arrays are packed by placing every state's children into the first gap they fit into.
+         *
+         * @param source which trie to compile
+         * @throws std::bad_alloc
+         * @throws std::length_error if the compiled trie exceeds the 32-bit state range
+         */
+        void build(trie::basic_trie<256, value_t>& source);
+        /**
+         * @brief resets the trie into the valid empty state
+         */
+        void clear();
+
+        /**
+         * @brief check if a value is stored at a key
+         */
+        bool contains(std::string_view key) const { return this->find(key) != nullptr; }
+        /**
+         * @brief get a pointer to the stored value pointer, nullptr if no value is stored at the key
+         *  This does not copy the std::shared_ptr, so no reference counting is involved in the lookup
+         */
+        const std::shared_ptr<value_t>* find(std::string_view key) const;
+        /**
+         * @brief get the pointer to the value stored at a key
+         *
+         * @param key the key to the value
+         * @return reference to a std::shared_ptr of value type
+         * @throws std::out_of_range if the trie does not store a value at the key
+         */
+        const std::shared_ptr<value_t>& at(std::string_view key) const;
+
+        /**
+         * @brief get the number of values stored in the trie, this has a complexity of O(1)
+         */
+        std::size_t size() const { return this->_values.size(); }
+        /**
+         * @brief get the number of array slots (used and unused) of the double array
+         */
+        std::size_t unit_count() const { return this->_units.size(); }
+        /**
+         * @brief get the number of bytes used by the double array and the value array (not including the values themselves)
+         */
+        std::size_t memory_usage() const;
+    }; // class double_array_trie
+} // namespace trie
@@ -0,0 +1,265 @@
+/**
+* @file     trie/hat_trie.hpp
+* @brief    include file for the hybrid trie class with burst containers at the leaves
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include "basic_key.hpp"
+
+namespace trie
+{
+    /**
+     * @brief hybrid trie (HAT-trie) mapping keys to pointers. The top levels are regular trie nodes,
+     *  below them every sparse subtree is stored as a bucket: one contiguous element buffer holding the key suffixes
+     *  and an array of entries with a cached hash of every suffix. A lookup only walks the few top levels and then probes
+     *  the open addressing index of a single bucket, only entries with the same hash have their elements compared.
+     *  If a bucket holds more than 'burst_threshold' keys, it bursts into a trie node with one new bucket per child.
+     *  Buckets are unordered, they are sorted on demand when they are iterated, so iteration is still ordered by key.
+     *  Erasing keys removes empty buckets and merges the buckets of a burst node back into one, once they fit into half a bucket.
+     *  This is a separate class rather than the top levels of basic_trie, since the node iterators, subtrie() and the tails of
+     *  basic_trie expect a node for every key element, a key inside a bucket has no node that could be returned.
+     *
+     * @tparam children_count number of possible states for one key element. MUST be one of: 2, 4, 16, 256
+     * @tparam value_t the datatype stored by the std::shared_ptr's
+     */
+    template<std::size_t children_count, typename value_t>
+    class hat_trie
+    {
+    public:
+        using key_t = trie::basic_key<children_count>;
+        static constexpr std::size_t default_burst_threshold = 128;
+    protected:
+        struct bucket
+        {
+            struct entry
+            {
+                uint64_t hash;
+                uint32_t offset; // position of the suffix in the element buffer
+                uint32_t length; // number of key elements of the suffix
+                std::shared_ptr<value_t> data;
+            };
+            static constexpr std::size_t element_bits = (children_count == 2) ? 1 : (children_count == 4) ? 2 : (children_count == 16) ? 4 : 8;
+            std::vector<uint8_t> elements; // suffixes of all entries, packed like basic_key with 8 / element_bits key elements per byte
+            std::size_t element_count{ 0 }; // number of key elements in the buffer, offsets and lengths count key elements
+            std::vector<entry> entries;
+            std::vector<uint32_t> slots; // open addressing index of the entries by hash with linear probing, entry index + 1 or 0 for a free slot
+            std::size_t garbage{ 0 }; // number of key elements in the buffer that belong to erased entries
+            bool sorted{ true };
+
+            /**
+             * @brief get the first slot probed for a hash, the slot count is always a power of two
+             */
+            std::size_t home_slot(uint64_t key_hash) const { return (std::size_t)(key_hash ^ (key_hash >> 29)) & (this->slots.size() - 1); }
+            /**
+             * @brief get the slot holding the entry with the index 'index', the entry must be in the index
+             */
+            std::size_t slot_of(std::size_t index) const;
+            /**
+             * @brief add the entry with the index 'index' to the slots, the slots are rebuilt with more room if they get more than 3/4 full
+             * @throws std::bad_alloc from std::vector::assign
+             */
+            void index_entry(std::size_t index);
+            /**
+             * @brief rebuild the slots for all entries, at most half of the new slots are used
+             * @throws std::bad_alloc from std::vector::assign
+             */
+            void rebuild_index();
+
+            /**
+             * @brief get the key element at the position 'position' of a packed element buffer
+             */
+            static uint8_t element_at(const std::vector<uint8_t>& buffer, std::size_t position)
+            {
+                return (uint8_t)((buffer[position * element_bits / 8] >> (position * element_bits % 8)) & (children_count - 1));
+            }
+            /**
+             * @brief get the key element at the position 'position' of the element buffer
+             */
+            uint8_t get_element(std::size_t position) const { return element_at(this->elements, position); }
+            /**
+             * @brief append a key element to the element buffer, a new byte is only added if the last one is full
+             * @throws std::bad_alloc from std::vector::push_back
+             */
+            void push_element(uint8_t element);
+            /**
+             * @brief check if the suffix of the entry 'left' is ordered before the suffix of the entry 'right'
+             */
+            bool less(const entry& left, const entry& right) const;
+
+            /**
+             * @brief calculate the hash of the key elements [offset, key.size()) of a key
+             */
+            static uint64_t hash(const key_t& _key, std::size_t offset);
+            /**
+             * @brief get the index of the entry holding the suffix [offset, key.size()) of the key, -1 if there is no such entry
+             */
+            std::ptrdiff_t find(const key_t& _key, std::size_t offset, uint64_t key_hash) const;
+            /**
+             * @brief append a new entry for the suffix [offset, key.size()) of the key, the suffix must not be stored already
+             * @return reference to the data pointer of the new entry
+             * @throws std::bad_alloc from std::vector::push_back
+             */
+            std::shared_ptr<value_t>& insert(const key_t& _key, std::size_t offset, uint64_t key_hash);
+            /**
+             * @brief append a new entry for a suffix of 'length' key elements, the suffix must not be stored already
+             * @param element_of callable that returns the key element at an index of the suffix
+             * @throws std::bad_alloc from std::vector::push_back
+             */
+            template<typename element_source>
+            void append(std::size_t length, std::shared_ptr<value_t> data, element_source element_of);
+            /**
+             * @brief remove the entry with the index 'index', the last entry is moved into its place
+             */
+            void erase(std::size_t index);
+            /**
+             * @brief sort the entries by their suffix, the element buffer is rewritten in the new order
+             */
+            void sort();
+        };
+
+        struct node
+        {
+            std::array<std::shared_ptr<node>, children_count> children;
+            std::shared_ptr<value_t> data;
+            bool has_data{ false }; // true if a key ends at this node, the data pointer itself may be a nullptr
+            std::shared_ptr<bucket> container; // if set, all keys below this node are stored in this bucket and the node has no children and no data
+
+            /**
+             * @brief get the node's child with the index key_element
+             * @throws std::out_of_range from std::array::at if the parameter is bigger than the number of children supported by the trie
+             */
+            std::shared_ptr<node>& child(std::size_t key_element) { return this->children.at(key_element); }
+        };
+
+        std::shared_ptr<node> _root;
+        std::size_t _size;
+        std::size_t _burst_threshold;
+
+        /**
+         * @brief split the bucket of a node into one bucket per child, repeated for every new bucket that is still too big
+         * @throws std::bad_alloc from std::make_shared()
+         */
+        void burst(node* _node);
+        /**
+         * @brief move all keys of a burst node, whose children are all buckets, back into a single bucket at the node
+         * @throws std::bad_alloc from std::make_shared()
+         */
+        void merge(node* _node);
+        /**
+         * @brief remove the empty nodes after an erase from the bottom up, then merge the burst nodes above it that fit into half a bucket
+         * @param path the ancestors of the node, each with the key element that leads to the next node on the path
+         */
+        void prune(std::vector<std::pair<node*, uint8_t> >& path, node* _node);
+        /**
+         * @brief get a pointer to the data pointer stored at the key, nullptr if the key is not stored
+         */
+        std::shared_ptr<value_t>* find(const key_t& _key) const;
+
+    public:
+        hat_trie(std::size_t burst_threshold = default_burst_threshold) : _burst_threshold(burst_threshold) { this->clear(); }
+        ~hat_trie() {}
+
+        hat_trie(hat_trie&& src) noexcept = default;
+        hat_trie& operator=(hat_trie&& src) noexcept = default;
+        hat_trie(const hat_trie& src) = delete; // disable copy constructing
+        hat_trie& operator=(const hat_trie& src) = delete; // disable copy assignments
+
+        /**
+         * @brief check if a value is stored at a key
+         */
+        bool contains(const key_t& key) const { return this->find(key) != nullptr; }
+        /**
+         * @brief get the pointer to the value stored at a key
+         *
+         * @param key the key to the value
+         * @return reference to a std::shared_ptr of value type
+         * @throws std::out_of_range if the trie does not store the key
+         */
+        std::shared_ptr<value_t>& at(const key_t& key);
+        /**
+         * @brief insert a pointer to a value into the trie
+         *
+         * @param key the key where to store the value
+         * @param value the pointer to the value that should be stored
+         * @return true if the value could be inserted, false if the key was already stored
+         * @throws std::bad_alloc
+         */
+        bool insert(const key_t& key, std::shared_ptr<value_t> value);
+        /**
+         * @brief remove a single key from the trie, the other keys below it are not affected
+         *
+         * @param key the key that should be removed
+         * @return true to indicate that the key has been removed, false if the key was not stored
+         */
+        bool erase(const key_t& key);
+        /**
+         * @brief removes all keys from the trie and resets it into the valid empty state
+         */
+        void clear();
+        /**
+         * @brief returns the number of keys stored in the trie, this has a complexity of O(1)
+         */
+        std::size_t size() const { return this->_size; }
+        /**
+         * @brief returns the number of nodes in the trie, a node holding a bucket counts as one node. This has a complexity of O(n)
+         */
+        std::size_t node_count() const;
+
+        /**
+         * @brief forward iterator over all keys in key order. Every bucket is sorted when the iterator enters it,
+         *  so modifying the trie invalidates all iterators.
+         */
+        class value_iterator
+        {
+        protected:
+            struct frame
+            {
+                node* current;
+                std::ptrdiff_t next_child; // -1 if the node's own data was not visited yet
+            };
+            std::vector<frame> _stack;
+            key_t cur_key;
+            std::shared_ptr<value_t>* cur_data{ nullptr };
+            bucket* cur_bucket{ nullptr };
+            std::size_t cur_entry{ 0 };
+
+            void push_suffix();
+            void pop_suffix();
+            void next_value();
+
+        public:
+            value_iterator() {}
+            value_iterator(node* root);
+            ~value_iterator() {}
+
+            inline bool operator==(const value_iterator& other) const { return this->cur_data == other.cur_data; }
+            inline bool operator!=(const value_iterator& other) const { return !(*this == other); }
+
+            inline bool is_null() const { return this->cur_data == nullptr; }
+            inline operator bool() const { return !this->is_null(); }
+            inline bool operator!() const { return this->is_null(); }
+
+            /**
+             * @brief Get the key of where the iterator is currently at
+             */
+            inline const key_t& get_key() const { return this->cur_key; }
+            /**
+             * @brief Get the data pointer of where the iterator is currently at
+             */
+            inline std::shared_ptr<value_t>& get_data() const { return *this->cur_data; }
+
+            value_iterator& operator++() { this->next_value(); return *this; }
+            value_iterator operator++(int) { value_iterator copy = *this; this->next_value(); return copy; }
+        }; // class value_iterator
+
+        value_iterator begin() { return value_iterator(this->_root.get()); }
+        value_iterator end() { return value_iterator(); }
+    }; // class hat_trie
+} // namespace trie
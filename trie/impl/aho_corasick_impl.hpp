@@ -0,0 +1,138 @@
+/**
+* @file     trie/impl/aho_corasick_impl.hpp
+* @brief    include file for the implementations for the multi-pattern matching automaton
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "../aho_corasick.hpp"
+
+template<typename value_t>
+void
+trie::aho_corasick<value_t>::build(trie::basic_trie<256, value_t>& source)
+{
+    std::vector<std::pair<std::string, std::shared_ptr<value_t> > > keys;
+    std::vector<uint32_t> failure;
+    std::vector<uint32_t> queue;
+    std::array<bool, 256> used{};
+    uint32_t current, target;
+
+    source.for_each(trie::basic_key<256>(), [&keys, &used](const trie::basic_key<256>& key, std::shared_ptr<value_t>& data)
+        {
+            if (key.size() == 0) return;
+            keys.emplace_back(key.to_string(), data);
+            for (char byte : keys.back().first) used[(uint8_t)byte] = true;
+        });
+    this->clear();
+    for (std::size_t i = 0; i < 256; i++)
+    {
+        if (used[i]) this->_byte_class[i] = (uint16_t)this->_class_count++;
+    }
+
+    // goto function, a transition to state 0 means there is no edge yet
+    auto add_state = [this]() -> uint32_t
+    {
+        if (this->_pattern.size() >= (std::size_t)std::numeric_limits<uint32_t>::max()) throw std::length_error("Automaton exceeds the 32-bit state range");
+        this->_transitions.resize(this->_transitions.size() + this->_class_count, 0);
+        this->_pattern.push_back(npos);
+        return (uint32_t)(this->_pattern.size() - 1);
+    };
+    this->_transitions.assign(this->_class_count, 0);
+    for (const std::pair<std::string, std::shared_ptr<value_t> >& key : keys)
+    {
+        current = 0;
+        for (char byte : key.first)
+        {
+            target = this->_transitions[current * this->_class_count + this->_byte_class[(uint8_t)byte]];
+            if (target == 0)
+            {
+                target = add_state();
+                this->_transitions[current * this->_class_count + this->_byte_class[(uint8_t)byte]] = target;
+            }
+            current = target;
+        }
+        this->_pattern[current] = (uint32_t)this->_values.size();
+        this->_lengths.push_back(key.first.size());
+        this->_values.push_back(key.second);
+    }
+
+    // breadth first, the failure link of a state always points to a state closer to the root, whose row is already complete
+    failure.assign(this->_pattern.size(), 0);
+    this->_first_output.assign(this->_pattern.size(), npos);
+    this->_next_output.assign(this->_pattern.size(), npos);
+    queue.push_back(0);
+    for (std::size_t i = 0; i < queue.size(); i++)
+    {
+        current = queue[i];
+        for (std::size_t byte_class = 0; byte_class < this->_class_count; byte_class++)
+        {
+            uint32_t& transition = this->_transitions[current * this->_class_count + byte_class];
+            if (transition == 0)
+            {
+                // no edge, continue like the failure state would (the root state stays at the root)
+                transition = (current == 0) ? 0 : this->_transitions[failure[current] * this->_class_count + byte_class];
+                continue;
+            }
+            target = transition;
+            failure[target] = (current == 0) ? 0 : this->_transitions[failure[current] * this->_class_count + byte_class];
+            this->_next_output[target] = this->_first_output[failure[target]];
+            this->_first_output[target] = (this->_pattern[target] != npos) ? target : this->_next_output[target];
+            queue.push_back(target);
+        }
+    }
+}
+
+template<typename value_t>
+void
+trie::aho_corasick<value_t>::clear()
+{
+    this->_byte_class.fill(0);
+    this->_class_count = 1; // class 0 holds all bytes that are not used by any key
+    this->_transitions.assign(1, 0);
+    this->_first_output.assign(1, npos);
+    this->_next_output.assign(1, npos);
+    this->_pattern.assign(1, npos);
+    this->_lengths.clear();
+    this->_values.clear();
+}
+
+template<typename value_t>
+std::size_t
+trie::aho_corasick<value_t>::memory_usage() const
+{
+    return sizeof(this->_byte_class) + (this->_transitions.capacity() + this->_first_output.capacity() + this->_next_output.capacity() + this->_pattern.capacity()) * sizeof(uint32_t)
+        + this->_lengths.capacity() * sizeof(std::size_t) + this->_values.capacity() * sizeof(std::shared_ptr<value_t>);
+}
+
+template<typename value_t>
+template<typename callback_t>
+void
+trie::aho_corasick<value_t>::stream::feed(const void* data, std::size_t length, callback_t callback)
+{
+    const aho_corasick& automaton = *this->_automaton;
+    const uint8_t* input = (const uint8_t*)data;
+    const uint32_t* transitions = automaton._transitions.data();
+    const std::size_t class_count = automaton._class_count;
+    uint32_t state = this->_state;
+    for (std::size_t i = 0; i < length; i++)
+    {
+        state = transitions[state * class_count + automaton._byte_class[input[i]]];
+        for (uint32_t output = automaton._first_output[state]; output != npos; output = automaton._next_output[output])
+        {
+            uint32_t pattern = automaton._pattern[output];
+            callback(this->_position + i + 1, automaton._lengths[pattern], automaton._values[pattern]);
+        }
+    }
+    this->_state = state;
+    this->_position += length;
+}
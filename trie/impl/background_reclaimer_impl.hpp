@@ -0,0 +1,70 @@
+/**
+* @file     trie/impl/background_reclaimer_impl.hpp
+* @brief    include file for the implementations for the background reclaimer class
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include "../background_reclaimer.hpp"
+
+inline
+trie::background_reclaimer::~background_reclaimer()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_stopping = true;
+    }
+    this->_changed.notify_all();
+    this->_thread.join();
+}
+
+inline void
+trie::background_reclaimer::run()
+{
+    std::unique_lock<std::mutex> lock(this->_mutex);
+    while (true)
+    {
+        this->_changed.wait(lock, [this]() { return !this->_queue.empty() || this->_stopping; });
+        if (this->_queue.empty()) return; // only stop after the queue is empty
+        std::shared_ptr<void> pointer = std::move(this->_queue.front());
+        this->_queue.pop_front();
+        ++this->_busy;
+        // release the pointer without holding the lock, so retire() does not have to wait for the teardown
+        lock.unlock();
+        pointer.reset();
+        lock.lock();
+        --this->_busy;
+        this->_changed.notify_all();
+    }
+}
+
+inline void
+trie::background_reclaimer::retire(std::shared_ptr<void> pointer)
+{
+    if (pointer == nullptr) return;
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_queue.push_back(std::move(pointer));
+    }
+    this->_changed.notify_all();
+}
+
+inline void
+trie::background_reclaimer::drain()
+{
+    std::unique_lock<std::mutex> lock(this->_mutex);
+    this->_changed.wait(lock, [this]() { return this->_queue.empty() && this->_busy == 0; });
+}
+
+inline std::size_t
+trie::background_reclaimer::pending()
+{
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    return this->_queue.size() + this->_busy;
+}
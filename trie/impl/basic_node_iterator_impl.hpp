@@ -21,6 +21,28 @@ trie::basic_trie<children_count, value_t>::basic_node_iterator::operator==(const
     return this->cur_node == other.cur_node;
 }
 
+template<std::size_t children_count, typename value_t>
+void
+trie::basic_trie<children_count, value_t>::basic_node_iterator::push_tail() const
+{
+    cur_tail = (cur_node->tail == nullptr) ? 0 : cur_node->tail->size();
+    for (std::size_t i = 0; i < cur_tail; i++)
+    {
+        cur_key.push_back(cur_node->tail->get_element(i));
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::basic_trie<children_count, value_t>::basic_node_iterator::pop_tail() const
+{
+    // the stored length is used, the node's tail might have been expanded since it was pushed
+    for (; cur_tail > 0; cur_tail--)
+    {
+        cur_key.pop_back();
+    }
+}
+
 template<std::size_t children_count, typename value_t>
 void
 trie::basic_trie<children_count, value_t>::basic_node_iterator::next_node() const
@@ -32,6 +54,7 @@ trie::basic_trie<children_count, value_t>::basic_node_iterator::next_node() cons
         {
             cur_node = root_node;
             cur_key.clear();
+            cur_tail = 0;
             child_element = 0;
             return;
         }
@@ -43,6 +66,7 @@ trie::basic_trie<children_count, value_t>::basic_node_iterator::next_node() cons
                 // if a child was found, go to child node and stop iterating
                 cur_node = cur_node->child(i);
                 cur_key.push_back((uint8_t)i);
+                this->push_tail();
                 child_element = 0;
                 return;
             }
@@ -52,11 +76,14 @@ trie::basic_trie<children_count, value_t>::basic_node_iterator::next_node() cons
         {
             cur_node = nullptr;
             cur_key.clear();
+            cur_tail = 0;
             child_element = 0;
             return;
         }
+        this->pop_tail();
         child_element = (std::ptrdiff_t)cur_key.get_element(cur_key.size() - 1) + 1;
         cur_key.pop_back();
+        TRIE_INSTRUMENT_COUNT(iterator_rewalks);
         cur_node = trie::basic_trie<children_count, value_t>(root_node).get_node(cur_key);
     }
 }
@@ -69,19 +96,23 @@ trie::basic_trie<children_count, value_t>::basic_node_iterator::prev_node() cons
     {
         cur_node = root_node;
         cur_key.clear();
+        cur_tail = 0;
         child_element = children_count - 1;
     }
     else if (cur_node == root_node)
     {
         cur_node = nullptr;
         cur_key.clear();
+        cur_tail = 0;
         child_element = 0;
         return;
     }
     else
     {
+        this->pop_tail();
         child_element = (std::ptrdiff_t)cur_key.get_element(cur_key.size() - 1) - 1;
         cur_key.pop_back();
+        TRIE_INSTRUMENT_COUNT(iterator_rewalks);
         cur_node = trie::basic_trie<children_count, value_t>(root_node).get_node(cur_key);
     }
 
@@ -93,6 +124,7 @@ trie::basic_trie<children_count, value_t>::basic_node_iterator::prev_node() cons
             {
                 cur_node = cur_node->child(i);
                 cur_key.push_back((uint8_t)i);
+                this->push_tail();
                 child_element = children_count - 1;
                 i = child_element + 1;
             }
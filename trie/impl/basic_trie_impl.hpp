@@ -11,6 +11,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
 #include "../basic_trie.hpp"
 
 template<std::size_t children_count, typename value_t>
@@ -20,66 +24,209 @@ trie::basic_trie<children_count, value_t>::node::child(std::size_t key_element)
     return this->children.at(key_element);
 }
 
+template<std::size_t children_count, typename value_t>
+trie::basic_trie<children_count, value_t>::node::~node()
+{
+    TRIE_INSTRUMENT_COUNT(node_frees);
+    // children only owned by this node are moved onto a local stack and released one at a time.
+    // When one of them is destroyed, all of its own children have been moved away already, so the destructors never nest deeper than one level.
+    // The stack is linked through the first child slot of the pending nodes, so the destructor does not allocate and can not throw.
+    std::shared_ptr<node> pending, next;
+    auto push = [&pending, &next](std::shared_ptr<node> current)
+    {
+        while (current != nullptr)
+        {
+            // the first child is moved out of the way of the link and pushed next, a shared child is only released
+            next = std::move(current->children[0]);
+            current->children[0] = std::move(pending);
+            pending = std::move(current);
+            if (next != nullptr && next.use_count() == 1) current = std::move(next);
+            else next = nullptr;
+        }
+    };
+    for (std::shared_ptr<node>& child : this->children)
+    {
+        if (child != nullptr && child.use_count() == 1) push(std::move(child));
+    }
+    while (pending != nullptr)
+    {
+        std::shared_ptr<node> current = std::move(pending);
+        pending = std::move(current->children[0]);
+        for (std::size_t i = 1; i < children_count; i++)
+        {
+            if (current->children[i] != nullptr && current->children[i].use_count() == 1) push(std::move(current->children[i]));
+        }
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+std::size_t
+trie::basic_trie<children_count, value_t>::common_length(const key_t& tail, const key_t& key, std::size_t offset)
+{
+    std::size_t length = 0;
+    while (length < tail.size() && offset + length < key.size() && tail.get_element(length) == key.get_element(offset + length)) ++length;
+    return length;
+}
+
+template<std::size_t children_count, typename value_t>
+typename trie::basic_trie<children_count, value_t>::key_t
+trie::basic_trie<children_count, value_t>::make_tail(const key_t& key, std::size_t first)
+{
+    key_t result;
+    for (std::size_t i = first; i < key.size(); i++)
+    {
+        result.push_back(key.get_element(i));
+    }
+    return result;
+}
+
 template<std::size_t children_count, typename value_t>
 std::shared_ptr< typename trie::basic_trie<children_count, value_t>::node >
-trie::basic_trie<children_count, value_t>::get_node(const key_t& key)
+trie::basic_trie<children_count, value_t>::split_tail(std::shared_ptr<node> _node, std::size_t levels)
 {
-    std::shared_ptr<node> helper = _root, child;
-    for (std::size_t i = 0; i < key.size(); i++)
+    std::shared_ptr<key_t> tail = _node->tail;
+    std::shared_ptr<value_t> data = _node->data;
+    std::shared_ptr<node> helper = _node;
+    _node->tail = nullptr; // the node becomes a regular inner node
+    _node->data = nullptr;
+    for (std::size_t i = 0; i < levels; i++)
     {
-        child = helper->child(key.get_element(i)); // get the child item
-        if (child == nullptr) return nullptr; // return a nullptr if the node does not exist
-        helper = child; // set the helper pointer to the child and proceed to the next key element
+        helper = helper->child(tail->get_element(i)) = std::make_shared<node>(); // create one real node per expanded tail element
     }
+    if (levels < tail->size())
+    {
+        helper->tail = std::make_shared<key_t>(make_tail(*tail, levels)); // the deepest node keeps the part of the tail that was not expanded
+    }
+    helper->data = data;
     return helper;
 }
 
 template<std::size_t children_count, typename value_t>
 std::shared_ptr< typename trie::basic_trie<children_count, value_t>::node >
-trie::basic_trie<children_count, value_t>::add_node(const key_t& key)
+trie::basic_trie<children_count, value_t>::get_node(const key_t& key, bool& in_tail) const
+{
+    const std::shared_ptr<node>* helper = &this->_root;
+    std::size_t matched;
+    in_tail = false;
+    for (std::size_t i = 0; ; i++)
+    {
+        TRIE_INSTRUMENT_COUNT(lookup_nodes_visited);
+        const node* current = helper->get();
+        if (current->tail != nullptr)
+        {
+            matched = common_length(*current->tail, key, i);
+            if (i + matched != key.size()) return nullptr; // the key diverges from the tail or continues after it, so the node does not exist
+            in_tail = matched != current->tail->size(); // the key ends inside of the tail or exactly at its end
+            return *helper;
+        }
+        if (i == key.size()) return *helper;
+        helper = &current->children[key.get_element(i)]; // get the child item
+        if (*helper == nullptr) return nullptr; // return a nullptr if the node does not exist
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+std::shared_ptr< typename trie::basic_trie<children_count, value_t>::node >
+trie::basic_trie<children_count, value_t>::get_node(const key_t& key) const
+{
+    bool in_tail;
+    std::shared_ptr<node> result = this->get_node(key, in_tail);
+    return in_tail ? nullptr : result;
+}
+
+template<std::size_t children_count, typename value_t>
+std::shared_ptr< typename trie::basic_trie<children_count, value_t>::node >
+trie::basic_trie<children_count, value_t>::add_node(const key_t& key, bool use_tail)
 {
     std::shared_ptr<node> helper = _root, child;
+    std::size_t matched;
     // search for the requested child node and create any nodes that are missing
-    for (std::size_t i = 0; i < key.size(); i++)
+    for (std::size_t i = 0; ; i++)
     {
+        TRIE_INSTRUMENT_COUNT(insert_nodes_visited);
+        if (helper->tail != nullptr)
+        {
+            matched = common_length(*helper->tail, key, i);
+            if (i + matched == key.size() && matched == helper->tail->size()) return helper; // the node already stores exactly this key
+            // another key diverges from the tail, expand the common part and the diverging element into real nodes
+            this->split_tail(helper, std::min(matched + 1, helper->tail->size()));
+        }
+        if (i == key.size()) return helper;
         child = helper->child(key.get_element(i)); // get the child item
         if (child == nullptr)
         {
             child = helper->child(key.get_element(i)) = std::make_shared<node>(); // if the child item is empty, allocate a new one and set the helper pointer to it
+            if (use_tail && i + 1 < key.size())
+            {
+                // nothing else is stored below the new node, store the remaining key elements as its tail
+                child->tail = std::make_shared<key_t>(make_tail(key, i + 1));
+                return child;
+            }
         }
         helper = child;
     }
-    return helper;
 }
 
 template<std::size_t children_count, typename value_t>
-bool
-trie::basic_trie<children_count, value_t>::unlink_node(const key_t& key)
+std::shared_ptr< typename trie::basic_trie<children_count, value_t>::node >
+trie::basic_trie<children_count, value_t>::extract_node(const key_t& key)
 {
-    std::shared_ptr<node> helper = _root, child;
-    for (std::size_t i = 0; i < key.size()-1; i++) // stop 1 step before arriving at the wanted node
+    std::shared_ptr<node> parent = nullptr, helper = _root, child;
+    uint8_t element = 0;
+    if (key.size() == 0) throw std::out_of_range("The root node can not be unlinked");
+    for (std::size_t i = 0; i < key.size(); i++)
     {
+        TRIE_INSTRUMENT_COUNT(erase_nodes_visited);
+        if (helper->tail != nullptr)
+        {
+            if (i + common_length(*helper->tail, key, i) != key.size()) return nullptr; // return a nullptr if the node does not exist
+            if (key.size() - i == helper->tail->size())
+            {
+                // the key ends exactly at the end of the tail, the whole node with its tail is unlinked
+                parent->child(element) = nullptr;
+                return helper;
+            }
+            // the requested node is inside of this node's tail, expand the tail up to it so the parent nodes of the requested node stay in the trie
+            this->split_tail(helper, key.size() - i);
+        }
         child = helper->child(key.get_element(i)); // get the child item
-        if (child == nullptr) return false; // return false if the node does not exist
+        if (child == nullptr) return nullptr; // return a nullptr if the node does not exist
+        parent = helper;
+        element = key.get_element(i);
         helper = child; // set the helper pointer to the child and proceed to the next key element
     }
-    helper->child(key.get_element(key.size() - 1)) = nullptr; // set the child pointer to a nullptr to unlink it from the trie
-    return true;
+    parent->child(element) = nullptr; // set the child pointer to a nullptr to unlink it from the trie
+    return helper;
+}
+
+template<std::size_t children_count, typename value_t>
+bool
+trie::basic_trie<children_count, value_t>::unlink_node(const key_t& key)
+{
+    return this->extract_node(key) != nullptr;
 }
 
 template<std::size_t children_count, typename value_t>
 bool
 trie::basic_trie<children_count, value_t>::has_node(const key_t& key)
 {
-    return this->get_node(key) != nullptr;
+    TRIE_INSTRUMENT_TIME(lookup);
+    bool in_tail;
+    if (this->filter_rejects_node(key)) return false;
+    return this->get_node(key, in_tail) != nullptr;
 }
 
 template<std::size_t children_count, typename value_t>
 std::shared_ptr<value_t>&
 trie::basic_trie<children_count, value_t>::at(const key_t& key)
 {
-    std::shared_ptr<node> _node = this->get_node(key); // get the node containing the child
+    TRIE_INSTRUMENT_TIME(lookup);
+    bool in_tail;
+    if (this->filter_rejects_node(key)) throw std::out_of_range("Trie does not have the requested child");
+    std::shared_ptr<node> _node = this->get_node(key, in_tail); // get the node containing the child
     if (_node == nullptr) throw std::out_of_range("Trie does not have the requested child"); // throw exception if child does not exists
+    if (in_tail) _node = this->add_node(key, false); // a node inside of a tail has no node object, expand the tail up to it
+    if (_node->data == nullptr) this->filter_mark_stale(); // the caller might store a value through the returned reference
     return _node->data; // return data
 }
 
@@ -87,7 +234,9 @@ template<std::size_t children_count, typename value_t>
 std::shared_ptr<value_t>&
 trie::basic_trie<children_count, value_t>::operator[](const key_t& key)
 {
+    TRIE_INSTRUMENT_TIME(insert);
     std::shared_ptr<node> _node = this->add_node(key); // get / add the node containing the child
+    this->filter_add(key);
     return _node->data; // return data
 }
 
@@ -95,11 +244,13 @@ template<std::size_t children_count, typename value_t>
 bool
 trie::basic_trie<children_count, value_t>::insert(const key_t& key, std::shared_ptr<value_t> value)
 {
+    TRIE_INSTRUMENT_TIME(insert);
     std::shared_ptr<node> helper = this->add_node(key);
     if (helper->data == nullptr)
     {
         // if the node does not contain data, set the data and return true
         helper->data = value;
+        this->filter_add(key);
         return true;
     }
     else
@@ -109,10 +260,217 @@ trie::basic_trie<children_count, value_t>::insert(const key_t& key, std::shared_
     }
 }
 
+template<std::size_t children_count, typename value_t>
+std::size_t
+trie::basic_trie<children_count, value_t>::insert_batch(const std::vector<std::pair<key_t, std::shared_ptr<value_t> > >& pairs)
+{
+    TRIE_INSTRUMENT_TIME(insert);
+    std::shared_ptr<node> helper;
+    std::size_t counter = 0;
+    for (const std::pair<key_t, std::shared_ptr<value_t> >& current : pairs)
+    {
+        helper = this->add_node(current.first);
+        if (helper->data == nullptr)
+        {
+            helper->data = current.second;
+            this->filter_add(current.first);
+            ++counter;
+        }
+    }
+    return counter;
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::basic_trie<children_count, value_t>::filter_add(const key_t& key)
+{
+    // the filters of the tries this subtrie was taken from store the keys with the subtrie's prefix, which is not known here
+    for (const std::shared_ptr<bool>& stale : this->_outer_filters_stale) *stale = true;
+    if (this->_filter == nullptr) return;
+    uint64_t hash = filter_seed;
+    std::size_t next_prefix = 0;
+    for (std::size_t i = 0; ; i++)
+    {
+        if (next_prefix < this->_filter_prefix_lengths.size() && this->_filter_prefix_lengths[next_prefix] == i)
+        {
+            if (i != key.size()) this->_filter->add(hash); // a prefix as long as the key is the key itself
+            ++next_prefix;
+        }
+        if (i == key.size()) break;
+        hash = filter_hash(hash, key.get_element(i));
+    }
+    this->_filter->add(hash);
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::basic_trie<children_count, value_t>::filter_mark_stale()
+{
+    if (this->_filter != nullptr) *this->_filter_stale = true;
+    for (const std::shared_ptr<bool>& stale : this->_outer_filters_stale) *stale = true;
+}
+
+template<std::size_t children_count, typename value_t>
+bool
+trie::basic_trie<children_count, value_t>::filter_rejects_node(const key_t& key) const
+{
+    if (!this->filter_usable()) return false;
+    // the longest configured prefix length that is not longer than the key
+    auto prefix = std::upper_bound(this->_filter_prefix_lengths.begin(), this->_filter_prefix_lengths.end(), key.size());
+    if (prefix == this->_filter_prefix_lengths.begin()) return false;
+    uint64_t hash = filter_seed;
+    for (std::size_t i = 0; i < *(prefix - 1); i++)
+    {
+        hash = filter_hash(hash, key.get_element(i));
+    }
+    return !this->_filter->may_contain(hash);
+}
+
+template<std::size_t children_count, typename value_t>
+std::shared_ptr<value_t>
+trie::basic_trie<children_count, value_t>::find(const key_t& key) const
+{
+    TRIE_INSTRUMENT_TIME(lookup);
+    if (this->filter_usable())
+    {
+        uint64_t hash = filter_seed;
+        for (std::size_t i = 0; i < key.size(); i++)
+        {
+            hash = filter_hash(hash, key.get_element(i));
+        }
+        if (!this->_filter->may_contain(hash)) return nullptr;
+    }
+    const node* current = this->_root.get();
+    for (std::size_t i = 0; ; i++)
+    {
+        TRIE_INSTRUMENT_COUNT(lookup_nodes_visited);
+        if (current->tail != nullptr)
+        {
+            std::size_t matched = common_length(*current->tail, key, i);
+            if (i + matched != key.size() || matched != current->tail->size()) return nullptr;
+            return current->data;
+        }
+        if (i == key.size()) return current->data;
+        current = current->children[key.get_element(i)].get();
+        if (current == nullptr) return nullptr;
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+std::vector<std::shared_ptr<value_t> >
+trie::basic_trie<children_count, value_t>::find_batch(const std::vector<key_t>& keys) const
+{
+    std::vector<std::shared_ptr<value_t> > result(keys.size());
+    std::vector<std::size_t> candidates;
+    candidates.reserve(keys.size());
+    if (this->filter_usable())
+    {
+        // the filter probes of the keys do not depend on each other, so they can overlap before the first dependent node load
+        for (std::size_t k = 0; k < keys.size(); k++)
+        {
+            uint64_t hash = filter_seed;
+            for (std::size_t i = 0; i < keys[k].size(); i++)
+            {
+                hash = filter_hash(hash, keys[k].get_element(i));
+            }
+            if (this->_filter->may_contain(hash)) candidates.push_back(k);
+        }
+    }
+    else
+    {
+        for (std::size_t k = 0; k < keys.size(); k++) candidates.push_back(k);
+    }
+    for (std::size_t k : candidates)
+    {
+        result[k] = this->find(keys[k]);
+    }
+    return result;
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::basic_trie<children_count, value_t>::enable_filter(double bits_per_key, std::vector<std::size_t> prefix_lengths)
+{
+    std::sort(prefix_lengths.begin(), prefix_lengths.end());
+    prefix_lengths.erase(std::unique(prefix_lengths.begin(), prefix_lengths.end()), prefix_lengths.end());
+    if (!prefix_lengths.empty() && prefix_lengths.front() == 0) prefix_lengths.erase(prefix_lengths.begin()); // every key has the empty prefix
+    this->_filter_prefix_lengths = std::move(prefix_lengths);
+    this->_filter_bits_per_key = bits_per_key;
+    this->_filter = std::make_unique<trie::bloom_filter>(0, bits_per_key); // rebuild_filter() only rebuilds an enabled filter
+    if (this->_filter_stale == nullptr) this->_filter_stale = std::make_shared<bool>(false);
+    this->rebuild_filter();
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::basic_trie<children_count, value_t>::rebuild_filter()
+{
+    if (this->_filter == nullptr) return;
+    struct frame
+    {
+        const node* current;
+        std::size_t next_child;
+        std::size_t base_length; // key length before the node's own key elements were appended
+    };
+    std::vector<frame> node_stack;
+    std::vector<uint64_t> hashes(1, filter_seed); // [key length] -> hash of the key prefix of the current node
+    std::vector<uint64_t> items;
+
+    // add the prefixes of a node key to the items if the node stores a value or is a leaf, the keys of all other nodes are prefixes of them
+    auto enter = [&](const node* current, std::size_t base_length)
+    {
+        bool leaf = current->tail != nullptr || std::all_of(current->children.begin(), current->children.end(), [](const std::shared_ptr<node>& child) { return child == nullptr; });
+        std::size_t length = hashes.size() - 1;
+        if (current->data != nullptr || (leaf && length > 0))
+        {
+            for (std::size_t prefix : this->_filter_prefix_lengths)
+            {
+                if (prefix >= length) break;
+                items.push_back(hashes[prefix]);
+            }
+            items.push_back(hashes[length]);
+        }
+        if (current->tail == nullptr) node_stack.push_back(frame{ current, 0, base_length });
+        else hashes.resize(base_length + 1);
+    };
+
+    enter(this->_root.get(), 0);
+    while (!node_stack.empty())
+    {
+        frame& top = node_stack.back();
+        while (top.next_child < children_count && top.current->children[top.next_child] == nullptr) ++top.next_child;
+        if (top.next_child == children_count)
+        {
+            hashes.resize(top.base_length + 1);
+            node_stack.pop_back();
+            continue;
+        }
+        const node* child = top.current->children[top.next_child].get();
+        std::size_t base_length = hashes.size() - 1;
+        hashes.push_back(filter_hash(hashes.back(), (uint8_t)top.next_child++));
+        if (child->tail != nullptr)
+        {
+            for (std::size_t i = 0; i < child->tail->size(); i++) hashes.push_back(filter_hash(hashes.back(), child->tail->get_element(i)));
+        }
+        enter(child, base_length); // the reference to the top frame is not used after this, enter might reallocate the stack
+    }
+
+    // keys sharing a prefix add the same prefix hash, the filter is sized for the distinct items
+    std::sort(items.begin(), items.end());
+    items.erase(std::unique(items.begin(), items.end()), items.end());
+    this->_filter = std::make_unique<trie::bloom_filter>(items.size(), this->_filter_bits_per_key);
+    for (uint64_t item : items)
+    {
+        this->_filter->add(item);
+    }
+    *this->_filter_stale = false;
+}
+
 template<std::size_t children_count, typename value_t>
 bool
 trie::basic_trie<children_count, value_t>::erase(const key_t& key)
 {
+    TRIE_INSTRUMENT_TIME(erase);
     return this->unlink_node(key); // unlink the node to effectively erase it from the trie
 }
 
@@ -120,43 +478,136 @@ template<std::size_t children_count, typename value_t>
 void
 trie::basic_trie<children_count, value_t>::merge(trie::basic_trie<children_count, value_t>& source)
 {
+    TRIE_INSTRUMENT_TIME(merge);
     // This method has to collect all nodes in reverse order from the source trie and then add them in forward order to this trie.
     std::shared_ptr<node> helper;
     std::vector<std::pair<key_t, std::shared_ptr<node> > > node_stack;
-    for (auto iter = source.node_rbegin(); iter != source.node_rend(); iter++)
+    // not source.node_rbegin(), which would mark the source's filter stale
+    for (auto iter = ++reverse_node_iterator(source._root); iter != reverse_node_iterator(source._root); iter++)
     {
-        helper = this->get_node(iter.get_key()); // check if this trie has the node
+        bool in_tail;
+        helper = this->get_node(iter.get_key(), in_tail); // check if this trie has the node, a node inside of a tail also counts
         if (helper == nullptr) // this trie does not have the node, extract if and push it onto the node stack
         {
-            node_stack.push_back(std::make_pair(iter.get_key(), source.get_node(iter.get_key())));
-            source.erase(iter.get_key());
+            node_stack.push_back(std::make_pair(iter.get_key(), source.extract_node(iter.get_key())));
         }
     }
     while (!node_stack.empty())
     {
         std::pair<key_t, std::shared_ptr<node> >& ref = node_stack.back(); // get a reference to the stored values
-        helper = this->add_node(ref.first); // add the jnode to this trie
+        // nodes with a tail are stored again with a tail, all other nodes need a real node to hold their children
+        helper = this->add_node(ref.first, ref.second->tail != nullptr); // add the jnode to this trie
         helper->children = ref.second->children; // set the children vector
         helper->data = ref.second->data; // set the data value
         node_stack.pop_back(); // emove the node from the stack to mark it as done
+        TRIE_INSTRUMENT_COUNT(merge_splices);
     }
+    this->filter_mark_stale(); // the spliced subtrees bypassed the filters, the filters this subtrie was taken from can not be rebuilt here
+    this->rebuild_filter();
+}
+
+template<std::size_t children_count, typename value_t>
+trie::basic_trie<children_count, value_t>
+trie::basic_trie<children_count, value_t>::set_union(basic_trie& other)
+{
+    basic_trie<children_count, value_t> result;
+    this->set_union(other, [&result](const key_t& key, std::shared_ptr<value_t>& left, std::shared_ptr<value_t>& right) { result.insert(key, (left != nullptr) ? left : right); });
+    return result;
+}
+
+template<std::size_t children_count, typename value_t>
+template<typename visitor_t>
+bool
+trie::basic_trie<children_count, value_t>::set_union(basic_trie& other, visitor_t visitor)
+{
+    return this->walk_pair(other, true, true, true, visitor);
+}
+
+template<std::size_t children_count, typename value_t>
+trie::basic_trie<children_count, value_t>
+trie::basic_trie<children_count, value_t>::set_intersection(basic_trie& other)
+{
+    basic_trie<children_count, value_t> result;
+    this->set_intersection(other, [&result](const key_t& key, std::shared_ptr<value_t>& left, std::shared_ptr<value_t>&) { result.insert(key, left); });
+    return result;
+}
+
+template<std::size_t children_count, typename value_t>
+template<typename visitor_t>
+bool
+trie::basic_trie<children_count, value_t>::set_intersection(basic_trie& other, visitor_t visitor)
+{
+    return this->walk_pair(other, false, false, true, visitor);
+}
+
+template<std::size_t children_count, typename value_t>
+trie::basic_trie<children_count, value_t>
+trie::basic_trie<children_count, value_t>::set_difference(basic_trie& other)
+{
+    basic_trie<children_count, value_t> result;
+    this->set_difference(other, [&result](const key_t& key, std::shared_ptr<value_t>& left, std::shared_ptr<value_t>&) { result.insert(key, left); });
+    return result;
+}
+
+template<std::size_t children_count, typename value_t>
+template<typename visitor_t>
+bool
+trie::basic_trie<children_count, value_t>::set_difference(basic_trie& other, visitor_t visitor)
+{
+    return this->walk_pair(other, true, false, false, visitor);
+}
+
+template<std::size_t children_count, typename value_t>
+template<typename visitor_t>
+bool
+trie::basic_trie<children_count, value_t>::diff(basic_trie& newer, visitor_t visitor)
+{
+    auto report = [&visitor](const key_t& key, std::shared_ptr<value_t>& old_data, std::shared_ptr<value_t>& new_data) -> visit_result
+    {
+        diff_kind kind = (old_data == nullptr) ? diff_kind::added : (new_data == nullptr) ? diff_kind::removed : diff_kind::changed;
+        if constexpr (std::is_void<decltype(visitor(key, kind, old_data, new_data))>::value)
+        {
+            visitor(key, kind, old_data, new_data);
+            return visit_result::proceed;
+        }
+        else return visitor(key, kind, old_data, new_data);
+    };
+    return this->walk_pair(newer, true, true, true, report, true);
+}
+
+template<std::size_t children_count, typename value_t, typename visitor_t>
+bool
+trie::diff(basic_trie<children_count, value_t>& old_trie, basic_trie<children_count, value_t>& new_trie, visitor_t callback)
+{
+    return old_trie.diff(new_trie, callback);
 }
 
 template<std::size_t children_count, typename value_t>
 trie::basic_trie<children_count, value_t>
 trie::basic_trie<children_count, value_t>::subtrie(const key_t& key)
 {
-    std::shared_ptr<node> newroot = this->get_node(key);
+    TRIE_INSTRUMENT_TIME(subtrie);
+    bool in_tail;
+    std::shared_ptr<node> newroot = this->get_node(key, in_tail);
     if (newroot == nullptr) throw std::out_of_range("Trie does not have the requested child");
-    return ::trie::basic_trie<children_count, value_t>(newroot);
+    // the root of a trie can not have a tail, the subtrie shares its nodes with this trie, so a real node is needed at the key
+    if (in_tail) newroot = this->add_node(key, false);
+    else if (newroot->tail != nullptr) newroot = this->split_tail(newroot, newroot->tail->size());
+    ::trie::basic_trie<children_count, value_t> result(newroot);
+    // values stored through the subtrie are not added to this trie's filter, they mark it stale instead
+    result._outer_filters_stale = this->_outer_filters_stale;
+    if (this->_filter != nullptr) result._outer_filters_stale.push_back(this->_filter_stale);
+    return result;
 }
 
 template<std::size_t children_count, typename value_t>
 trie::basic_trie<children_count, value_t>
 trie::basic_trie<children_count, value_t>::clone()
 {
+    TRIE_INSTRUMENT_TIME(clone);
     basic_trie<children_count, value_t> _clone;
-    for (auto iter = this->node_begin(); iter != this->node_end(); iter++)
+    // not node_begin(), which would mark the filter stale
+    for (auto iter = ++node_iterator(this->_root); iter != node_iterator(this->_root); iter++)
         _clone.insert(iter.get_key(), iter.get_data());
     return _clone;
 }
@@ -166,6 +617,133 @@ void
 trie::basic_trie<children_count, value_t>::clear()
 {
     this->_root = std::make_shared<node>();
+    this->_arena = nullptr;
+    if (this->_filter != nullptr)
+    {
+        this->_filter->clear();
+        *this->_filter_stale = false;
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::basic_trie<children_count, value_t>::clear(trie::background_reclaimer& reclaimer)
+{
+    std::shared_ptr<node> old_root = std::make_shared<node>();
+    old_root.swap(this->_root);
+    reclaimer.retire(std::move(old_root));
+    this->_arena = nullptr;
+    if (this->_filter != nullptr)
+    {
+        this->_filter->clear();
+        *this->_filter_stale = false;
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+std::shared_ptr< typename trie::basic_trie<children_count, value_t>::node >
+trie::basic_trie<children_count, value_t>::compacted_copy(std::size_t hot_bytes, trie::node_arena::page_mode pages)
+{
+    std::size_t node_count = 0, tail_count = 0;
+    std::vector<const node*> pending(1, this->_root.get());
+    while (!pending.empty())
+    {
+        const node* current = pending.back();
+        pending.pop_back();
+        ++node_count;
+        if (current->tail != nullptr) ++tail_count;
+        for (const std::shared_ptr<node>& child : current->children)
+        {
+            if (child != nullptr) pending.push_back(child.get());
+        }
+    }
+
+    // the control blocks of std::allocate_shared are not part of sizeof(node), a few pointers per object are reserved for them
+    std::shared_ptr<trie::node_arena> arena = std::make_shared<trie::node_arena>(node_count * (sizeof(node) + 4 * sizeof(void*)) + tail_count * (sizeof(key_t) + 4 * sizeof(void*)), pages);
+    trie::node_arena::allocator<node> node_allocator(arena);
+    trie::node_arena::allocator<key_t> key_allocator(arena);
+    auto copy = [&](const node* source) -> std::shared_ptr<node>
+    {
+        std::shared_ptr<node> result = std::allocate_shared<node>(node_allocator);
+        result->data = source->data;
+        if (source->tail != nullptr) result->tail = std::allocate_shared<key_t>(key_allocator, *source->tail);
+        return result;
+    };
+
+    // breadth-first over the hot top levels, a level is only packed if all of its nodes still fit
+    std::shared_ptr<node> root = copy(this->_root.get());
+    std::vector<std::pair<const node*, node*> > level(1, std::make_pair(this->_root.get(), root.get())), next_level;
+    std::size_t used = sizeof(node), level_count;
+    while (!level.empty())
+    {
+        level_count = 0;
+        for (const std::pair<const node*, node*>& current : level)
+        {
+            for (const std::shared_ptr<node>& child : current.first->children)
+            {
+                if (child != nullptr) ++level_count;
+            }
+        }
+        if (used + level_count * sizeof(node) > hot_bytes) break;
+        used += level_count * sizeof(node);
+        next_level.clear();
+        for (const std::pair<const node*, node*>& current : level)
+        {
+            for (std::size_t i = 0; i < children_count; i++)
+            {
+                if (current.first->children[i] == nullptr) continue;
+                current.second->children[i] = copy(current.first->children[i].get());
+                next_level.emplace_back(current.first->children[i].get(), current.second->children[i].get());
+            }
+        }
+        level.swap(next_level);
+    }
+
+    // depth-first pre-order below the hot levels, a node is copied when it is taken from the stack
+    struct frame
+    {
+        const node* source;
+        node* parent; // the copy of the source's parent
+        std::size_t key_element;
+    };
+    std::vector<frame> node_stack;
+    for (const std::pair<const node*, node*>& current : level)
+    {
+        for (std::size_t i = children_count; i-- > 0; )
+        {
+            if (current.first->children[i] != nullptr) node_stack.push_back(frame{ current.first->children[i].get(), current.second, i });
+        }
+        while (!node_stack.empty())
+        {
+            frame top = node_stack.back();
+            node_stack.pop_back();
+            std::shared_ptr<node>& target = top.parent->children[top.key_element];
+            target = copy(top.source);
+            for (std::size_t i = children_count; i-- > 0; )
+            {
+                if (top.source->children[i] != nullptr) node_stack.push_back(frame{ top.source->children[i].get(), target.get(), i });
+            }
+        }
+    }
+    this->_arena = arena;
+    return root;
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::basic_trie<children_count, value_t>::compact(std::size_t hot_bytes, trie::node_arena::page_mode pages)
+{
+    std::shared_ptr<node> root = this->compacted_copy(hot_bytes, pages);
+    root.swap(this->_root); // the old nodes are released at the end of this scope
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::basic_trie<children_count, value_t>::compact(trie::background_reclaimer& reclaimer, std::size_t hot_bytes, trie::node_arena::page_mode pages)
+{
+    std::shared_ptr<node> root = this->compacted_copy(hot_bytes, pages);
+    root.swap(this->_root);
+    reclaimer.retire(std::move(root));
 }
 
 template<std::size_t children_count, typename value_t>
@@ -179,3 +757,800 @@ trie::basic_trie<children_count, value_t>::size()
     }
     return counter;
 }
+
+template<std::size_t children_count, typename value_t>
+typename trie::basic_trie<children_count, value_t>::statistics
+trie::basic_trie<children_count, value_t>::stats() const
+{
+    struct frame
+    {
+        const node* current;
+        std::size_t level; // number of real nodes above this node
+        std::size_t depth; // key length of this node
+        std::size_t chain; // number of chain nodes directly above this node
+    };
+    statistics result;
+    std::vector<frame> node_stack(1, frame{ this->_root.get(), 0, 0, 0 });
+    std::size_t child_count, depth;
+    bool chain_node;
+    while (!node_stack.empty())
+    {
+        frame top = node_stack.back();
+        const node* current = top.current;
+        node_stack.pop_back();
+
+        child_count = 0;
+        for (const std::shared_ptr<node>& child : current->children)
+        {
+            if (child != nullptr) ++child_count;
+        }
+        ++result.node_count;
+        result.node_bytes += sizeof(node);
+        if (result.fanout_histogram.size() <= top.level) result.fanout_histogram.resize(top.level + 1, std::vector<std::size_t>(children_count + 1, 0));
+        ++result.fanout_histogram[top.level][child_count];
+
+        depth = top.depth;
+        if (current->tail != nullptr)
+        {
+            ++result.tail_count;
+            result.key_bytes += sizeof(key_t) + current->tail->export_size();
+            depth += current->tail->size(); // the data of a tailed node belongs to the end of the tail
+        }
+        if (current->data != nullptr)
+        {
+            ++result.value_count;
+            result.value_bytes += sizeof(value_t);
+            if (result.depth_histogram.size() <= depth) result.depth_histogram.resize(depth + 1, 0);
+            ++result.depth_histogram[depth];
+        }
+        else if (child_count == 0 && current->tail == nullptr && current != this->_root.get())
+        {
+            ++result.empty_leaf_count;
+        }
+
+        // a chain ends at the first node that has data or does not have exactly one child
+        chain_node = (child_count == 1 && current->data == nullptr);
+        if (!chain_node && top.chain > 0)
+        {
+            ++result.chain_count;
+            if (result.chain_histogram.size() <= top.chain) result.chain_histogram.resize(top.chain + 1, 0);
+            ++result.chain_histogram[top.chain];
+        }
+        for (std::size_t i = children_count; i-- > 0; )
+        {
+            if (current->children[i] != nullptr)
+            {
+                node_stack.push_back(frame{ current->children[i].get(), top.level + 1, top.depth + 1, chain_node ? top.chain + 1 : 0 });
+            }
+        }
+    }
+    if (this->_filter != nullptr)
+    {
+        result.filter_bytes = this->_filter->memory_usage();
+        result.filter_false_positive_rate = this->_filter->false_positive_rate();
+    }
+    if (this->_arena != nullptr)
+    {
+        result.arena_bytes = this->_arena->memory_usage();
+        result.huge_page_bytes = this->_arena->promoted_bytes();
+    }
+    return result;
+}
+
+template<std::size_t children_count, typename value_t>
+template<typename visitor_t>
+bool
+trie::basic_trie<children_count, value_t>::traverse(node* start, key_t& key, bool values_only, visitor_t& visitor)
+{
+    struct frame
+    {
+        node* current;
+        std::size_t next_child;
+        std::size_t base_length; // key length before the node's own key elements were appended
+    };
+    std::vector<frame> node_stack;
+    node* child;
+    std::size_t base_length;
+
+    // visit a node whose key is in the buffer, returns false if the traversal has to stop
+    auto enter = [&](node* current, std::size_t length) -> bool
+    {
+        visit_result result = visit_result::proceed;
+        if (!values_only || current->data != nullptr)
+        {
+            if constexpr (std::is_void<decltype(visitor(static_cast<const key_t&>(key), current->data))>::value) visitor(static_cast<const key_t&>(key), current->data);
+            else result = visitor(static_cast<const key_t&>(key), current->data);
+        }
+        if (result == visit_result::stop) return false;
+        if (result == visit_result::proceed && current->tail == nullptr)
+        {
+            node_stack.push_back(frame{ current, 0, length });
+        }
+        else
+        {
+            while (key.size() > length) key.pop_back(); // the node is done, remove its key elements again
+        }
+        return true;
+    };
+
+    if (!enter(start, key.size())) return false;
+    while (!node_stack.empty())
+    {
+        frame& top = node_stack.back();
+        while (top.next_child < children_count && top.current->children[top.next_child] == nullptr) ++top.next_child;
+        if (top.next_child == children_count)
+        {
+            // all children visited, go back to the parent node
+            while (key.size() > top.base_length) key.pop_back();
+            node_stack.pop_back();
+            continue;
+        }
+        child = top.current->children[top.next_child].get();
+        base_length = key.size();
+        key.push_back((uint8_t)top.next_child++);
+        if (child->tail != nullptr)
+        {
+            for (std::size_t i = 0; i < child->tail->size(); i++) key.push_back(child->tail->get_element(i));
+        }
+        if (!enter(child, base_length)) return false; // the reference to the top frame is not used after this, enter might reallocate the stack
+    }
+    return true;
+}
+
+template<std::size_t children_count, typename value_t>
+template<typename visitor_t>
+bool
+trie::basic_trie<children_count, value_t>::for_each(const key_t& prefix, visitor_t visitor)
+{
+    node* helper = this->_root.get();
+    key_t key;
+    // find the node of the prefix without expanding tails, a prefix ending inside of a tail starts at the tail's node
+    for (std::size_t i = 0; i < prefix.size(); i++)
+    {
+        if (helper->tail != nullptr)
+        {
+            if (i + common_length(*helper->tail, prefix, i) != prefix.size()) return true; // no key starts with the prefix
+            break;
+        }
+        helper = helper->child(prefix.get_element(i)).get();
+        if (helper == nullptr) return true;
+        key.push_back(prefix.get_element(i));
+    }
+    if (helper->tail != nullptr)
+    {
+        for (std::size_t i = 0; i < helper->tail->size(); i++) key.push_back(helper->tail->get_element(i));
+    }
+    return this->traverse(helper, key, true, visitor);
+}
+
+template<std::size_t children_count, typename value_t>
+template<typename visitor_t>
+bool
+trie::basic_trie<children_count, value_t>::for_each_range(const key_t& first, const key_t& last, visitor_t visitor)
+{
+    // compare a key to a bound: <0 or >0 if the keys differ in an element, 0 if the key is a prefix of (or equal to) the bound
+    // and 1 if the bound is a proper prefix of the key
+    auto compare = [](const key_t& key, const key_t& bound) -> int
+    {
+        std::size_t length = std::min(key.size(), bound.size());
+        for (std::size_t i = 0; i < length; i++)
+        {
+            if (key.get_element(i) != bound.get_element(i)) return (key.get_element(i) < bound.get_element(i)) ? -1 : 1;
+        }
+        return (key.size() > bound.size()) ? 1 : 0;
+    };
+    bool above_first = false; // the nodes are visited in key order, once a node is above 'first' all following nodes are
+    auto range_visitor = [&](const key_t& key, std::shared_ptr<value_t>& data) -> visit_result
+    {
+        visit_result result = visit_result::proceed;
+        int order;
+        if (!above_first)
+        {
+            order = compare(key, first);
+            if (order < 0) return visit_result::skip_subtree; // the whole subtree is in front of the range
+            if (order == 0 && key.size() < first.size()) return visit_result::proceed; // only some keys below this node are in the range
+            above_first = true;
+        }
+        order = compare(key, last);
+        if (order > 0 || (order == 0 && key.size() == last.size())) return visit_result::stop; // this node and all following nodes are behind the range
+        if (data == nullptr) return visit_result::proceed;
+        if constexpr (std::is_void<decltype(visitor(key, data))>::value) visitor(key, data);
+        else result = visitor(key, data);
+        return result;
+    };
+    key_t key;
+    int order = compare(first, last);
+    if (order > 0 || (order == 0 && first.size() == last.size())) return true; // empty range
+    return this->traverse(this->_root.get(), key, false, range_visitor);
+}
+
+template<std::size_t children_count, typename value_t>
+std::vector<typename trie::basic_trie<children_count, value_t>::fuzzy_match>
+trie::basic_trie<children_count, value_t>::fuzzy_search(const key_t& query, std::size_t max_distance, bool utf8) const
+{
+    // symbol decoder, a symbol is a key element or (utf8) a code point. Invalid UTF-8 bytes are mapped above the code point range.
+    struct decoder
+    {
+        uint32_t value{ 0 };
+        uint8_t remaining{ 0 };
+
+        // feed one key element, the completed symbols are appended to 'symbols'
+        void feed(bool utf8, uint8_t element, uint32_t* symbols, std::size_t& count)
+        {
+            count = 0;
+            if (!utf8)
+            {
+                symbols[count++] = element;
+                return;
+            }
+            if (this->remaining != 0)
+            {
+                if ((element & 0xC0) == 0x80)
+                {
+                    this->value = (this->value << 6) | (element & 0x3F);
+                    if (--this->remaining == 0) symbols[count++] = this->value;
+                    return;
+                }
+                symbols[count++] = 0x110000 + (this->value & 0xFF); // the sequence was cut off, keep it as a symbol of its own
+                this->remaining = 0;
+            }
+            if (element < 0x80) symbols[count++] = element;
+            else if ((element & 0xE0) == 0xC0) { this->value = element & 0x1F; this->remaining = 1; }
+            else if ((element & 0xF0) == 0xE0) { this->value = element & 0x0F; this->remaining = 2; }
+            else if ((element & 0xF8) == 0xF0) { this->value = element & 0x07; this->remaining = 3; }
+            else symbols[count++] = 0x110000 + element;
+        }
+    };
+    struct frame
+    {
+        const node* current;
+        std::size_t next_child;
+        std::size_t base_length; // key length before the node's own key elements were appended
+        std::size_t row; // offset of the node's distance row in the row buffer
+        decoder state; // a code point might continue in the children
+    };
+    std::vector<fuzzy_match> result;
+    std::vector<uint32_t> pattern;
+    std::vector<std::size_t> rows; // one row per frame, row[j] is the distance of the frame's key to the first j query symbols
+    std::vector<frame> node_stack;
+    decoder query_state;
+    uint32_t symbols[2];
+    std::size_t count, width;
+    key_t key;
+    if (utf8 && children_count != 256) throw std::invalid_argument("UTF-8 fuzzy search needs a trie with 256 children per node");
+
+    for (std::size_t i = 0; i < query.size(); i++)
+    {
+        query_state.feed(utf8, query.get_element(i), symbols, count);
+        pattern.insert(pattern.end(), symbols, symbols + count);
+    }
+    if (query_state.remaining != 0) pattern.push_back(0x110000 + (query_state.value & 0xFF));
+    width = pattern.size() + 1;
+
+    // append the next row for every completed symbol, returns false if no key below can be within the bound any more
+    auto advance = [&](std::size_t row, decoder& state, uint8_t element) -> bool
+    {
+        state.feed(utf8, element, symbols, count);
+        for (std::size_t s = 0; s < count; s++)
+        {
+            std::size_t minimum;
+            rows.resize(row + 2 * width); // the previous row is copied, the buffer may reallocate
+            std::size_t* previous = rows.data() + row;
+            std::size_t* next = previous + width;
+            next[0] = minimum = previous[0] + 1;
+            for (std::size_t j = 1; j < width; j++)
+            {
+                next[j] = std::min({ previous[j] + 1, next[j - 1] + 1, previous[j - 1] + (pattern[j - 1] != symbols[s] ? 1 : 0) });
+                minimum = std::min(minimum, next[j]);
+            }
+            std::copy(next, next + width, previous);
+            rows.resize(row + width);
+            if (minimum > max_distance) return false;
+        }
+        return true;
+    };
+    // visit a node whose key elements (except for the tail) are in the key buffer, the parent's row is at 'row'
+    auto enter = [&](const node* current, std::size_t base_length, std::size_t row, decoder state) -> void
+    {
+        std::size_t own_row = row + width;
+        rows.resize(own_row + width);
+        std::copy(rows.begin() + row, rows.begin() + row + width, rows.begin() + own_row);
+        if (base_length != key.size() && !advance(own_row, state, key.get_element(key.size() - 1)))
+        {
+            while (key.size() > base_length) key.pop_back();
+            rows.resize(own_row);
+            return;
+        }
+        if (current->tail != nullptr)
+        {
+            for (std::size_t i = 0; i < current->tail->size(); i++)
+            {
+                key.push_back(current->tail->get_element(i));
+                if (!advance(own_row, state, current->tail->get_element(i)))
+                {
+                    while (key.size() > base_length) key.pop_back();
+                    rows.resize(own_row);
+                    return;
+                }
+            }
+        }
+        if (current->data != nullptr && state.remaining == 0 && rows[own_row + width - 1] <= max_distance)
+        {
+            result.push_back(fuzzy_match{ key, rows[own_row + width - 1], current->data });
+        }
+        if (current->tail != nullptr)
+        {
+            while (key.size() > base_length) key.pop_back(); // a node with a tail has no children
+            rows.resize(own_row);
+            return;
+        }
+        node_stack.push_back(frame{ current, 0, base_length, own_row, state });
+    };
+
+    rows.resize(width);
+    for (std::size_t j = 0; j < width; j++) rows[j] = j; // distance of the empty key, the root's row is built from it
+    enter(this->_root.get(), 0, 0, decoder());
+    while (!node_stack.empty())
+    {
+        frame& top = node_stack.back();
+        while (top.next_child < children_count && top.current->children[top.next_child] == nullptr) ++top.next_child;
+        if (top.next_child == children_count)
+        {
+            while (key.size() > top.base_length) key.pop_back();
+            rows.resize(top.row);
+            node_stack.pop_back();
+            continue;
+        }
+        const node* child = top.current->children[top.next_child].get();
+        std::size_t row = top.row, base_length = key.size();
+        decoder state = top.state;
+        key.push_back((uint8_t)top.next_child++);
+        enter(child, base_length, row, state); // the reference to the top frame is not used after this, enter might reallocate the stack
+    }
+    // the traversal found the matches in key order, keep that order for matches with the same distance
+    std::stable_sort(result.begin(), result.end(), [](const fuzzy_match& a, const fuzzy_match& b) { return a.distance < b.distance; });
+    return result;
+}
+
+template<std::size_t children_count, typename value_t>
+template<typename visitor_t>
+bool
+trie::basic_trie<children_count, value_t>::for_each_match(const trie::key_pattern& pattern, visitor_t visitor)
+{
+    static constexpr std::size_t element_bits = (children_count == 2) ? 1 : (children_count == 4) ? 2 : (children_count == 16) ? 4 : 8;
+    struct position
+    {
+        uint32_t state;
+        uint8_t partial; // key elements of the current byte that were read so far
+        uint8_t filled; // number of elements in partial
+    };
+    struct frame
+    {
+        node* current;
+        std::size_t next_child;
+        std::size_t base_length; // key length before the node's own key elements were appended
+        position at;
+    };
+    std::vector<frame> node_stack;
+    key_t key;
+
+    // read a key element, returns false if no key continuing with it can match
+    auto advance = [&pattern](position& at, uint8_t element) -> bool
+    {
+        std::size_t first, last, step;
+        if constexpr (children_count == 256)
+        {
+            at.state = pattern.next(at.state, element);
+            return pattern.live(at.state);
+        }
+        // a basic_key<16> uses the lower nibble of a byte first, the smaller children counts use the higher bits first
+        if constexpr (children_count == 16) at.partial = (uint8_t)(at.partial | (element << (4 * at.filled)));
+        else at.partial = (uint8_t)((at.partial << element_bits) | element);
+        if (++at.filled == 8 / element_bits)
+        {
+            at.state = pattern.next(at.state, at.partial);
+            at.partial = at.filled = 0;
+            return pattern.live(at.state);
+        }
+        // check all bytes starting with the elements read so far
+        if constexpr (children_count == 16)
+        {
+            first = at.partial;
+            last = 256;
+            step = 16;
+        }
+        else
+        {
+            first = (std::size_t)at.partial << (8 - at.filled * element_bits);
+            last = first + ((std::size_t)1 << (8 - at.filled * element_bits));
+            step = 1;
+        }
+        for (std::size_t byte = first; byte < last; byte += step)
+        {
+            if (pattern.live(pattern.next(at.state, (uint8_t)byte))) return true;
+        }
+        return false;
+    };
+    // visit a node whose key elements (except for the tail) are in the key buffer, returns false if the traversal has to stop
+    auto enter = [&](node* current, std::size_t base_length, position at) -> bool
+    {
+        visit_result result = visit_result::proceed;
+        bool alive = (base_length == key.size()) || advance(at, key.get_element(key.size() - 1));
+        if (alive && current->tail != nullptr)
+        {
+            for (std::size_t i = 0; i < current->tail->size() && alive; i++)
+            {
+                key.push_back(current->tail->get_element(i));
+                alive = advance(at, current->tail->get_element(i));
+            }
+        }
+        if (alive && current->data != nullptr && at.filled == 0 && pattern.accepting(at.state))
+        {
+            if constexpr (std::is_void<decltype(visitor(static_cast<const key_t&>(key), current->data))>::value) visitor(static_cast<const key_t&>(key), current->data);
+            else result = visitor(static_cast<const key_t&>(key), current->data);
+        }
+        if (result == visit_result::stop) return false;
+        if (alive && result == visit_result::proceed && current->tail == nullptr)
+        {
+            node_stack.push_back(frame{ current, 0, base_length, at });
+        }
+        else
+        {
+            while (key.size() > base_length) key.pop_back(); // the node is done, remove its key elements again
+        }
+        return true;
+    };
+
+    if (!pattern.live(pattern.start())) return true;
+    if (!enter(this->_root.get(), 0, position{ pattern.start(), 0, 0 })) return false;
+    while (!node_stack.empty())
+    {
+        frame& top = node_stack.back();
+        while (top.next_child < children_count && top.current->children[top.next_child] == nullptr) ++top.next_child;
+        if (top.next_child == children_count)
+        {
+            while (key.size() > top.base_length) key.pop_back();
+            node_stack.pop_back();
+            continue;
+        }
+        node* child = top.current->children[top.next_child].get();
+        std::size_t base_length = key.size();
+        position at = top.at;
+        key.push_back((uint8_t)top.next_child++);
+        if (!enter(child, base_length, at)) return false; // the reference to the top frame is not used after this, enter might reallocate the stack
+    }
+    return true;
+}
+
+template<std::size_t children_count, typename value_t>
+template<typename visitor_t>
+bool
+trie::basic_trie<children_count, value_t>::for_each_node(visitor_t visitor)
+{
+    key_t key;
+    this->filter_mark_stale(); // the visitor can store values in nodes without data
+    return this->traverse(this->_root.get(), key, false, visitor);
+}
+
+template<std::size_t children_count, typename value_t>
+std::vector<typename trie::basic_trie<children_count, value_t>::segment>
+trie::basic_trie<children_count, value_t>::split_segments(std::size_t target)
+{
+    static constexpr std::size_t max_split_levels = 64; // a trie2 needs 8 levels per byte
+    std::vector<segment> segments(1, segment{ this->_root.get(), key_t(), true }), expanded;
+    key_t key;
+    bool changed = true;
+    for (std::size_t level = 0; changed && level < max_split_levels && segments.size() < target; level++)
+    {
+        // replace every subtree segment by its own value and one segment per child
+        changed = false;
+        expanded.clear();
+        for (segment& current : segments)
+        {
+            if (!current.subtree || current.current->tail != nullptr)
+            {
+                expanded.push_back(std::move(current));
+                continue;
+            }
+            if (current.current->data != nullptr) expanded.push_back(segment{ current.current, current.key, false });
+            for (std::size_t i = 0; i < children_count; i++)
+            {
+                node* child = current.current->children[i].get();
+                if (child == nullptr) continue;
+                key = current.key;
+                key.push_back((uint8_t)i);
+                if (child->tail != nullptr)
+                {
+                    for (std::size_t j = 0; j < child->tail->size(); j++) key.push_back(child->tail->get_element(j));
+                }
+                expanded.push_back(segment{ child, key, true });
+                changed = true;
+            }
+        }
+        segments.swap(expanded);
+    }
+    return segments;
+}
+
+template<std::size_t children_count, typename value_t>
+template<typename visitor_t>
+void
+trie::basic_trie<children_count, value_t>::parallel_for_each(visitor_t visitor, trie::work_stealing_pool& pool)
+{
+    std::vector<segment> segments = this->split_segments(pool.thread_count() * 8); // more tasks than threads, so stealing can balance them
+    pool.run(segments.size(), [this, &segments, &visitor](std::size_t index, std::size_t)
+        {
+            segment& current = segments[index];
+            if (!current.subtree)
+            {
+                visitor(static_cast<const key_t&>(current.key), current.current->data);
+                return;
+            }
+            this->traverse(current.current, current.key, true, visitor);
+        });
+}
+
+template<std::size_t children_count, typename value_t>
+template<typename result_t, typename map_t, typename combine_t>
+result_t
+trie::basic_trie<children_count, value_t>::parallel_reduce(result_t identity, map_t map, combine_t combine, bool ordered, trie::work_stealing_pool& pool)
+{
+    struct slot
+    {
+        result_t value; // wrapped, so a std::vector<bool> can not pack the results of different threads into one word
+    };
+    std::vector<segment> segments = this->split_segments(pool.thread_count() * 8);
+    // ordered: one partial result per segment, combined in key order. unordered: one partial result per worker
+    std::vector<slot> partial(ordered ? segments.size() : pool.thread_count(), slot{ identity });
+    pool.run(segments.size(), [&](std::size_t index, std::size_t worker)
+        {
+            segment& current = segments[index];
+            result_t& target = partial[ordered ? index : worker].value;
+            auto accumulate = [&target, &map, &combine](const key_t& key, std::shared_ptr<value_t>& data)
+            {
+                target = combine(std::move(target), map(key, data));
+            };
+            if (!current.subtree) accumulate(current.key, current.current->data);
+            else this->traverse(current.current, current.key, true, accumulate);
+        });
+    for (slot& current : partial)
+    {
+        identity = combine(std::move(identity), std::move(current.value));
+    }
+    return identity;
+}
+
+template<std::size_t children_count, typename value_t>
+template<typename visitor_t>
+bool
+trie::basic_trie<children_count, value_t>::walk_pair(basic_trie& other, bool left_only, bool right_only, bool both, visitor_t& visitor, bool changed_only)
+{
+    // a position in a trie: a node and the number of its tail elements that were already read, current is a nullptr if the trie has no such key prefix
+    struct cursor
+    {
+        node* current;
+        std::size_t offset;
+
+        bool at_end() const { return this->current->tail == nullptr || this->offset == this->current->tail->size(); }
+        std::shared_ptr<value_t>* data() const { return (this->current != nullptr && this->at_end() && this->current->data != nullptr) ? &this->current->data : nullptr; }
+        cursor child(std::size_t key_element) const
+        {
+            if (this->current == nullptr) return cursor{ nullptr, 0 };
+            if (!this->at_end())
+            {
+                if (this->current->tail->get_element(this->offset) != key_element) return cursor{ nullptr, 0 };
+                return cursor{ this->current, this->offset + 1 };
+            }
+            if (this->current->tail != nullptr) return cursor{ nullptr, 0 }; // a node with a tail has no children
+            return cursor{ this->current->children[key_element].get(), 0 };
+        }
+    };
+    struct frame
+    {
+        cursor left, right;
+        std::size_t next_child;
+        std::size_t base_length; // key length before the position's key element was appended
+    };
+    std::shared_ptr<value_t> missing; // passed for the trie that does not store a key
+    std::vector<frame> node_stack;
+    key_t key;
+
+    // check if keys below a position pair can be wanted
+    auto wanted = [&](const cursor& left, const cursor& right) -> bool
+    {
+        if (left.current == nullptr) return right.current != nullptr && right_only;
+        if (right.current == nullptr) return left_only;
+        if (left.current == right.current && left.offset == right.offset) return both && !changed_only; // a shared subtree only holds keys stored in both tries
+        return true;
+    };
+    // report the key of a position pair, returns false if the walk has to stop
+    auto enter = [&](const cursor& left, const cursor& right, std::size_t base_length) -> bool
+    {
+        visit_result result = visit_result::proceed;
+        std::shared_ptr<value_t>* left_data = left.data();
+        std::shared_ptr<value_t>* right_data = right.data();
+        if ((left_data != nullptr && right_data != nullptr && both && !(changed_only && *left_data == *right_data))
+            || (left_data != nullptr && right_data == nullptr && left_only)
+            || (left_data == nullptr && right_data != nullptr && right_only))
+        {
+            std::shared_ptr<value_t>& left_ref = (left_data != nullptr) ? *left_data : missing;
+            std::shared_ptr<value_t>& right_ref = (right_data != nullptr) ? *right_data : missing;
+            if constexpr (std::is_void<decltype(visitor(static_cast<const key_t&>(key), left_ref, right_ref))>::value) visitor(static_cast<const key_t&>(key), left_ref, right_ref);
+            else result = visitor(static_cast<const key_t&>(key), left_ref, right_ref);
+            missing = nullptr; // the visitor might have assigned to it
+        }
+        if (result == visit_result::stop) return false;
+        if (result == visit_result::proceed) node_stack.push_back(frame{ left, right, 0, base_length });
+        else while (key.size() > base_length) key.pop_back();
+        return true;
+    };
+
+    if (!wanted(cursor{ this->_root.get(), 0 }, cursor{ other._root.get(), 0 })) return true;
+    if (!enter(cursor{ this->_root.get(), 0 }, cursor{ other._root.get(), 0 }, 0)) return false;
+    while (!node_stack.empty())
+    {
+        frame& top = node_stack.back();
+        // positions inside of a tail have a single child, there is no need to try every key element then
+        bool left_full = top.left.current != nullptr && top.left.current->tail == nullptr;
+        bool right_full = top.right.current != nullptr && top.right.current->tail == nullptr;
+        cursor left{ nullptr, 0 }, right{ nullptr, 0 };
+        while (top.next_child < children_count)
+        {
+            if (!left_full && !right_full)
+            {
+                // only the next tail elements of both sides are candidates
+                std::size_t candidate = children_count;
+                for (const cursor* side : { &top.left, &top.right })
+                {
+                    if (side->current == nullptr || side->at_end()) continue;
+                    std::size_t element = side->current->tail->get_element(side->offset);
+                    if (element >= top.next_child && element < candidate) candidate = element;
+                }
+                top.next_child = candidate;
+                if (candidate == children_count) break;
+            }
+            else
+            {
+                // skip the key elements without a wanted child before building the cursors
+                bool has_left = left_full ? top.left.current->children[top.next_child] != nullptr : top.left.child(top.next_child).current != nullptr;
+                bool has_right = right_full ? top.right.current->children[top.next_child] != nullptr : top.right.child(top.next_child).current != nullptr;
+                if (!((has_left && has_right) || (has_left && left_only) || (has_right && right_only)))
+                {
+                    ++top.next_child;
+                    continue;
+                }
+            }
+            left = top.left.child(top.next_child);
+            right = top.right.child(top.next_child);
+            if (wanted(left, right)) break;
+            ++top.next_child;
+        }
+        if (top.next_child == children_count)
+        {
+            while (key.size() > top.base_length) key.pop_back();
+            node_stack.pop_back();
+            continue;
+        }
+        std::size_t base_length = key.size();
+        key.push_back((uint8_t)top.next_child++);
+        if (!enter(left, right, base_length)) return false; // the reference to the top frame is not used after this, enter might reallocate the stack
+    }
+    return true;
+}
+
+template<std::size_t children_count, typename value_t>
+template<typename callback_t>
+void
+trie::basic_trie<children_count, value_t>::walk_prefixes(const node* start, std::size_t offset, std::size_t depth, const key_t& key, callback_t callback)
+{
+    const node* helper = start;
+    std::size_t tail_size;
+    while (true)
+    {
+        // the remaining tail has to match the key completely, the node's data belongs to the end of the tail
+        tail_size = (helper->tail == nullptr) ? 0 : helper->tail->size();
+        for (; offset < tail_size; offset++, depth++)
+        {
+            if (depth == key.size() || key.get_element(depth) != helper->tail->get_element(offset)) return;
+        }
+        if (helper->data != nullptr) callback(depth, helper->data);
+        if (depth == key.size() || tail_size != 0) return; // a node with a tail has no children
+        helper = helper->children[key.get_element(depth)].get();
+        if (helper == nullptr) return;
+        ++depth;
+        offset = 0;
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+std::pair<std::size_t, std::shared_ptr<value_t> >
+trie::basic_trie<children_count, value_t>::longest_prefix_match(const key_t& key) const
+{
+    TRIE_INSTRUMENT_TIME(lookup);
+    std::pair<std::size_t, const std::shared_ptr<value_t>*> best(0, nullptr);
+    walk_prefixes(this->_root.get(), 0, 0, key, [&best](std::size_t length, const std::shared_ptr<value_t>& data) { best = std::make_pair(length, &data); });
+    if (best.second == nullptr) return std::make_pair(std::size_t(0), std::shared_ptr<value_t>());
+    return std::make_pair(best.first, *best.second); // only the longest match is copied
+}
+
+template<std::size_t children_count, typename value_t>
+std::vector<std::pair<std::size_t, std::shared_ptr<value_t> > >
+trie::basic_trie<children_count, value_t>::all_prefixes_of(const key_t& key) const
+{
+    TRIE_INSTRUMENT_TIME(lookup);
+    std::vector<std::pair<std::size_t, std::shared_ptr<value_t> > > result;
+    walk_prefixes(this->_root.get(), 0, 0, key, [&result](std::size_t length, const std::shared_ptr<value_t>& data) { result.emplace_back(length, data); });
+    return result;
+}
+
+template<std::size_t children_count, typename value_t>
+trie::basic_trie<children_count, value_t>::stride_index::stride_index(const basic_trie& source, std::size_t levels) : _root(source._root)
+{
+    std::size_t bits = 0, table_size = 1;
+    for (std::size_t helper = children_count; helper > 1; helper >>= 1) ++bits;
+    this->_levels = (levels == 0) ? 16 / bits : levels;
+    for (std::size_t i = 0; i < this->_levels; i++)
+    {
+        table_size *= children_count;
+        if (table_size > (std::size_t(1) << 24)) throw std::length_error("Stride index table exceeds 2^24 entries");
+    }
+    this->_table.resize(table_size);
+    this->fill(this->_root, 0, 0, 0, nullptr, 0);
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::basic_trie<children_count, value_t>::stride_index::fill(const std::shared_ptr<node>& current, std::size_t offset, std::size_t depth, std::size_t index,
+    std::shared_ptr<value_t> best, std::size_t best_length)
+{
+    std::size_t tail_size, range = 1;
+    if (current == nullptr)
+    {
+        // no key continues here, all table entries below this position only have the best match found so far
+        for (std::size_t i = depth; i < this->_levels; i++) range *= children_count;
+        for (std::size_t i = index * range; i < (index + 1) * range; i++)
+        {
+            this->_table[i] = entry{ nullptr, 0, best, best_length };
+        }
+        return;
+    }
+    tail_size = (current->tail == nullptr) ? 0 : current->tail->size();
+    if (offset == tail_size && current->data != nullptr)
+    {
+        best = current->data;
+        best_length = depth;
+    }
+    if (depth == this->_levels)
+    {
+        this->_table[index] = entry{ current, offset, best, best_length };
+        return;
+    }
+    for (std::size_t i = 0; i < children_count; i++)
+    {
+        if (offset < tail_size) this->fill((i == current->tail->get_element(offset)) ? current : nullptr, offset + 1, depth + 1, index * children_count + i, best, best_length);
+        else this->fill(current->children[i], 0, depth + 1, index * children_count + i, best, best_length);
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+std::pair<std::size_t, std::shared_ptr<value_t> >
+trie::basic_trie<children_count, value_t>::stride_index::longest_prefix_match(const key_t& key) const
+{
+    std::pair<std::size_t, const std::shared_ptr<value_t>*> best(0, nullptr);
+    auto callback = [&best](std::size_t length, const std::shared_ptr<value_t>& data) { best = std::make_pair(length, &data); };
+    std::size_t index = 0;
+    if (key.size() < this->_levels)
+    {
+        // the table only covers keys with at least 'levels' key elements
+        basic_trie::walk_prefixes(this->_root.get(), 0, 0, key, callback);
+    }
+    else
+    {
+        for (std::size_t i = 0; i < this->_levels; i++) index = index * children_count + key.get_element(i);
+        const entry& start = this->_table[index];
+        if (start.best != nullptr) best = std::make_pair(start.best_length, &start.best);
+        if (start.current != nullptr) basic_trie::walk_prefixes(start.current.get(), start.offset, this->_levels, key, callback);
+    }
+    if (best.second == nullptr) return std::make_pair(std::size_t(0), std::shared_ptr<value_t>());
+    return std::make_pair(best.first, *best.second);
+}
@@ -0,0 +1,159 @@
+/**
+* @file     trie/impl/bit_vector_impl.hpp
+* @brief    include file for the implementations of the bit vector class
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <stdexcept>
+
+#include "../bit_vector.hpp"
+
+std::size_t
+trie::bit_vector::popcount(uint64_t word)
+{
+    // classic SWAR popcount, most compilers turn this into a single popcnt instruction
+    word = word - ((word >> 1) & 0x5555555555555555ull);
+    word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (std::size_t)((word * 0x0101010101010101ull) >> 56);
+}
+
+std::size_t
+trie::bit_vector::select_in_word(uint64_t word, std::size_t n)
+{
+    std::size_t pos = 0, count;
+    // skip whole bytes first, then find the bit inside of the byte
+    while (true)
+    {
+        count = popcount(word & 0xFF);
+        if (n < count) break;
+        n -= count;
+        word >>= 8;
+        pos += 8;
+    }
+    while (true)
+    {
+        if (word & 1)
+        {
+            if (n == 0) return pos;
+            --n;
+        }
+        word >>= 1;
+        ++pos;
+    }
+}
+
+void
+trie::bit_vector::push_back(bool bit)
+{
+    if (this->_size % word_bits == 0)
+    {
+        this->_words.push_back(0);
+    }
+    if (bit)
+    {
+        this->_words.back() |= (uint64_t)1 << (this->_size % word_bits);
+    }
+    ++this->_size;
+}
+
+bool
+trie::bit_vector::get(std::size_t index) const
+{
+    return (this->_words.at(index / word_bits) >> (index % word_bits)) & 1;
+}
+
+void
+trie::bit_vector::clear()
+{
+    this->_words.clear();
+    this->_blocks.clear();
+    this->_size = 0;
+}
+
+void
+trie::bit_vector::build_index()
+{
+    std::size_t block_count = (this->_words.size() + block_words - 1) / block_words;
+    uint64_t counter = 0;
+    this->_blocks.resize(block_count + 1); // the last entry holds the total number of set bits
+    for (std::size_t i = 0; i < this->_words.size(); i++)
+    {
+        if (i % block_words == 0) this->_blocks.at(i / block_words) = counter;
+        counter += popcount(this->_words.at(i));
+    }
+    this->_blocks.back() = counter;
+    this->_words.shrink_to_fit();
+}
+
+std::size_t
+trie::bit_vector::rank1(std::size_t pos) const
+{
+    std::size_t block = pos / block_bits, word = block * block_words, result = (std::size_t)this->_blocks.at(block);
+    for (; word < pos / word_bits; word++)
+    {
+        result += popcount(this->_words[word]);
+    }
+    if (pos % word_bits != 0)
+    {
+        result += popcount(this->_words[word] & (((uint64_t)1 << (pos % word_bits)) - 1));
+    }
+    return result;
+}
+
+std::size_t
+trie::bit_vector::select1(std::size_t n) const
+{
+    if (this->_blocks.empty() || n >= this->_blocks.back()) throw std::out_of_range("bit vector does not have the requested set bit");
+    // binary search for the last block that has at most n set bits in front of it
+    std::size_t low = 0, high = this->_blocks.size() - 1, mid, count;
+    while (high - low > 1)
+    {
+        mid = (low + high) / 2;
+        if (this->_blocks[mid] <= n) low = mid;
+        else high = mid;
+    }
+    n -= (std::size_t)this->_blocks[low];
+    for (std::size_t word = low * block_words; word < this->_words.size(); word++)
+    {
+        count = popcount(this->_words[word]);
+        if (n < count) return word * word_bits + select_in_word(this->_words[word], n);
+        n -= count;
+    }
+    throw std::out_of_range("bit vector does not have the requested set bit"); // unreachable unless the index is outdated
+}
+
+std::size_t
+trie::bit_vector::select0(std::size_t n) const
+{
+    if (this->_blocks.empty() || n >= this->_size - this->_blocks.back()) throw std::out_of_range("bit vector does not have the requested cleared bit");
+    // same as select1, the number of cleared bits in front of a block is derived from the block position
+    std::size_t low = 0, high = this->_blocks.size() - 1, mid, count;
+    while (high - low > 1)
+    {
+        mid = (low + high) / 2;
+        if (mid * block_bits - this->_blocks[mid] <= n) low = mid;
+        else high = mid;
+    }
+    n -= low * block_bits - (std::size_t)this->_blocks[low];
+    for (std::size_t word = low * block_words; word < this->_words.size(); word++)
+    {
+        count = popcount(~this->_words[word]);
+        if (n < count) return word * word_bits + select_in_word(~this->_words[word], n);
+        n -= count;
+    }
+    throw std::out_of_range("bit vector does not have the requested cleared bit"); // unreachable unless the index is outdated
+}
+
+std::size_t
+trie::bit_vector::memory_usage() const
+{
+    return this->_words.capacity() * sizeof(uint64_t) + this->_blocks.capacity() * sizeof(uint64_t);
+}
@@ -0,0 +1,83 @@
+/**
+* @file     trie/impl/bloom_filter_impl.hpp
+* @brief    include file for the implementations for the bloom filter
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+
+#include "../bloom_filter.hpp"
+
+inline
+trie::bloom_filter::bloom_filter(std::size_t expected_items, double bits_per_item)
+{
+    bits_per_item = std::max(bits_per_item, 1.0);
+    // the optimal number of hash functions is ln(2) * bits per item
+    this->_hash_count = std::min<std::size_t>(std::max<std::size_t>((std::size_t)std::lround(bits_per_item * 0.6931471805599453), 1), 16);
+    this->_bit_count = std::max<std::size_t>((std::size_t)std::ceil(bits_per_item * (double)expected_items), 64);
+    this->_bit_count = (this->_bit_count + 63) / 64 * 64;
+    this->_words.assign(this->_bit_count / 64, 0);
+}
+
+inline uint64_t
+trie::bloom_filter::mix(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+inline void
+trie::bloom_filter::add(uint64_t hash)
+{
+    uint64_t first = mix(hash), second = mix(hash ^ 0x9e3779b97f4a7c15ULL) | 1;
+    for (std::size_t i = 0; i < this->_hash_count; i++)
+    {
+        std::size_t bit = (std::size_t)((first + i * second) % this->_bit_count);
+        this->_words[bit / 64] |= (uint64_t)1 << (bit % 64);
+    }
+    ++this->_item_count;
+}
+
+inline bool
+trie::bloom_filter::may_contain(uint64_t hash) const
+{
+    uint64_t first = mix(hash), second = mix(hash ^ 0x9e3779b97f4a7c15ULL) | 1;
+    for (std::size_t i = 0; i < this->_hash_count; i++)
+    {
+        std::size_t bit = (std::size_t)((first + i * second) % this->_bit_count);
+        if ((this->_words[bit / 64] & ((uint64_t)1 << (bit % 64))) == 0) return false;
+    }
+    return true;
+}
+
+inline void
+trie::bloom_filter::clear()
+{
+    std::fill(this->_words.begin(), this->_words.end(), 0);
+    this->_item_count = 0;
+}
+
+inline double
+trie::bloom_filter::false_positive_rate() const
+{
+    std::size_t set_bits = 0;
+    for (uint64_t word : this->_words)
+    {
+        set_bits += std::bitset<64>(word).count();
+    }
+    // a missing item is only reported if all of its bits are set
+    return std::pow((double)set_bits / (double)this->_bit_count, (double)this->_hash_count);
+}
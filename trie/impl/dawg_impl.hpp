@@ -0,0 +1,263 @@
+/**
+* @file     trie/impl/dawg_impl.hpp
+* @brief    include file for the implementations for the minimal acyclic automaton class
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "../dawg.hpp"
+
+template<std::size_t children_count, typename value_t>
+const typename trie::dawg<children_count, value_t>::edge*
+trie::dawg<children_count, value_t>::find_edge(uint32_t from, uint8_t key_element) const
+{
+    const state& current = this->_states[from];
+    std::size_t low = current.first_edge, high = (std::size_t)current.first_edge + current.edge_count, mid;
+    // the edges of one state are sorted, so a binary search can be used to find the edge
+    while (low < high)
+    {
+        mid = (low + high) / 2;
+        if (this->_edges[mid].label < key_element) low = mid + 1;
+        else high = mid;
+    }
+    if (low < (std::size_t)current.first_edge + current.edge_count && this->_edges[low].label == key_element) return &this->_edges[low];
+    return nullptr;
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::dawg<children_count, value_t>::build(trie::basic_trie<children_count, value_t>& source)
+{
+    struct build_state
+    {
+        std::vector<std::pair<uint8_t, uint32_t> > edges;
+        uint32_t count;
+        bool final;
+    };
+    std::vector<build_state> states(1, build_state{ {}, 0, false });
+    std::unordered_map<std::string, uint32_t> registry; // finished states by their signature
+    std::vector<uint32_t> path(1, 0); // states along the most recently added key, the states on it are not finished yet
+    std::vector<std::shared_ptr<value_t> > values;
+    key_t previous;
+    std::size_t common;
+
+    // two finished states are equivalent if they have the same final flag and the same edges to the same (finished) states
+    auto signature = [&states](uint32_t id)
+    {
+        std::string result(1, states[id].final ? '\1' : '\0');
+        for (const std::pair<uint8_t, uint32_t>& current : states[id].edges)
+        {
+            result.push_back((char)current.first);
+            result.append((const char*)&current.second, sizeof(current.second));
+        }
+        return result;
+    };
+    auto count_keys = [&states](uint32_t id)
+    {
+        uint64_t counter = states[id].final ? 1 : 0;
+        for (const std::pair<uint8_t, uint32_t>& current : states[id].edges)
+        {
+            counter += states[current.second].count;
+        }
+        if (counter > std::numeric_limits<uint32_t>::max()) throw std::length_error("Automaton exceeds the 32-bit counter range");
+        states[id].count = (uint32_t)counter;
+    };
+    // finish all states of the path that are deeper than 'depth', no more keys will be added below them
+    auto minimize = [&](std::size_t depth)
+    {
+        while (path.size() > depth + 1)
+        {
+            uint32_t id = path.back();
+            path.pop_back();
+            count_keys(id);
+            std::string key_signature = signature(id);
+            auto found = registry.find(key_signature);
+            if (found != registry.end())
+            {
+                // an equivalent state exists, redirect the parent's newest edge to it and drop this state
+                states[path.back()].edges.back().second = found->second;
+                std::vector<std::pair<uint8_t, uint32_t> >().swap(states[id].edges);
+            }
+            else
+            {
+                registry.emplace(std::move(key_signature), id);
+            }
+        }
+    };
+
+    // the value iterator returns the keys ordered, so only the path of the previous key can still change
+    for (auto iter = source.begin(); iter != source.end(); iter++)
+    {
+        const key_t& key = iter.get_key();
+        for (common = 0; common < key.size() && common < previous.size() && key.get_element(common) == previous.get_element(common); common++);
+        minimize(common);
+        for (std::size_t i = common; i < key.size(); i++)
+        {
+            if (states.size() > std::numeric_limits<uint32_t>::max()) throw std::length_error("Automaton exceeds the 32-bit state range");
+            states[path.back()].edges.push_back(std::make_pair(key.get_element(i), (uint32_t)states.size()));
+            path.push_back((uint32_t)states.size());
+            states.push_back(build_state{ {}, 0, false });
+        }
+        states[path.back()].final = true;
+        values.push_back(iter.get_data());
+        previous = key;
+    }
+    minimize(0);
+    count_keys(0);
+
+    // renumber the remaining states in depth-first order and store them in the flat arrays
+    std::vector<uint32_t> new_id(states.size(), 0);
+    std::vector<bool> visited(states.size(), false);
+    std::vector<uint32_t> order, stack(1, 0);
+    visited[0] = true;
+    while (!stack.empty())
+    {
+        uint32_t id = stack.back();
+        stack.pop_back();
+        new_id[id] = (uint32_t)order.size();
+        order.push_back(id);
+        for (auto current = states[id].edges.rbegin(); current != states[id].edges.rend(); current++)
+        {
+            if (visited[current->second]) continue;
+            visited[current->second] = true;
+            stack.push_back(current->second);
+        }
+    }
+    this->_states.clear();
+    this->_edges.clear();
+    this->_states.resize(order.size());
+    for (uint32_t id : order)
+    {
+        state& flat = this->_states[new_id[id]];
+        uint32_t before = states[id].final ? 1 : 0;
+        flat.first_edge = (uint32_t)this->_edges.size();
+        flat.edge_count = (uint32_t)states[id].edges.size();
+        flat.count = states[id].count;
+        flat.final = states[id].final;
+        for (const std::pair<uint8_t, uint32_t>& current : states[id].edges)
+        {
+            this->_edges.push_back(edge{ new_id[current.second], before, current.first });
+            before += states[current.second].count;
+        }
+    }
+    this->_edges.shrink_to_fit();
+    this->_values = std::move(values);
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::dawg<children_count, value_t>::clear()
+{
+    // the empty automaton still has a root state without edges
+    this->_states.assign(1, state{ 0, 0, 0, false });
+    this->_edges.clear();
+    this->_values.clear();
+}
+
+template<std::size_t children_count, typename value_t>
+std::size_t
+trie::dawg<children_count, value_t>::index_of(const key_t& key) const
+{
+    std::size_t index = 0;
+    uint32_t current = 0;
+    const edge* helper;
+    for (std::size_t i = 0; i < key.size(); i++)
+    {
+        helper = this->find_edge(current, key.get_element(i));
+        if (helper == nullptr) return npos;
+        index += helper->before; // all keys that branch off before this edge are smaller than the key
+        current = helper->target;
+    }
+    return this->_states[current].final ? index : npos;
+}
+
+template<std::size_t children_count, typename value_t>
+typename trie::dawg<children_count, value_t>::key_t
+trie::dawg<children_count, value_t>::key_at(std::size_t index) const
+{
+    key_t result;
+    uint32_t current = 0;
+    if (index >= this->size()) throw std::out_of_range("Automaton does not have the requested key index");
+    while (!(this->_states[current].final && index == 0))
+    {
+        // take the last edge that has at most 'index' keys in front of it
+        const state& helper = this->_states[current];
+        std::size_t edge_index = helper.first_edge + helper.edge_count - 1;
+        while (this->_edges[edge_index].before > index) --edge_index;
+        index -= this->_edges[edge_index].before;
+        result.push_back(this->_edges[edge_index].label);
+        current = this->_edges[edge_index].target;
+    }
+    return result;
+}
+
+template<std::size_t children_count, typename value_t>
+const std::shared_ptr<value_t>&
+trie::dawg<children_count, value_t>::at(const key_t& key) const
+{
+    std::size_t index = this->index_of(key);
+    if (index == npos) throw std::out_of_range("Automaton does not have the requested key");
+    return this->_values[index];
+}
+
+template<std::size_t children_count, typename value_t>
+std::size_t
+trie::dawg<children_count, value_t>::memory_usage() const
+{
+    return this->_states.capacity() * sizeof(state) + this->_edges.capacity() * sizeof(edge)
+        + this->_values.capacity() * sizeof(std::shared_ptr<value_t>);
+}
+
+template<std::size_t children_count, typename value_t>
+trie::dawg<children_count, value_t>::value_iterator::value_iterator(const dawg* source, bool at_begin) : _dawg(source)
+{
+    if (!at_begin || this->_dawg->size() == 0) return;
+    this->_stack.push_back(frame{ 0, this->_dawg->_states[0].first_edge });
+    this->cur_index = 0;
+    if (!this->_dawg->_states[0].final)
+    {
+        this->cur_index = npos; // next_value increments the index, npos + 1 wraps to the first index
+        this->next_value();
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::dawg<children_count, value_t>::value_iterator::next_value()
+{
+    while (!this->_stack.empty())
+    {
+        frame& top = this->_stack.back();
+        const state& current = this->_dawg->_states[top.state];
+        if (top.next_edge < current.first_edge + current.edge_count)
+        {
+            // follow the next edge, stop if a key ends at its target
+            const edge& helper = this->_dawg->_edges[top.next_edge++];
+            this->cur_key.push_back(helper.label);
+            this->_stack.push_back(frame{ helper.target, this->_dawg->_states[helper.target].first_edge });
+            if (this->_dawg->_states[helper.target].final)
+            {
+                ++this->cur_index;
+                return;
+            }
+        }
+        else
+        {
+            // all edges followed, go back to the previous state
+            this->_stack.pop_back();
+            if (!this->_stack.empty()) this->cur_key.pop_back();
+        }
+    }
+    this->cur_index = npos;
+    this->cur_key.clear();
+}
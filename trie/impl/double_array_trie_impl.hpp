@@ -0,0 +1,164 @@
+/**
+* @file     trie/impl/double_array_trie_impl.hpp
+* @brief    include file for the implementations for the double-array trie class
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <limits>
+#include <stdexcept>
+
+#include "../double_array_trie.hpp"
+
+template<typename value_t>
+void
+trie::double_array_trie<value_t>::reserve_units(std::size_t count)
+{
+    if (count > (std::size_t)std::numeric_limits<int32_t>::max()) throw std::length_error("Double-array trie exceeds the 32-bit state range");
+    if (count <= this->_units.size()) return;
+    // grow exponentially to keep the number of reallocations low, new slots are marked as unused
+    this->_units.resize(std::max(count, this->_units.size() * 2), unit{ 0, -1, -1 });
+}
+
+template<typename value_t>
+int32_t
+trie::double_array_trie<value_t>::find_state(std::string_view key) const
+{
+    int32_t state = 0;
+    std::size_t next;
+    for (std::size_t i = 0; i < key.size(); i++)
+    {
+        next = (std::size_t)this->_units[state].base + (uint8_t)key[i];
+        if (next >= this->_units.size() || this->_units[next].check != state) return -1;
+        state = (int32_t)next;
+    }
+    return state;
+}
+
+template<typename value_t>
+void
+trie::double_array_trie<value_t>::build(trie::basic_trie<256, value_t>& source)
+{
+    struct task
+    {
+        std::size_t first, last, depth;
+        int32_t state;
+    };
+    // collect all key-value pairs, the value iterator returns them ordered by key
+    std::vector<std::pair<std::string, std::shared_ptr<value_t> > > pairs;
+    for (auto iter = source.begin(); iter != source.end(); iter++)
+    {
+        pairs.push_back(std::make_pair(iter.get_key().to_string(), iter.get_data()));
+    }
+
+    this->clear();
+
+    std::vector<task> stack;
+    std::vector<std::pair<uint8_t, std::size_t> > children; // child label and first pair of the child
+    std::size_t search_start = 1, skipped, index, position, base;
+    bool fits;
+    stack.push_back(task{ 0, pairs.size(), 0, 0 });
+    while (!stack.empty())
+    {
+        task current = stack.back();
+        stack.pop_back();
+        index = current.first;
+
+        // a key ending at this state is always the first one of the range because of the key order
+        if (index < current.last && pairs.at(index).first.size() == current.depth)
+        {
+            this->_units.at(current.state).value = (int32_t)this->_values.size();
+            this->_values.push_back(pairs.at(index).second);
+            ++index;
+        }
+        // collect the distinct bytes at this depth, every one of them is a child state
+        children.clear();
+        while (index < current.last)
+        {
+            children.push_back(std::make_pair((uint8_t)pairs.at(index).first.at(current.depth), index));
+            while (index < current.last && (uint8_t)pairs.at(index).first.at(current.depth) == children.back().first) ++index;
+        }
+        if (children.empty()) continue;
+
+        // find the first base where all children fit into unused slots, base has to be at least 1 so no child collides with the root
+        position = std::max(search_start, (std::size_t)children.front().first + 1);
+        skipped = 0;
+        while (true)
+        {
+            this->reserve_units(position + 256);
+            if (this->_units[position].check < 0) // only unused slots are candidates for the first child
+            {
+                base = position - children.front().first;
+                fits = true;
+                for (std::size_t i = 1; i < children.size() && fits; i++)
+                {
+                    fits = this->_units[base + children[i].first].check < 0;
+                }
+                if (fits) break;
+            }
+            else
+            {
+                ++skipped;
+            }
+            ++position;
+        }
+        // if almost every slot between the search start and the found slot is used, later searches can skip that region
+        if (skipped * 20 >= (position - search_start) * 19) search_start = position;
+
+        // claim the slots and schedule the children
+        this->_units.at(current.state).base = (int32_t)base;
+        for (std::size_t i = 0; i < children.size(); i++)
+        {
+            this->_units[base + children[i].first].check = current.state;
+            stack.push_back(task{ children[i].second, (i + 1 < children.size()) ? children[i + 1].second : current.last, current.depth + 1, (int32_t)(base + children[i].first) });
+        }
+    }
+
+    // drop the unused slots at the end of the array
+    index = this->_units.size();
+    while (index > 1 && this->_units[index - 1].check < 0) --index;
+    this->_units.resize(index);
+    this->_units.shrink_to_fit();
+    this->_values.shrink_to_fit();
+}
+
+template<typename value_t>
+void
+trie::double_array_trie<value_t>::clear()
+{
+    // the root state is state 0. It has no parent, its check marks the slot as used but matches no state,
+    // otherwise the byte 0x00 would lead from a root without children (base 0) back to the root
+    this->_units.assign(1, unit{ 0, root_check, -1 });
+    this->_values.clear();
+}
+
+template<typename value_t>
+const std::shared_ptr<value_t>*
+trie::double_array_trie<value_t>::find(std::string_view key) const
+{
+    int32_t state = this->find_state(key);
+    if (state < 0 || this->_units[state].value < 0) return nullptr;
+    return &this->_values[this->_units[state].value];
+}
+
+template<typename value_t>
+const std::shared_ptr<value_t>&
+trie::double_array_trie<value_t>::at(std::string_view key) const
+{
+    const std::shared_ptr<value_t>* result = this->find(key);
+    if (result == nullptr) throw std::out_of_range("Trie does not have the requested child");
+    return *result;
+}
+
+template<typename value_t>
+std::size_t
+trie::double_array_trie<value_t>::memory_usage() const
+{
+    return this->_units.capacity() * sizeof(unit) + this->_values.capacity() * sizeof(std::shared_ptr<value_t>);
+}
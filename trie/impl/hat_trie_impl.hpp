@@ -0,0 +1,512 @@
+/**
+* @file     trie/impl/hat_trie_impl.hpp
+* @brief    include file for the implementations for the hybrid trie class
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "../hat_trie.hpp"
+
+template<std::size_t children_count, typename value_t>
+uint64_t
+trie::hat_trie<children_count, value_t>::bucket::hash(const key_t& key, std::size_t offset)
+{
+    uint64_t result = 0xcbf29ce484222325ull; // 64-bit FNV-1a
+    for (std::size_t i = offset; i < key.size(); i++)
+    {
+        result = (result ^ key.get_element(i)) * 0x100000001b3ull;
+    }
+    return result;
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::hat_trie<children_count, value_t>::bucket::push_element(uint8_t element)
+{
+    std::size_t shift_amount = this->element_count * element_bits % 8;
+    if (shift_amount == 0) this->elements.push_back(0);
+    this->elements.back() |= (uint8_t)(element << shift_amount);
+    ++this->element_count;
+}
+
+template<std::size_t children_count, typename value_t>
+bool
+trie::hat_trie<children_count, value_t>::bucket::less(const entry& left, const entry& right) const
+{
+    for (std::size_t i = 0; i < left.length && i < right.length; i++)
+    {
+        uint8_t left_element = this->get_element(left.offset + i), right_element = this->get_element(right.offset + i);
+        if (left_element != right_element) return left_element < right_element;
+    }
+    return left.length < right.length;
+}
+
+template<std::size_t children_count, typename value_t>
+std::size_t
+trie::hat_trie<children_count, value_t>::bucket::slot_of(std::size_t index) const
+{
+    std::size_t mask = this->slots.size() - 1, slot = this->home_slot(this->entries[index].hash);
+    while (this->slots[slot] != index + 1) slot = (slot + 1) & mask;
+    return slot;
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::hat_trie<children_count, value_t>::bucket::index_entry(std::size_t index)
+{
+    if (this->entries.size() * 4 > this->slots.size() * 3)
+    {
+        this->rebuild_index(); // this also indexes the new entry
+        return;
+    }
+    std::size_t mask = this->slots.size() - 1, slot = this->home_slot(this->entries[index].hash);
+    while (this->slots[slot] != 0) slot = (slot + 1) & mask;
+    this->slots[slot] = (uint32_t)(index + 1);
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::hat_trie<children_count, value_t>::bucket::rebuild_index()
+{
+    std::size_t count = 8, mask, slot;
+    while (count < this->entries.size() * 2) count *= 2;
+    this->slots.assign(count, 0);
+    mask = count - 1;
+    for (std::size_t index = 0; index < this->entries.size(); index++)
+    {
+        for (slot = this->home_slot(this->entries[index].hash); this->slots[slot] != 0; slot = (slot + 1) & mask);
+        this->slots[slot] = (uint32_t)(index + 1);
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+std::ptrdiff_t
+trie::hat_trie<children_count, value_t>::bucket::find(const key_t& key, std::size_t offset, uint64_t key_hash) const
+{
+    std::size_t length = key.size() - offset, i;
+    if (this->slots.empty()) return -1;
+    // the probe sequence ends at the first free slot, the cached hash and the length reject the other entries on it
+    // before the elements have to be compared
+    for (std::size_t mask = this->slots.size() - 1, slot = this->home_slot(key_hash); this->slots[slot] != 0; slot = (slot + 1) & mask)
+    {
+        const entry& current = this->entries[this->slots[slot] - 1];
+        if (current.hash != key_hash || current.length != length) continue;
+        for (i = 0; i < length && this->get_element(current.offset + i) == key.get_element(offset + i); i++);
+        if (i == length) return (std::ptrdiff_t)this->slots[slot] - 1;
+    }
+    return -1;
+}
+
+template<std::size_t children_count, typename value_t>
+std::shared_ptr<value_t>&
+trie::hat_trie<children_count, value_t>::bucket::insert(const key_t& key, std::size_t offset, uint64_t key_hash)
+{
+    this->entries.push_back(entry{ key_hash, (uint32_t)this->element_count, (uint32_t)(key.size() - offset), nullptr });
+    for (std::size_t i = offset; i < key.size(); i++)
+    {
+        this->push_element(key.get_element(i));
+    }
+    this->index_entry(this->entries.size() - 1);
+    this->sorted = false;
+    return this->entries.back().data;
+}
+
+template<std::size_t children_count, typename value_t>
+template<typename element_source>
+void
+trie::hat_trie<children_count, value_t>::bucket::append(std::size_t length, std::shared_ptr<value_t> data, element_source element_of)
+{
+    uint64_t result = 0xcbf29ce484222325ull; // has to match the hash of a key
+    this->entries.push_back(entry{ 0, (uint32_t)this->element_count, (uint32_t)length, data });
+    for (std::size_t i = 0; i < length; i++)
+    {
+        uint8_t element = element_of(i);
+        this->push_element(element);
+        result = (result ^ element) * 0x100000001b3ull;
+    }
+    this->entries.back().hash = result;
+    this->index_entry(this->entries.size() - 1);
+    this->sorted = false;
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::hat_trie<children_count, value_t>::bucket::erase(std::size_t index)
+{
+    std::size_t mask = this->slots.size() - 1, slot = this->slot_of(index), next, home;
+    this->garbage += this->entries.at(index).length;
+    // backward shift deletion: move the following entries of the probe sequence up, so no probe sequence is cut at the freed slot
+    this->slots[slot] = 0;
+    for (next = (slot + 1) & mask; this->slots[next] != 0; next = (next + 1) & mask)
+    {
+        home = this->home_slot(this->entries[this->slots[next] - 1].hash);
+        if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+            this->slots[slot] = this->slots[next];
+            this->slots[next] = 0;
+            slot = next;
+        }
+    }
+    if (index + 1 != this->entries.size())
+    {
+        this->slots[this->slot_of(this->entries.size() - 1)] = (uint32_t)(index + 1);
+        this->entries[index] = std::move(this->entries.back());
+        this->sorted = false;
+    }
+    this->entries.pop_back();
+    // the element buffer is compacted once most of it belongs to erased entries
+    if (this->garbage * 2 > this->element_count)
+    {
+        this->sorted = false;
+        this->sort();
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::hat_trie<children_count, value_t>::bucket::sort()
+{
+    if (this->sorted) return;
+    std::sort(this->entries.begin(), this->entries.end(), [this](const entry& left, const entry& right) { return this->less(left, right); });
+    // rewrite the buffer in the sorted order, this also drops the elements of erased entries
+    std::vector<uint8_t> old = std::move(this->elements);
+    this->elements.clear();
+    this->elements.reserve(((this->element_count - this->garbage) * element_bits + 7) / 8);
+    this->element_count = 0;
+    for (entry& current : this->entries)
+    {
+        std::size_t offset = current.offset;
+        current.offset = (uint32_t)this->element_count;
+        for (std::size_t i = 0; i < current.length; i++)
+        {
+            this->push_element(element_at(old, offset + i));
+        }
+    }
+    this->garbage = 0;
+    this->sorted = true;
+    this->rebuild_index(); // the entries moved
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::hat_trie<children_count, value_t>::burst(node* _node)
+{
+    std::vector<node*> pending(1, _node);
+    while (!pending.empty())
+    {
+        node* current = pending.back();
+        std::shared_ptr<bucket> old = std::move(current->container);
+        pending.pop_back();
+        current->container = nullptr;
+        // move every entry one level down, the first element of the suffix selects the child bucket
+        for (const typename bucket::entry& helper : old->entries)
+        {
+            if (helper.length == 0)
+            {
+                current->data = helper.data;
+                current->has_data = true;
+                continue;
+            }
+            std::shared_ptr<node>& child = current->child(old->get_element(helper.offset));
+            if (child == nullptr)
+            {
+                child = std::make_shared<node>();
+                child->container = std::make_shared<bucket>();
+            }
+            const bucket& source = *old;
+            child->container->append(helper.length - 1, helper.data,
+                [&source, &helper](std::size_t i) { return source.get_element(helper.offset + 1 + i); });
+        }
+        // if all entries share the same first element, the new bucket is still too big
+        for (std::shared_ptr<node>& child : current->children)
+        {
+            if (child != nullptr && child->container != nullptr && child->container->entries.size() > this->_burst_threshold)
+            {
+                pending.push_back(child.get());
+            }
+        }
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::hat_trie<children_count, value_t>::merge(node* _node)
+{
+    std::shared_ptr<bucket> merged = std::make_shared<bucket>();
+    if (_node->has_data) merged->append(0, _node->data, [](std::size_t) { return (uint8_t)0; });
+    for (std::size_t element = 0; element < children_count; element++)
+    {
+        if (_node->children[element] == nullptr) continue;
+        // the suffixes of the child bucket get the child's key element in front of them
+        const bucket& source = *_node->children[element]->container;
+        for (const typename bucket::entry& helper : source.entries)
+        {
+            merged->append(helper.length + 1, helper.data,
+                [&source, &helper, element](std::size_t i) { return (i == 0) ? (uint8_t)element : source.get_element(helper.offset + i - 1); });
+        }
+    }
+    for (std::shared_ptr<node>& child : _node->children) child = nullptr;
+    _node->data = nullptr;
+    _node->has_data = false;
+    _node->container = merged;
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::hat_trie<children_count, value_t>::prune(std::vector<std::pair<node*, uint8_t> >& path, node* _node)
+{
+    std::size_t count;
+    // a node without keys below it is removed from its parent, the root is kept and merged into an empty bucket below
+    while (!path.empty())
+    {
+        if (_node->container != nullptr ? !_node->container->entries.empty() : (_node->has_data
+            || std::any_of(_node->children.begin(), _node->children.end(), [](const std::shared_ptr<node>& child) { return child != nullptr; })))
+        {
+            break;
+        }
+        path.back().first->child(path.back().second) = nullptr;
+        _node = path.back().first;
+        path.pop_back();
+    }
+    // the threshold for merging is half of the burst threshold, so a bucket that just burst is not merged again by the next erase
+    while (_node->container == nullptr)
+    {
+        count = _node->has_data ? 1 : 0;
+        for (const std::shared_ptr<node>& child : _node->children)
+        {
+            if (child == nullptr) continue;
+            if (child->container == nullptr) return;
+            count += child->container->entries.size();
+        }
+        if (count > this->_burst_threshold / 2) return;
+        this->merge(_node);
+        if (path.empty()) return;
+        _node = path.back().first;
+        path.pop_back();
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+std::shared_ptr<value_t>*
+trie::hat_trie<children_count, value_t>::find(const key_t& key) const
+{
+    node* helper = this->_root.get();
+    std::ptrdiff_t index;
+    for (std::size_t i = 0; ; i++)
+    {
+        if (helper->container != nullptr)
+        {
+            index = helper->container->find(key, i, bucket::hash(key, i));
+            return (index < 0) ? nullptr : &helper->container->entries[index].data;
+        }
+        if (i == key.size()) return helper->has_data ? &helper->data : nullptr;
+        helper = helper->child(key.get_element(i)).get();
+        if (helper == nullptr) return nullptr;
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+std::shared_ptr<value_t>&
+trie::hat_trie<children_count, value_t>::at(const key_t& key)
+{
+    std::shared_ptr<value_t>* result = this->find(key);
+    if (result == nullptr) throw std::out_of_range("Trie does not have the requested child");
+    return *result;
+}
+
+template<std::size_t children_count, typename value_t>
+bool
+trie::hat_trie<children_count, value_t>::insert(const key_t& key, std::shared_ptr<value_t> value)
+{
+    node* helper = this->_root.get();
+    uint64_t key_hash;
+    for (std::size_t i = 0; ; i++)
+    {
+        if (helper->container != nullptr)
+        {
+            // the rest of the key is stored as a suffix in the bucket
+            key_hash = bucket::hash(key, i);
+            if (helper->container->find(key, i, key_hash) >= 0) return false;
+            helper->container->insert(key, i, key_hash) = value;
+            ++this->_size;
+            if (helper->container->entries.size() > this->_burst_threshold) this->burst(helper);
+            return true;
+        }
+        if (i == key.size())
+        {
+            if (helper->has_data) return false;
+            helper->data = value;
+            helper->has_data = true;
+            ++this->_size;
+            return true;
+        }
+        std::shared_ptr<node>& child = helper->child(key.get_element(i));
+        if (child == nullptr)
+        {
+            // a new subtree always starts as an empty bucket
+            child = std::make_shared<node>();
+            child->container = std::make_shared<bucket>();
+        }
+        helper = child.get();
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+bool
+trie::hat_trie<children_count, value_t>::erase(const key_t& key)
+{
+    node* helper = this->_root.get();
+    std::vector<std::pair<node*, uint8_t> > path;
+    std::ptrdiff_t index;
+    for (std::size_t i = 0; ; i++)
+    {
+        if (helper->container != nullptr)
+        {
+            index = helper->container->find(key, i, bucket::hash(key, i));
+            if (index < 0) return false;
+            helper->container->erase((std::size_t)index);
+            --this->_size;
+            this->prune(path, helper);
+            return true;
+        }
+        if (i == key.size())
+        {
+            if (!helper->has_data) return false;
+            helper->data = nullptr;
+            helper->has_data = false;
+            --this->_size;
+            this->prune(path, helper);
+            return true;
+        }
+        path.emplace_back(helper, key.get_element(i));
+        helper = helper->child(key.get_element(i)).get();
+        if (helper == nullptr) return false;
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::hat_trie<children_count, value_t>::clear()
+{
+    // an empty trie is a single bucket
+    this->_root = std::make_shared<node>();
+    this->_root->container = std::make_shared<bucket>();
+    this->_size = 0;
+}
+
+template<std::size_t children_count, typename value_t>
+std::size_t
+trie::hat_trie<children_count, value_t>::node_count() const
+{
+    std::size_t result = 0;
+    std::vector<const node*> pending(1, this->_root.get());
+    while (!pending.empty())
+    {
+        const node* current = pending.back();
+        pending.pop_back();
+        ++result;
+        for (const std::shared_ptr<node>& child : current->children)
+        {
+            if (child != nullptr) pending.push_back(child.get());
+        }
+    }
+    return result;
+}
+
+template<std::size_t children_count, typename value_t>
+trie::hat_trie<children_count, value_t>::value_iterator::value_iterator(node* root)
+{
+    this->_stack.push_back(frame{ root, -1 });
+    this->next_value();
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::hat_trie<children_count, value_t>::value_iterator::push_suffix()
+{
+    const typename bucket::entry& current = this->cur_bucket->entries[this->cur_entry];
+    for (std::size_t i = 0; i < current.length; i++)
+    {
+        this->cur_key.push_back(this->cur_bucket->get_element(current.offset + i));
+    }
+    this->cur_data = &this->cur_bucket->entries[this->cur_entry].data;
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::hat_trie<children_count, value_t>::value_iterator::pop_suffix()
+{
+    for (std::size_t i = 0; i < this->cur_bucket->entries[this->cur_entry].length; i++)
+    {
+        this->cur_key.pop_back();
+    }
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::hat_trie<children_count, value_t>::value_iterator::next_value()
+{
+    if (this->cur_bucket != nullptr)
+    {
+        // continue with the next entry of the current bucket
+        this->pop_suffix();
+        if (++this->cur_entry < this->cur_bucket->entries.size())
+        {
+            this->push_suffix();
+            return;
+        }
+        this->cur_bucket = nullptr;
+    }
+    while (!this->_stack.empty())
+    {
+        frame& top = this->_stack.back();
+        node* current = top.current;
+        if (current->container != nullptr)
+        {
+            // enter the bucket once, it is sorted first so the suffixes are visited in key order
+            if (top.next_child < 0 && !current->container->entries.empty())
+            {
+                top.next_child = children_count;
+                current->container->sort();
+                this->cur_bucket = current->container.get();
+                this->cur_entry = 0;
+                this->push_suffix();
+                return;
+            }
+        }
+        else
+        {
+            if (top.next_child < 0)
+            {
+                top.next_child = 0;
+                if (current->has_data)
+                {
+                    this->cur_data = &current->data;
+                    return;
+                }
+            }
+            while (top.next_child < (std::ptrdiff_t)children_count && current->children[top.next_child] == nullptr) ++top.next_child;
+            if (top.next_child < (std::ptrdiff_t)children_count)
+            {
+                // descend into the next child
+                this->cur_key.push_back((uint8_t)top.next_child);
+                this->_stack.push_back(frame{ current->children[top.next_child++].get(), -1 });
+                continue;
+            }
+        }
+        // all keys below this node visited, go back to the parent
+        this->_stack.pop_back();
+        if (!this->_stack.empty()) this->cur_key.pop_back();
+    }
+    this->cur_data = nullptr;
+    this->cur_key.clear();
+}
@@ -0,0 +1,171 @@
+/**
+* @file     trie/impl/integer_trie_impl.hpp
+* @brief    include file for the implementations for the trie class with fixed-width integer keys
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <stdexcept>
+
+#include "../integer_trie.hpp"
+
+template<std::size_t children_count, typename integer_t, typename value_t>
+constexpr typename trie::integer_trie<children_count, integer_t, value_t>::encoded_t
+trie::integer_trie<children_count, integer_t, value_t>::encode(integer_t key)
+{
+    // flipping the sign bit moves the negative numbers in front of the positive ones
+    if constexpr (std::is_signed<integer_t>::value) return (encoded_t)((encoded_t)key ^ ((encoded_t)1 << (key_bits - 1)));
+    else return (encoded_t)key;
+}
+
+template<std::size_t children_count, typename integer_t, typename value_t>
+constexpr integer_t
+trie::integer_trie<children_count, integer_t, value_t>::decode(encoded_t encoded)
+{
+    if constexpr (std::is_signed<integer_t>::value) return (integer_t)(encoded_t)(encoded ^ ((encoded_t)1 << (key_bits - 1)));
+    else return (integer_t)encoded;
+}
+
+template<std::size_t children_count, typename integer_t, typename value_t>
+template<std::size_t level>
+std::shared_ptr<value_t>*
+trie::integer_trie<children_count, integer_t, value_t>::find(node<level>* current, encoded_t encoded)
+{
+    std::size_t element = get_element<level>(encoded);
+    auto& child = current->children[element];
+    if constexpr (level + 1 == depth) return current->present[element] ? &child : nullptr;
+    else return (child == nullptr) ? nullptr : find<level + 1>(child.get(), encoded);
+}
+
+template<std::size_t children_count, typename integer_t, typename value_t>
+template<std::size_t level>
+bool
+trie::integer_trie<children_count, integer_t, value_t>::insert(node<level>* current, encoded_t encoded, std::shared_ptr<value_t>& value)
+{
+    std::size_t element = get_element<level>(encoded);
+    auto& child = current->children[element];
+    if constexpr (level + 1 == depth)
+    {
+        if (current->present[element]) return false;
+        child = std::move(value);
+        current->present[element] = true;
+        ++current->count;
+        return true;
+    }
+    else
+    {
+        if (child == nullptr)
+        {
+            child = std::make_shared<node<level + 1> >();
+            ++current->count;
+        }
+        return insert<level + 1>(child.get(), encoded, value);
+    }
+}
+
+template<std::size_t children_count, typename integer_t, typename value_t>
+template<std::size_t level>
+bool
+trie::integer_trie<children_count, integer_t, value_t>::erase(node<level>* current, encoded_t encoded)
+{
+    std::size_t element = get_element<level>(encoded);
+    auto& child = current->children[element];
+    if constexpr (level + 1 == depth)
+    {
+        if (!current->present[element]) return false;
+        current->present[element] = false;
+    }
+    else
+    {
+        if (child == nullptr || !erase<level + 1>(child.get(), encoded)) return false;
+        if (child->count != 0) return true; // the child still holds other keys
+    }
+    child = nullptr;
+    --current->count;
+    return true;
+}
+
+template<std::size_t children_count, typename integer_t, typename value_t>
+template<std::size_t level>
+std::shared_ptr<value_t>*
+trie::integer_trie<children_count, integer_t, value_t>::lower_bound(node<level>* current, encoded_t encoded, bool bounded, encoded_t& result)
+{
+    std::size_t first = bounded ? get_element<level>(encoded) : 0;
+    std::shared_ptr<value_t>* found;
+    for (std::size_t i = first; i < children_count; i++)
+    {
+        auto& child = current->children[i];
+        if constexpr (level + 1 == depth) found = current->present[i] ? &child : nullptr;
+        else found = (child == nullptr) ? nullptr : lower_bound<level + 1>(child.get(), encoded, bounded && i == first, result);
+        if (found != nullptr)
+        {
+            result |= (encoded_t)i << (key_bits - (level + 1) * bits_per_element);
+            return found;
+        }
+    }
+    return nullptr;
+}
+
+template<std::size_t children_count, typename integer_t, typename value_t>
+std::shared_ptr<value_t>&
+trie::integer_trie<children_count, integer_t, value_t>::at(integer_t key)
+{
+    std::shared_ptr<value_t>* data = find<0>(this->_root.get(), encode(key));
+    if (data == nullptr) throw std::out_of_range("Key not found");
+    return *data;
+}
+
+template<std::size_t children_count, typename integer_t, typename value_t>
+bool
+trie::integer_trie<children_count, integer_t, value_t>::insert(integer_t key, std::shared_ptr<value_t> value)
+{
+    if (value == nullptr) return false;
+    if (!insert<0>(this->_root.get(), encode(key), value)) return false;
+    ++this->_size;
+    return true;
+}
+
+template<std::size_t children_count, typename integer_t, typename value_t>
+bool
+trie::integer_trie<children_count, integer_t, value_t>::erase(integer_t key)
+{
+    if (!erase<0>(this->_root.get(), encode(key))) return false;
+    --this->_size;
+    return true;
+}
+
+template<std::size_t children_count, typename integer_t, typename value_t>
+void
+trie::integer_trie<children_count, integer_t, value_t>::clear()
+{
+    this->_root = std::make_shared<node<0> >();
+    this->_size = 0;
+}
+
+template<std::size_t children_count, typename integer_t, typename value_t>
+trie::integer_trie<children_count, integer_t, value_t>::value_iterator::value_iterator(node<0>* root, encoded_t encoded) : _root(root)
+{
+    this->cur_data = integer_trie::lower_bound<0>(this->_root, encoded, true, this->_encoded);
+}
+
+template<std::size_t children_count, typename integer_t, typename value_t>
+void
+trie::integer_trie<children_count, integer_t, value_t>::value_iterator::next_value()
+{
+    encoded_t next = this->_encoded + 1;
+    if (this->cur_data == nullptr) return;
+    if (next == 0)
+    {
+        // the current key is the largest possible key
+        this->cur_data = nullptr;
+        return;
+    }
+    this->_encoded = 0;
+    this->cur_data = integer_trie::lower_bound<0>(this->_root, next, true, this->_encoded);
+}
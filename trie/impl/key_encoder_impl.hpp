@@ -0,0 +1,224 @@
+/**
+* @file     trie/impl/key_encoder_impl.hpp
+* @brief    include file for the implementations for the order preserving key encoder and decoder
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "../key_encoder.hpp"
+
+namespace trie
+{
+    namespace detail
+    {
+        template<typename type_t>
+        struct is_duration : std::false_type {};
+        template<typename rep_t, typename period_t>
+        struct is_duration<std::chrono::duration<rep_t, period_t> > : std::true_type {};
+
+        template<typename type_t>
+        struct is_time_point : std::false_type {};
+        template<typename clock_t, typename duration_t>
+        struct is_time_point<std::chrono::time_point<clock_t, duration_t> > : std::true_type {};
+
+        // unsigned integer with the same size as a floating point type
+        template<typename float_t>
+        using float_bits_t = typename std::conditional<sizeof(float_t) == 4, uint32_t, uint64_t>::type;
+    } // namespace detail
+} // namespace trie
+
+template<typename column_t>
+trie::key_encoder&
+trie::key_encoder::add(const column_t& value)
+{
+    if constexpr (std::is_same<column_t, bool>::value)
+    {
+        this->_bytes.push_back(value ? 1 : 0);
+    }
+    else if constexpr (std::is_enum<column_t>::value)
+    {
+        this->add(static_cast<typename std::underlying_type<column_t>::type>(value));
+    }
+    else if constexpr (std::is_integral<column_t>::value)
+    {
+        using encoded_t = typename std::make_unsigned<column_t>::type;
+        encoded_t encoded = (encoded_t)value;
+        // the sign bit is flipped, so negative numbers are ordered in front of the positive numbers
+        if constexpr (std::is_signed<column_t>::value) encoded = (encoded_t)(encoded ^ ((encoded_t)1 << (sizeof(encoded_t) * 8 - 1)));
+        for (std::size_t i = sizeof(encoded_t); i > 0; i--)
+        {
+            this->_bytes.push_back((char)(uint8_t)(encoded >> ((i - 1) * 8)));
+        }
+    }
+    else if constexpr (std::is_floating_point<column_t>::value)
+    {
+        static_assert(sizeof(column_t) == 4 || sizeof(column_t) == 8, "only 32 and 64 bit floating point numbers are supported");
+        using bits_t = detail::float_bits_t<column_t>;
+        static constexpr bits_t sign_bit = (bits_t)1 << (sizeof(bits_t) * 8 - 1);
+        bits_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        // larger negative numbers have larger magnitudes, inverting all bits reverses their order
+        bits = (bits & sign_bit) ? (bits_t)~bits : (bits_t)(bits | sign_bit);
+        this->add(bits);
+    }
+    else if constexpr (detail::is_duration<column_t>::value)
+    {
+        this->add(value.count());
+    }
+    else if constexpr (detail::is_time_point<column_t>::value)
+    {
+        this->add(value.time_since_epoch());
+    }
+    else
+    {
+        static_assert(std::is_convertible<const column_t&, std::string_view>::value, "unsupported column type");
+        std::string_view string(value);
+        for (char current : string)
+        {
+            this->_bytes.push_back(current);
+            if (current == '\0') this->_bytes.push_back('\xFF'); // escaped 0x00, ordered behind the terminator
+        }
+        this->_bytes.push_back('\0');
+        this->_bytes.push_back('\x01');
+    }
+    return *this;
+}
+
+inline trie::key_encoder&
+trie::key_encoder::add_prefix(std::string_view value)
+{
+    for (char current : value)
+    {
+        this->_bytes.push_back(current);
+        if (current == '\0') this->_bytes.push_back('\xFF');
+    }
+    return *this;
+}
+
+template<std::size_t children_count>
+trie::basic_key<children_count>
+trie::key_encoder::to_key(const std::string& bytes)
+{
+    if constexpr (children_count == 16)
+    {
+        std::string swapped(bytes);
+        for (char& current : swapped) current = (char)(uint8_t)(((uint8_t)current << 4) | ((uint8_t)current >> 4));
+        return trie::basic_key<children_count>(swapped.data(), swapped.size());
+    }
+    else
+    {
+        return trie::basic_key<children_count>(bytes.data(), bytes.size());
+    }
+}
+
+template<std::size_t children_count>
+std::string
+trie::key_encoder::from_key(const trie::basic_key<children_count>& key)
+{
+    std::string bytes(key.export_size(), '\0');
+    key.export_key(&bytes[0], bytes.size());
+    if constexpr (children_count == 16)
+    {
+        for (char& current : bytes) current = (char)(uint8_t)(((uint8_t)current << 4) | ((uint8_t)current >> 4));
+    }
+    return bytes;
+}
+
+inline void
+trie::key_decoder::require(std::size_t count) const
+{
+    if (this->_bytes.size() - this->_position < count) throw std::out_of_range("Encoded key ends inside of a column");
+}
+
+template<typename column_t>
+column_t
+trie::key_decoder::read()
+{
+    if constexpr (std::is_same<column_t, bool>::value)
+    {
+        this->require(1);
+        return this->_bytes[this->_position++] != 0;
+    }
+    else if constexpr (std::is_enum<column_t>::value)
+    {
+        return static_cast<column_t>(this->read<typename std::underlying_type<column_t>::type>());
+    }
+    else if constexpr (std::is_integral<column_t>::value)
+    {
+        using encoded_t = typename std::make_unsigned<column_t>::type;
+        encoded_t encoded = 0;
+        this->require(sizeof(encoded_t));
+        for (std::size_t i = 0; i < sizeof(encoded_t); i++)
+        {
+            encoded = (encoded_t)((encoded << 8) | (uint8_t)this->_bytes[this->_position++]); // big-endian
+        }
+        if constexpr (std::is_signed<column_t>::value) encoded = (encoded_t)(encoded ^ ((encoded_t)1 << (sizeof(encoded_t) * 8 - 1)));
+        return (column_t)encoded;
+    }
+    else if constexpr (std::is_floating_point<column_t>::value)
+    {
+        using bits_t = detail::float_bits_t<column_t>;
+        static constexpr bits_t sign_bit = (bits_t)1 << (sizeof(bits_t) * 8 - 1);
+        bits_t bits = this->read<bits_t>();
+        column_t value;
+        bits = (bits & sign_bit) ? (bits_t)(bits & ~sign_bit) : (bits_t)~bits;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    else if constexpr (detail::is_duration<column_t>::value)
+    {
+        return column_t(this->read<typename column_t::rep>());
+    }
+    else if constexpr (detail::is_time_point<column_t>::value)
+    {
+        return column_t(this->read<typename column_t::duration>());
+    }
+    else
+    {
+        static_assert(std::is_constructible<column_t, std::string>::value, "unsupported column type");
+        std::string value;
+        while (true)
+        {
+            this->require(1);
+            char current = this->_bytes[this->_position++];
+            if (current != '\0')
+            {
+                value.push_back(current);
+                continue;
+            }
+            this->require(1);
+            current = this->_bytes[this->_position++];
+            if (current == '\x01') break; // terminator
+            if (current != '\xFF') throw std::invalid_argument("Invalid escape sequence in an encoded string");
+            value.push_back('\0');
+        }
+        return column_t(std::move(value));
+    }
+}
+
+template<std::size_t children_count, typename... column_t>
+trie::basic_key<children_count>
+trie::encode_key(const column_t&... values)
+{
+    trie::key_encoder encoder;
+    (encoder.add(values), ...);
+    return encoder.key<children_count>();
+}
+
+template<typename... column_t, std::size_t children_count>
+std::tuple<column_t...>
+trie::decode_key(const trie::basic_key<children_count>& key)
+{
+    trie::key_decoder decoder(key);
+    return std::tuple<column_t...>{ decoder.read<column_t>()... }; // a braced initializer list is evaluated from left to right
+}
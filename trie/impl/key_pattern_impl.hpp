@@ -0,0 +1,507 @@
+/**
+* @file     trie/impl/key_pattern_impl.hpp
+* @brief    include file for the implementations for the glob and regular expression patterns
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include "../key_pattern.hpp"
+
+/**
+ * @brief recursive descent parser for the regular expressions and globs of key_pattern
+ */
+class trie::key_pattern::parser
+{
+protected:
+    std::string_view _pattern;
+    std::size_t _position{ 0 };
+
+    [[noreturn]] void error(const char* message) const
+    {
+        throw std::invalid_argument("Invalid pattern at position " + std::to_string(this->_position) + ": " + message);
+    }
+    bool at_end() const { return this->_position == this->_pattern.size(); }
+    char peek() const { return this->_pattern[this->_position]; }
+
+    // read the character after a backslash
+    std::bitset<256> parse_escape()
+    {
+        std::bitset<256> result;
+        char current;
+        if (this->at_end()) this->error("pattern ends with an escape character");
+        current = this->_pattern[this->_position++];
+        auto add_range = [&result](int first, int last) { for (int i = first; i <= last; i++) result.set((std::size_t)i); };
+        switch (current)
+        {
+        case 'd': case 'D':
+            add_range('0', '9');
+            break;
+        case 'w': case 'W':
+            add_range('0', '9'); add_range('A', 'Z'); add_range('a', 'z'); result.set('_');
+            break;
+        case 's': case 'S':
+            result.set(' '); result.set('\t'); result.set('\n'); result.set('\r'); result.set('\f'); result.set('\v');
+            break;
+        case 'n': result.set('\n'); break;
+        case 'r': result.set('\r'); break;
+        case 't': result.set('\t'); break;
+        case 'x':
+        {
+            if (this->_pattern.size() - this->_position < 2) this->error("incomplete \\x escape");
+            std::string digits(this->_pattern.substr(this->_position, 2));
+            if (!isxdigit((unsigned char)digits[0]) || !isxdigit((unsigned char)digits[1])) this->error("invalid \\x escape");
+            result.set((std::size_t)std::stoul(digits, nullptr, 16));
+            this->_position += 2;
+            break;
+        }
+        default:
+            result.set((uint8_t)current); // escaped literal
+        }
+        if (current == 'D' || current == 'W' || current == 'S') result.flip();
+        return result;
+    }
+
+    // read a bracket expression, the '[' is already consumed
+    std::bitset<256> parse_class(bool glob)
+    {
+        std::bitset<256> result, single;
+        bool negated = false, first = true;
+        int previous = -1; // the last single byte, the start of a possible range
+        if (!this->at_end() && (this->peek() == '^' || (glob && this->peek() == '!')))
+        {
+            negated = true;
+            ++this->_position;
+        }
+        while (true)
+        {
+            if (this->at_end()) this->error("missing ']'");
+            char current = this->_pattern[this->_position++];
+            if (current == ']' && !first) break;
+            first = false;
+            if (current == '-' && previous >= 0 && !this->at_end() && this->peek() != ']')
+            {
+                // range, the end might be escaped
+                int last;
+                current = this->_pattern[this->_position++];
+                if (current == '\\')
+                {
+                    single = this->parse_escape();
+                    if (single.count() != 1) this->error("invalid range end");
+                    for (last = 0; !single.test((std::size_t)last); last++);
+                }
+                else last = (uint8_t)current;
+                if (last < previous) this->error("invalid range");
+                for (int i = previous; i <= last; i++) result.set((std::size_t)i);
+                previous = -1;
+                continue;
+            }
+            if (current == '\\' && !glob)
+            {
+                single = this->parse_escape();
+                result |= single;
+                previous = -1;
+                if (single.count() == 1) for (previous = 0; !single.test((std::size_t)previous); previous++);
+                continue;
+            }
+            result.set((uint8_t)current);
+            previous = (uint8_t)current;
+        }
+        if (negated) result.flip();
+        return result;
+    }
+
+    syntax_ptr parse_atom()
+    {
+        std::bitset<256> set;
+        char current = this->_pattern[this->_position++];
+        switch (current)
+        {
+        case '(':
+        {
+            syntax_ptr inner = this->parse_alternation(false);
+            if (this->at_end() || this->peek() != ')') this->error("missing ')'");
+            ++this->_position;
+            return inner;
+        }
+        case '[':
+            return make_bytes(this->parse_class(false));
+        case '.':
+            return make_bytes(set.set());
+        case '\\':
+            return make_bytes(this->parse_escape());
+        case '^': case '$':
+            --this->_position;
+            this->error("anchors are only supported at the start and the end of an alternative");
+        case '*': case '+': case '?': case '{':
+            --this->_position;
+            this->error("quantifier without an operand");
+        default:
+            return make_bytes(set.set((uint8_t)current));
+        }
+    }
+
+    std::size_t parse_number()
+    {
+        std::size_t result = 0, digits = 0;
+        while (!this->at_end() && this->peek() >= '0' && this->peek() <= '9')
+        {
+            result = result * 10 + (std::size_t)(this->_pattern[this->_position++] - '0');
+            if (++digits > 4) this->error("repetition count too large");
+        }
+        if (digits == 0) this->error("expected a number");
+        return result;
+    }
+
+    syntax_ptr parse_repeat()
+    {
+        syntax_ptr result = this->parse_atom();
+        while (!this->at_end())
+        {
+            std::size_t min, max;
+            char current = this->peek();
+            if (current == '*') { min = 0; max = npos; }
+            else if (current == '+') { min = 1; max = npos; }
+            else if (current == '?') { min = 0; max = 1; }
+            else if (current == '{')
+            {
+                ++this->_position;
+                min = max = this->parse_number();
+                if (!this->at_end() && this->peek() == ',')
+                {
+                    ++this->_position;
+                    max = (!this->at_end() && this->peek() == '}') ? npos : this->parse_number();
+                }
+                if (this->at_end() || this->peek() != '}') this->error("missing '}'");
+                if (max < min) this->error("invalid repetition range");
+            }
+            else break;
+            ++this->_position;
+            std::vector<syntax_ptr> children;
+            children.push_back(std::move(result));
+            result = make_node(syntax_node::kind::repeat, std::move(children), min, max);
+        }
+        return result;
+    }
+
+    // anchored_end is only set for the top level, a '$' at the end of an alternative is consumed there
+    syntax_ptr parse_concat(bool top, bool* anchored_end)
+    {
+        std::vector<syntax_ptr> children;
+        while (!this->at_end() && this->peek() != '|' && this->peek() != ')')
+        {
+            if (top && this->peek() == '$' && (this->_position + 1 == this->_pattern.size() || this->_pattern[this->_position + 1] == '|'))
+            {
+                ++this->_position;
+                *anchored_end = true;
+                break;
+            }
+            children.push_back(this->parse_repeat());
+        }
+        return make_node(syntax_node::kind::concat, std::move(children));
+    }
+
+public:
+    parser(std::string_view pattern) : _pattern(pattern) {}
+
+    /**
+     * @brief parse alternatives up to the end of the pattern or a ')'. On the top level every alternative
+     *  without a '^' at its start or without a '$' at its end is extended by '.*' on that side (search semantics).
+     */
+    syntax_ptr parse_alternation(bool top)
+    {
+        std::vector<syntax_ptr> alternatives;
+        std::bitset<256> any;
+        any.set();
+        while (true)
+        {
+            bool anchored_start = false, anchored_end = false;
+            if (top && !this->at_end() && this->peek() == '^')
+            {
+                ++this->_position;
+                anchored_start = true;
+            }
+            syntax_ptr current = this->parse_concat(top, &anchored_end);
+            if (top)
+            {
+                std::vector<syntax_ptr> parts, any_part;
+                if (!anchored_start)
+                {
+                    any_part.push_back(make_bytes(any));
+                    parts.push_back(make_node(syntax_node::kind::repeat, std::move(any_part), 0, npos));
+                }
+                parts.push_back(std::move(current));
+                if (!anchored_end)
+                {
+                    any_part.clear();
+                    any_part.push_back(make_bytes(any));
+                    parts.push_back(make_node(syntax_node::kind::repeat, std::move(any_part), 0, npos));
+                }
+                current = make_node(syntax_node::kind::concat, std::move(parts));
+            }
+            alternatives.push_back(std::move(current));
+            if (this->at_end() || this->peek() != '|') break;
+            ++this->_position;
+        }
+        if (top && !this->at_end()) this->error("unmatched ')'");
+        return make_node(syntax_node::kind::alternation, std::move(alternatives));
+    }
+
+    syntax_ptr parse_glob()
+    {
+        std::vector<syntax_ptr> children;
+        std::bitset<256> set;
+        while (!this->at_end())
+        {
+            char current = this->_pattern[this->_position++];
+            set.reset();
+            if (current == '*')
+            {
+                std::vector<syntax_ptr> any;
+                any.push_back(make_bytes(set.set()));
+                children.push_back(make_node(syntax_node::kind::repeat, std::move(any), 0, npos));
+                continue;
+            }
+            if (current == '?') set.set();
+            else if (current == '[') set = this->parse_class(true);
+            else if (current == '\\')
+            {
+                if (this->at_end()) this->error("pattern ends with an escape character");
+                set.set((uint8_t)this->_pattern[this->_position++]);
+            }
+            else set.set((uint8_t)current);
+            children.push_back(make_bytes(set));
+        }
+        return make_node(syntax_node::kind::concat, std::move(children));
+    }
+};
+
+inline trie::key_pattern::syntax_ptr
+trie::key_pattern::make_bytes(const std::bitset<256>& set)
+{
+    syntax_ptr result = std::make_unique<syntax_node>();
+    result->type = syntax_node::kind::bytes;
+    result->set = set;
+    return result;
+}
+
+inline trie::key_pattern::syntax_ptr
+trie::key_pattern::make_node(syntax_node::kind type, std::vector<syntax_ptr> children, std::size_t min, std::size_t max)
+{
+    syntax_ptr result = std::make_unique<syntax_node>();
+    result->type = type;
+    result->children = std::move(children);
+    result->min = min;
+    result->max = max;
+    return result;
+}
+
+inline void
+trie::key_pattern::compile(const syntax_node& root, std::size_t max_states)
+{
+    struct nfa_state
+    {
+        std::vector<uint32_t> epsilon;
+        const std::bitset<256>* set{ nullptr }; // the bytes leading to 'target', nullptr if there is no byte transition
+        uint32_t target{ 0 };
+    };
+    std::vector<nfa_state> nfa;
+    const std::size_t max_nfa_states = max_states * 64;
+    auto add_state = [&nfa, max_nfa_states]() -> uint32_t
+    {
+        if (nfa.size() >= max_nfa_states) throw std::length_error("Pattern automaton exceeds the state limit");
+        nfa.emplace_back();
+        return (uint32_t)(nfa.size() - 1);
+    };
+    // Thompson construction, returns the start and the end state of the fragment. Repetitions are expanded into copies.
+    auto build = [&](const syntax_node& current, auto& self) -> std::pair<uint32_t, uint32_t>
+    {
+        uint32_t start = add_state(), end, cursor;
+        switch (current.type)
+        {
+        case syntax_node::kind::bytes:
+            end = add_state();
+            nfa[start].set = &current.set;
+            nfa[start].target = end;
+            return { start, end };
+        case syntax_node::kind::concat:
+            cursor = start;
+            for (const syntax_ptr& child : current.children)
+            {
+                std::pair<uint32_t, uint32_t> fragment = self(*child, self);
+                nfa[cursor].epsilon.push_back(fragment.first);
+                cursor = fragment.second;
+            }
+            return { start, cursor };
+        case syntax_node::kind::alternation:
+            end = add_state();
+            for (const syntax_ptr& child : current.children)
+            {
+                std::pair<uint32_t, uint32_t> fragment = self(*child, self);
+                nfa[start].epsilon.push_back(fragment.first);
+                nfa[fragment.second].epsilon.push_back(end);
+            }
+            return { start, end };
+        case syntax_node::kind::repeat:
+        default:
+            cursor = start;
+            for (std::size_t i = 0; i < current.min; i++)
+            {
+                std::pair<uint32_t, uint32_t> fragment = self(*current.children[0], self);
+                nfa[cursor].epsilon.push_back(fragment.first);
+                cursor = fragment.second;
+            }
+            end = add_state();
+            if (current.max == npos)
+            {
+                std::pair<uint32_t, uint32_t> fragment = self(*current.children[0], self);
+                nfa[cursor].epsilon.push_back(fragment.first);
+                nfa[fragment.second].epsilon.push_back(fragment.first);
+                nfa[fragment.second].epsilon.push_back(end);
+            }
+            else
+            {
+                for (std::size_t i = current.min; i < current.max; i++)
+                {
+                    std::pair<uint32_t, uint32_t> fragment = self(*current.children[0], self);
+                    nfa[cursor].epsilon.push_back(fragment.first);
+                    nfa[cursor].epsilon.push_back(end);
+                    cursor = fragment.second;
+                }
+            }
+            nfa[cursor].epsilon.push_back(end);
+            return { start, end };
+        }
+    };
+    std::pair<uint32_t, uint32_t> fragment = build(root, build);
+
+    // subset construction, a deterministic state is the sorted epsilon closure of a set of nfa states
+    std::map<std::vector<uint32_t>, uint32_t> known;
+    std::vector<std::vector<uint32_t> > subsets;
+    std::vector<uint8_t> visited(nfa.size(), 0);
+    auto closure = [&](std::vector<uint32_t> states)
+    {
+        std::vector<uint32_t> stack(states);
+        for (uint32_t current : states) visited[current] = 1;
+        while (!stack.empty())
+        {
+            uint32_t current = stack.back();
+            stack.pop_back();
+            for (uint32_t next : nfa[current].epsilon)
+            {
+                if (visited[next]) continue;
+                visited[next] = 1;
+                states.push_back(next);
+                stack.push_back(next);
+            }
+        }
+        for (uint32_t current : states) visited[current] = 0;
+        std::sort(states.begin(), states.end());
+        return states;
+    };
+    auto intern = [&](std::vector<uint32_t> states) -> uint32_t
+    {
+        auto found = known.find(states);
+        if (found != known.end()) return found->second;
+        if (subsets.size() >= max_states) throw std::length_error("Pattern automaton exceeds the state limit");
+        known.emplace(states, (uint32_t)subsets.size());
+        subsets.push_back(std::move(states));
+        this->_transitions.resize(subsets.size() * 256, 0);
+        return (uint32_t)(subsets.size() - 1);
+    };
+    this->_transitions.clear();
+    intern(closure(std::vector<uint32_t>(1, fragment.first)));
+    for (std::size_t current = 0; current < subsets.size(); current++)
+    {
+        std::vector<std::vector<uint32_t> > targets(256);
+        for (uint32_t state : subsets[current])
+        {
+            if (nfa[state].set == nullptr) continue;
+            for (std::size_t byte = 0; byte < 256; byte++)
+            {
+                if (nfa[state].set->test(byte)) targets[byte].push_back(nfa[state].target);
+            }
+        }
+        for (std::size_t byte = 0; byte < 256; byte++)
+        {
+            // neighbouring bytes usually lead to the same subset, skip the closure for them
+            if (byte > 0 && targets[byte] == targets[byte - 1])
+            {
+                this->_transitions[current * 256 + byte] = this->_transitions[current * 256 + byte - 1];
+                continue;
+            }
+            uint32_t next = intern(closure(targets[byte])); // might reallocate the transitions
+            this->_transitions[current * 256 + byte] = next;
+        }
+    }
+
+    // a state is live if an accepting state can be reached from it
+    std::vector<std::vector<uint32_t> > reverse(subsets.size());
+    std::vector<uint32_t> queue;
+    this->_accepting.assign(subsets.size(), 0);
+    this->_live.assign(subsets.size(), 0);
+    for (std::size_t current = 0; current < subsets.size(); current++)
+    {
+        this->_accepting[current] = std::binary_search(subsets[current].begin(), subsets[current].end(), fragment.second) ? 1 : 0;
+        if (this->_accepting[current])
+        {
+            this->_live[current] = 1;
+            queue.push_back((uint32_t)current);
+        }
+        for (std::size_t byte = 0; byte < 256; byte++)
+        {
+            uint32_t next = this->_transitions[current * 256 + byte];
+            if (reverse[next].empty() || reverse[next].back() != current) reverse[next].push_back((uint32_t)current);
+        }
+    }
+    for (std::size_t i = 0; i < queue.size(); i++)
+    {
+        for (uint32_t previous : reverse[queue[i]])
+        {
+            if (this->_live[previous]) continue;
+            this->_live[previous] = 1;
+            queue.push_back(previous);
+        }
+    }
+}
+
+inline trie::key_pattern
+trie::key_pattern::glob(std::string_view pattern, std::size_t max_states)
+{
+    key_pattern result;
+    syntax_ptr root = parser(pattern).parse_glob();
+    result.compile(*root, max_states);
+    return result;
+}
+
+inline trie::key_pattern
+trie::key_pattern::regex(std::string_view pattern, std::size_t max_states)
+{
+    key_pattern result;
+    syntax_ptr root = parser(pattern).parse_alternation(true);
+    result.compile(*root, max_states);
+    return result;
+}
+
+inline bool
+trie::key_pattern::matches(std::string_view bytes) const
+{
+    uint32_t state = this->start();
+    for (char current : bytes)
+    {
+        state = this->next(state, (uint8_t)current);
+        if (!this->live(state)) return false;
+    }
+    return this->accepting(state);
+}
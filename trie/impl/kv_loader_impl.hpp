@@ -0,0 +1,244 @@
+/**
+* @file     trie/impl/kv_loader_impl.hpp
+* @brief    include file for the implementations for the streaming key/value loader
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TRIE_KV_LOADER_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRIE_KV_LOADER_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#include "../kv_loader.hpp"
+
+inline
+trie::mapped_file::mapped_file(const std::string& filename)
+{
+#ifdef TRIE_KV_LOADER_MMAP
+    // only regular files can be mapped, pipes and files like the ones in /proc report a size of 0 and are read in blocks.
+    // They are checked by name, a pipe must not be opened twice
+    struct stat status;
+    if (stat(filename.c_str(), &status) == 0 && S_ISREG(status.st_mode))
+    {
+        int descriptor = open(filename.c_str(), O_RDONLY);
+        if (descriptor < 0) throw std::runtime_error("Error opening file " + filename);
+        if (fstat(descriptor, &status) != 0)
+        {
+            close(descriptor);
+            throw std::runtime_error("Error reading file " + filename);
+        }
+        this->_size = (std::size_t)status.st_size;
+        if (this->_size > 0)
+        {
+            void* address = mmap(nullptr, this->_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (address != MAP_FAILED)
+            {
+                madvise(address, this->_size, MADV_SEQUENTIAL); // the file is parsed front to back once, let the kernel read ahead
+                this->_data = (const char*)address;
+                this->_mapped = true;
+            }
+        }
+        close(descriptor);
+        if (this->_mapped || this->_size == 0) return;
+    }
+#endif
+    // the file could not be mapped (or mapping is not supported), read it in large blocks instead
+    std::ifstream input(filename, std::ios::binary);
+    char block[1 << 16];
+    if (!input) throw std::runtime_error("Error opening file " + filename);
+    this->_buffer.clear();
+    while (input.read(block, sizeof(block)) || input.gcount() > 0)
+    {
+        this->_buffer.insert(this->_buffer.end(), block, block + input.gcount());
+    }
+    this->_data = this->_buffer.data();
+    this->_size = this->_buffer.size();
+}
+
+inline
+trie::mapped_file::~mapped_file()
+{
+#ifdef TRIE_KV_LOADER_MMAP
+    if (this->_mapped) munmap((void*)this->_data, this->_size);
+#endif
+}
+
+inline const char*
+trie::kv_parser::find_special(const char* begin, const char* end)
+{
+#ifdef TRIE_KV_LOADER_SSE2
+    const __m128i quote = _mm_set1_epi8('\"'), newline = _mm_set1_epi8('\n');
+    while (end - begin >= 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)begin);
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, newline)));
+        if (mask != 0)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, (unsigned long)mask);
+            return begin + index;
+#else
+            return begin + __builtin_ctz((unsigned)mask);
+#endif
+        }
+        begin += 16;
+    }
+#endif
+    // the remaining characters (or all of them without SSE2)
+    for (; begin < end; begin++)
+    {
+        if (*begin == '\"' || *begin == '\n') return begin;
+    }
+    return end;
+}
+
+inline bool
+trie::kv_parser::next(std::string_view& key, std::string_view& value)
+{
+    const char* quotes[4];
+    const char* helper;
+    std::size_t found = 0;
+    while (this->_position < this->_end)
+    {
+        helper = find_special(this->_position, this->_end);
+        if (helper == this->_end) break;
+        this->_position = helper + 1;
+        if (*helper == '\n')
+        {
+            found = 0; // the line ended before the value was complete, start over with the next line
+            continue;
+        }
+        quotes[found++] = helper;
+        if (found == 4)
+        {
+            key = std::string_view(quotes[0] + 1, (std::size_t)(quotes[1] - quotes[0] - 1));
+            value = std::string_view(quotes[2] + 1, (std::size_t)(quotes[3] - quotes[2] - 1));
+            // ignore everything else in this line
+            helper = (const char*)memchr(this->_position, '\n', (std::size_t)(this->_end - this->_position));
+            this->_position = (helper == nullptr) ? this->_end : helper + 1;
+            return true;
+        }
+    }
+    this->_position = this->_end;
+    return false;
+}
+
+template<std::size_t children_count>
+std::size_t
+trie::load_kv_file(const std::string& filename, trie::basic_trie<children_count, std::string>& output, bool pipelined, std::size_t batch_size)
+{
+    using batch_t = std::vector<std::pair<trie::basic_key<children_count>, std::shared_ptr<std::string> > >;
+    static constexpr std::size_t max_queued = 4; // the parser may run this many batches ahead of the inserter
+    trie::mapped_file file(filename);
+    trie::kv_parser parser(file.contents());
+    std::size_t pair_count = 0;
+    if (batch_size == 0) batch_size = 1;
+
+    // only the parsing thread calls this function, the pair counter is read after it has finished
+    auto parse_batch = [&parser, &pair_count, batch_size](batch_t& batch)
+    {
+        std::string_view key, value;
+        batch.clear();
+        while (batch.size() < batch_size && parser.next(key, value))
+        {
+            batch.emplace_back(trie::basic_key<children_count>(key.data(), key.size()), std::make_shared<std::string>(value));
+        }
+        pair_count += batch.size();
+        return !batch.empty();
+    };
+
+    if (!pipelined)
+    {
+        batch_t batch;
+        while (parse_batch(batch)) output.insert_batch(batch);
+        return pair_count;
+    }
+
+    std::mutex queue_mutex;
+    std::condition_variable queue_changed;
+    std::deque<batch_t> queue;
+    std::exception_ptr parser_error;
+    bool parser_done = false, inserter_stopped = false;
+    std::thread parser_thread([&]()
+        {
+            try
+            {
+                batch_t batch;
+                while (parse_batch(batch))
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex);
+                    queue_changed.wait(lock, [&]() { return queue.size() < max_queued || inserter_stopped; });
+                    if (inserter_stopped) break;
+                    queue.push_back(std::move(batch));
+                    queue_changed.notify_all();
+                    batch = batch_t();
+                }
+            }
+            catch (...)
+            {
+                parser_error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            parser_done = true;
+            queue_changed.notify_all();
+        });
+
+    try
+    {
+        while (true)
+        {
+            batch_t batch;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_changed.wait(lock, [&]() { return !queue.empty() || parser_done; });
+                if (queue.empty()) break;
+                batch = std::move(queue.front());
+                queue.pop_front();
+                queue_changed.notify_all();
+            }
+            output.insert_batch(batch);
+        }
+    }
+    catch (...)
+    {
+        // stop the parser before the exception leaves this function, the thread uses the local variables
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            inserter_stopped = true;
+            queue_changed.notify_all();
+        }
+        parser_thread.join();
+        throw;
+    }
+    parser_thread.join();
+    if (parser_error) std::rethrow_exception(parser_error);
+    return pair_count;
+}
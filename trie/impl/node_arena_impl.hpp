@@ -0,0 +1,141 @@
+/**
+* @file     trie/impl/node_arena_impl.hpp
+* @brief    include file for the implementations for the node arena
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include "../node_arena.hpp"
+
+inline
+trie::node_arena::node_arena(std::size_t chunk_size, page_mode mode) : _chunk_size(std::max<std::size_t>(chunk_size, 4096)), _mode(mode)
+{
+}
+
+inline
+trie::node_arena::~node_arena()
+{
+    for (const chunk& current : this->_chunks) release_chunk(current);
+}
+
+inline typename trie::node_arena::chunk
+trie::node_arena::allocate_chunk(std::size_t bytes)
+{
+#ifdef __linux__
+    if (this->_mode != page_mode::normal)
+    {
+        std::size_t length = (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+        void* address;
+#ifdef MAP_HUGETLB
+        if (this->_mode == page_mode::explicit_huge)
+        {
+            address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (address != MAP_FAILED) return chunk{ static_cast<char*>(address), length, page_mode::explicit_huge, true };
+        }
+#endif
+        // reserve one huge page more than needed, so the chunk can start at a huge page boundary
+        address = mmap(nullptr, length + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (address == MAP_FAILED) throw std::bad_alloc();
+        char* start = static_cast<char*>(address);
+        char* aligned = reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(start) + huge_page_size - 1) / huge_page_size * huge_page_size);
+        if (aligned != start) munmap(start, (std::size_t)(aligned - start));
+        if (aligned + length != start + length + huge_page_size) munmap(aligned + length, (std::size_t)(start + length + huge_page_size - (aligned + length)));
+        page_mode mode = page_mode::normal; // a kernel without transparent huge pages rejects the advice, the mapping is still usable
+#ifdef MADV_HUGEPAGE
+        if (madvise(aligned, length, MADV_HUGEPAGE) == 0) mode = page_mode::transparent_huge;
+#endif
+        return chunk{ aligned, length, mode, true };
+    }
+#endif
+    return chunk{ new char[bytes], bytes, page_mode::normal, false };
+}
+
+inline void
+trie::node_arena::release_chunk(const chunk& current)
+{
+#ifdef __linux__
+    if (current.mapped)
+    {
+        munmap(current.address, current.length);
+        return;
+    }
+#endif
+    delete[] current.address;
+}
+
+inline void*
+trie::node_arena::allocate(std::size_t bytes, std::size_t alignment)
+{
+    // chunks from operator new are aligned for every fundamental type and mapped chunks are page aligned, so the start of a chunk is always aligned
+    std::size_t offset = (this->_used + alignment - 1) / alignment * alignment;
+    if (this->_chunks.empty() || offset + bytes > this->_chunks.back().length)
+    {
+        this->_chunks.push_back(this->allocate_chunk(std::max(this->_chunk_size, bytes)));
+        this->_total += this->_chunks.back().length;
+        offset = 0;
+    }
+    this->_used = offset + bytes;
+    return this->_chunks.back().address + offset;
+}
+
+inline std::size_t
+trie::node_arena::backed_bytes(page_mode mode) const
+{
+    std::size_t result = 0;
+    for (const chunk& current : this->_chunks)
+    {
+        if (current.mode == mode) result += current.length;
+    }
+    return result;
+}
+
+inline std::size_t
+trie::node_arena::promoted_bytes() const
+{
+    std::size_t result = this->backed_bytes(page_mode::explicit_huge), transparent = this->backed_bytes(page_mode::transparent_huge);
+    if (transparent == 0) return result;
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line, field;
+    std::uintptr_t first = 0, last = 0;
+    bool overlaps = false;
+    std::size_t promoted = 0, kilobytes;
+    while (std::getline(smaps, line))
+    {
+        std::istringstream parser(line);
+        if (!(parser >> field)) continue;
+        std::size_t dash = field.find('-');
+        if (dash != std::string::npos && field.back() != ':')
+        {
+            // a mapping header line "start-end perms offset device inode path"
+            first = (std::uintptr_t)std::stoull(field.substr(0, dash), nullptr, 16);
+            last = (std::uintptr_t)std::stoull(field.substr(dash + 1), nullptr, 16);
+            overlaps = std::any_of(this->_chunks.begin(), this->_chunks.end(), [first, last](const chunk& current)
+                {
+                    return current.mode == page_mode::transparent_huge && reinterpret_cast<std::uintptr_t>(current.address) < last
+                        && reinterpret_cast<std::uintptr_t>(current.address) + current.length > first;
+                });
+        }
+        else if (overlaps && field == "AnonHugePages:" && (parser >> kilobytes))
+        {
+            promoted += kilobytes * 1024;
+        }
+    }
+    return result + std::min(promoted, transparent);
+}
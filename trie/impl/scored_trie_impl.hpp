@@ -0,0 +1,301 @@
+/**
+* @file     trie/impl/scored_trie_impl.hpp
+* @brief    include file for the implementations for the trie class with scored keys
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <queue>
+#include <stdexcept>
+
+#include "../scored_trie.hpp"
+
+template<std::size_t children_count, typename value_t, typename score_t>
+score_t
+trie::scored_trie<children_count, value_t, score_t>::node::subtree_best() const
+{
+    score_t result = this->has_data ? this->score : std::numeric_limits<score_t>::lowest();
+    for (const std::shared_ptr<node>& current : this->children)
+    {
+        if (current != nullptr && result < current->best) result = current->best;
+    }
+    return result;
+}
+
+template<std::size_t children_count, typename value_t, typename score_t>
+std::vector<typename trie::scored_trie<children_count, value_t, score_t>::node*>
+trie::scored_trie<children_count, value_t, score_t>::find_path(const key_t& key) const
+{
+    std::vector<node*> path(1, this->_root.get());
+    for (std::size_t i = 0; ; i++)
+    {
+        node* helper = path.back();
+        if (helper->tail != nullptr)
+        {
+            // the rest of the key has to be the tail
+            if (key.size() - i != helper->tail->size()) return std::vector<node*>();
+            for (std::size_t j = 0; j < helper->tail->size(); j++)
+            {
+                if (key.get_element(i + j) != helper->tail->get_element(j)) return std::vector<node*>();
+            }
+            return path;
+        }
+        if (i == key.size()) break;
+        helper = helper->child(key.get_element(i)).get();
+        if (helper == nullptr) return std::vector<node*>();
+        path.push_back(helper);
+    }
+    if (!path.back()->has_data) return std::vector<node*>();
+    return path;
+}
+
+template<std::size_t children_count, typename value_t, typename score_t>
+typename trie::scored_trie<children_count, value_t, score_t>::node*
+trie::scored_trie<children_count, value_t, score_t>::find(const key_t& key) const
+{
+    std::vector<node*> path = this->find_path(key);
+    return path.empty() ? nullptr : path.back();
+}
+
+template<std::size_t children_count, typename value_t, typename score_t>
+void
+trie::scored_trie<children_count, value_t, score_t>::push_down(node* current)
+{
+    std::shared_ptr<node> child = std::make_shared<node>();
+    const key_t& tail = *current->tail;
+    if (tail.size() > 1)
+    {
+        child->tail = std::make_shared<key_t>();
+        for (std::size_t i = 1; i < tail.size(); i++) child->tail->push_back(tail.get_element(i));
+    }
+    child->data = std::move(current->data);
+    child->has_data = current->has_data;
+    child->score = current->score;
+    child->best = current->best; // the subtree still holds the same single key
+    current->children[tail.get_element(0)] = std::move(child);
+    current->has_data = false;
+    current->tail = nullptr;
+}
+
+template<std::size_t children_count, typename value_t, typename score_t>
+void
+trie::scored_trie<children_count, value_t, score_t>::refresh_path(const std::vector<node*>& path)
+{
+    for (std::size_t i = path.size(); i > 0; i--)
+    {
+        score_t best = path[i - 1]->subtree_best();
+        if (!(best < path[i - 1]->best) && !(path[i - 1]->best < best) && i != path.size()) return; // the nodes above are not affected
+        path[i - 1]->best = best;
+    }
+}
+
+template<std::size_t children_count, typename value_t, typename score_t>
+bool
+trie::scored_trie<children_count, value_t, score_t>::contains(const key_t& key) const
+{
+    return this->find(key) != nullptr;
+}
+
+template<std::size_t children_count, typename value_t, typename score_t>
+std::shared_ptr<value_t>&
+trie::scored_trie<children_count, value_t, score_t>::at(const key_t& key)
+{
+    node* helper = this->find(key);
+    if (helper == nullptr) throw std::out_of_range("Key not found");
+    return helper->data;
+}
+
+template<std::size_t children_count, typename value_t, typename score_t>
+score_t
+trie::scored_trie<children_count, value_t, score_t>::score(const key_t& key) const
+{
+    node* helper = this->find(key);
+    if (helper == nullptr) throw std::out_of_range("Key not found");
+    return helper->score;
+}
+
+template<std::size_t children_count, typename value_t, typename score_t>
+bool
+trie::scored_trie<children_count, value_t, score_t>::insert(const key_t& key, std::shared_ptr<value_t> value, score_t score)
+{
+    node* helper = this->_root.get();
+    if (this->contains(key)) return false;
+    // a new key can only raise the best scores along its path
+    for (std::size_t i = 0; ; i++)
+    {
+        if (helper->tail != nullptr) push_down(helper); // the tail's key and the new key share this node
+        if (helper->best < score) helper->best = score;
+        if (i == key.size()) break;
+        std::shared_ptr<node>& next = helper->child(key.get_element(i));
+        if (next == nullptr)
+        {
+            // the rest of the key is stored as the tail of a new node
+            next = std::make_shared<node>();
+            if (i + 1 < key.size())
+            {
+                next->tail = std::make_shared<key_t>();
+                for (std::size_t j = i + 1; j < key.size(); j++) next->tail->push_back(key.get_element(j));
+            }
+            next->best = score;
+            helper = next.get();
+            break;
+        }
+        helper = next.get();
+    }
+    helper->data = std::move(value);
+    helper->score = score;
+    helper->has_data = true;
+    ++this->_size;
+    return true;
+}
+
+template<std::size_t children_count, typename value_t, typename score_t>
+bool
+trie::scored_trie<children_count, value_t, score_t>::update_score(const key_t& key, score_t score)
+{
+    std::vector<node*> path = this->find_path(key);
+    if (path.empty()) return false;
+    path.back()->score = score;
+    refresh_path(path);
+    return true;
+}
+
+template<std::size_t children_count, typename value_t, typename score_t>
+bool
+trie::scored_trie<children_count, value_t, score_t>::erase(const key_t& key)
+{
+    std::vector<node*> path = this->find_path(key);
+    std::size_t depth;
+    if (path.empty()) return false;
+    path.back()->data = nullptr;
+    path.back()->has_data = false;
+    path.back()->tail = nullptr;
+    --this->_size;
+    // remove the nodes that hold neither data nor children any more, the root node is kept
+    for (depth = path.size() - 1; depth > 0; depth--)
+    {
+        node* current = path[depth];
+        if (current->has_data) break;
+        bool has_children = false;
+        for (const std::shared_ptr<node>& child : current->children) has_children = has_children || child != nullptr;
+        if (has_children) break;
+        path[depth - 1]->child(key.get_element(depth - 1)) = nullptr; // the node is reached by the key element depth - 1
+    }
+    path.resize(depth + 1);
+    refresh_path(path);
+    return true;
+}
+
+template<std::size_t children_count, typename value_t, typename score_t>
+void
+trie::scored_trie<children_count, value_t, score_t>::clear()
+{
+    this->_root = std::make_shared<node>();
+    this->_size = 0;
+}
+
+template<std::size_t children_count, typename value_t, typename score_t>
+std::vector<typename trie::scored_trie<children_count, value_t, score_t>::completion>
+trie::scored_trie<children_count, value_t, score_t>::complete(const key_t& prefix, std::size_t k) const
+{
+    // the nodes reached by complete() form a tree below the prefix, every node is an entry with the index of its parent's entry.
+    // Candidates refer to their node's entry, so they do not copy the key.
+    struct entry
+    {
+        std::size_t parent;
+        uint8_t element; // key element leading from the parent to the node
+        std::size_t depth; // number of key elements below the prefix
+    };
+    // a candidate is either a whole subtree ranked by its best score or the key of a single node ranked by its own score
+    struct candidate
+    {
+        score_t score;
+        node* current;
+        bool subtree;
+        std::size_t path; // index of the node's entry
+    };
+    std::vector<entry> entries;
+    // better scores first, for the same score the smaller key first. A node's own key is smaller than all keys of its subtree.
+    // A node with a tail has no children, so two candidates always differ before the tail and the tails never have to be compared.
+    auto worse = [&entries](const candidate& a, const candidate& b)
+    {
+        if (a.score < b.score) return true;
+        if (b.score < a.score) return false;
+        std::size_t left = a.path, right = b.path;
+        bool left_shorter = false, right_shorter = false;
+        // lift the deeper entry to the depth of the other one, a key is smaller than all keys it is a prefix of
+        while (entries[left].depth > entries[right].depth) { left = entries[left].parent; right_shorter = true; }
+        while (entries[right].depth > entries[left].depth) { right = entries[right].parent; left_shorter = true; }
+        if (left == right)
+        {
+            if (left_shorter || right_shorter) return right_shorter;
+            return a.subtree && !b.subtree;
+        }
+        while (entries[left].parent != entries[right].parent)
+        {
+            left = entries[left].parent;
+            right = entries[right].parent;
+        }
+        return entries[left].element > entries[right].element;
+    };
+    std::priority_queue<candidate, std::vector<candidate>, decltype(worse)> queue(worse);
+    std::vector<completion> result;
+    node* start = this->_root.get();
+    key_t path;
+    if (k == 0) return result;
+    // find the node of the prefix, a prefix ending inside of a tail starts at the tail's node
+    for (std::size_t i = 0; i < prefix.size(); i++)
+    {
+        if (start->tail != nullptr)
+        {
+            if (prefix.size() - i > start->tail->size()) return result;
+            for (std::size_t j = i; j < prefix.size(); j++)
+            {
+                if (prefix.get_element(j) != start->tail->get_element(j - i)) return result;
+            }
+            break;
+        }
+        start = start->children[prefix.get_element(i)].get();
+        if (start == nullptr) return result;
+        path.push_back(prefix.get_element(i));
+    }
+
+    entries.push_back(entry{ 0, 0, 0 });
+    queue.push(candidate{ start->best, start, true, 0 });
+    std::vector<uint8_t> elements;
+    while (!queue.empty() && result.size() < k)
+    {
+        candidate top = queue.top();
+        queue.pop();
+        if (!top.subtree)
+        {
+            // rebuild the key from the entries only for the keys that are returned
+            elements.clear();
+            for (std::size_t current = top.path; current != 0; current = entries[current].parent) elements.push_back(entries[current].element);
+            key_t key = path;
+            for (auto element = elements.rbegin(); element != elements.rend(); element++) key.push_back(*element);
+            if (top.current->tail != nullptr)
+            {
+                for (std::size_t i = 0; i < top.current->tail->size(); i++) key.push_back(top.current->tail->get_element(i));
+            }
+            result.push_back(completion{ std::move(key), top.score, top.current->data });
+            continue;
+        }
+        // expand the subtree into the node's own key and its child subtrees
+        if (top.current->has_data) queue.push(candidate{ top.current->score, top.current, false, top.path });
+        for (std::size_t i = 0; i < children_count; i++)
+        {
+            node* child = top.current->children[i].get();
+            if (child == nullptr) continue;
+            entries.push_back(entry{ top.path, (uint8_t)i, entries[top.path].depth + 1 });
+            queue.push(candidate{ child->best, child, true, entries.size() - 1 });
+        }
+    }
+    return result;
+}
@@ -0,0 +1,204 @@
+/**
+* @file     trie/impl/succinct_trie_impl.hpp
+* @brief    include file for the implementations for the succinct trie class
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <deque>
+#include <stdexcept>
+
+#include "../succinct_trie.hpp"
+
+template<std::size_t children_count, typename value_t>
+std::pair<std::size_t, std::size_t>
+trie::succinct_trie<children_count, value_t>::edges(std::size_t node) const
+{
+    // the degree of node 'n' starts after the n-th cleared bit and ends at the (n+1)-th cleared bit
+    // exactly 'n' cleared bits are in front of the degree, so the number of set bits (= edges) in front of it is 'start - n'
+    std::size_t start = (node == 0) ? 0 : this->_louds.select0(node - 1) + 1;
+    std::size_t end = this->_louds.select0(node);
+    return std::make_pair(start - node, end - node);
+}
+
+template<std::size_t children_count, typename value_t>
+std::size_t
+trie::succinct_trie<children_count, value_t>::child(std::size_t node, uint8_t key_element) const
+{
+    std::pair<std::size_t, std::size_t> range = this->edges(node);
+    std::size_t low = range.first, high = range.second, mid;
+    // the labels of one node are sorted, so a binary search can be used to find the child
+    while (low < high)
+    {
+        mid = (low + high) / 2;
+        if (this->_labels.get_element(mid) < key_element) low = mid + 1;
+        else high = mid;
+    }
+    if (low < range.second && this->_labels.get_element(low) == key_element) return low + 1; // edge i leads to node i+1
+    return npos;
+}
+
+template<std::size_t children_count, typename value_t>
+std::size_t
+trie::succinct_trie<children_count, value_t>::find_node(const key_t& key) const
+{
+    std::size_t node = 0;
+    for (std::size_t i = 0; i < key.size() && node != npos; i++)
+    {
+        node = this->child(node, key.get_element(i));
+    }
+    return node;
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::succinct_trie<children_count, value_t>::build(trie::basic_trie<children_count, value_t>& source)
+{
+    struct range
+    {
+        std::size_t first, last, depth;
+    };
+    // collect all key-value pairs, the value iterator returns them ordered by key
+    std::vector<std::pair<key_t, std::shared_ptr<value_t> > > pairs;
+    for (auto iter = source.begin(); iter != source.end(); iter++)
+    {
+        pairs.push_back(std::make_pair(iter.get_key(), iter.get_data()));
+    }
+
+    this->_louds.clear();
+    this->_has_value.clear();
+    this->_labels.clear();
+    this->_values.clear();
+
+    // every range of pairs sharing the first 'depth' key elements is one node, processing them in a queue numbers the nodes in breadth-first order
+    std::deque<range> queue;
+    queue.push_back(range{ 0, pairs.size(), 0 });
+    while (!queue.empty())
+    {
+        range current = queue.front();
+        std::size_t index = current.first, group;
+        uint8_t element;
+        queue.pop_front();
+
+        // a key ending at this node is always the first one of the range because of the key order
+        if (index < current.last && pairs.at(index).first.size() == current.depth)
+        {
+            this->_has_value.push_back(true);
+            this->_values.push_back(pairs.at(index).second);
+            ++index;
+        }
+        else
+        {
+            this->_has_value.push_back(false);
+        }
+        // every distinct key element at this depth is one child
+        while (index < current.last)
+        {
+            element = pairs.at(index).first.get_element(current.depth);
+            group = index;
+            while (index < current.last && pairs.at(index).first.get_element(current.depth) == element) ++index;
+            this->_labels.push_back(element);
+            this->_louds.push_back(true);
+            queue.push_back(range{ group, index, current.depth + 1 });
+        }
+        this->_louds.push_back(false);
+    }
+    this->_louds.build_index();
+    this->_has_value.build_index();
+    this->_values.shrink_to_fit();
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::succinct_trie<children_count, value_t>::clear()
+{
+    // the empty trie still has a root node without children
+    this->_louds.clear();
+    this->_has_value.clear();
+    this->_labels.clear();
+    this->_values.clear();
+    this->_louds.push_back(false);
+    this->_has_value.push_back(false);
+    this->_louds.build_index();
+    this->_has_value.build_index();
+}
+
+template<std::size_t children_count, typename value_t>
+bool
+trie::succinct_trie<children_count, value_t>::has_node(const key_t& key) const
+{
+    return this->find_node(key) != npos;
+}
+
+template<std::size_t children_count, typename value_t>
+const std::shared_ptr<value_t>&
+trie::succinct_trie<children_count, value_t>::at(const key_t& key) const
+{
+    static const std::shared_ptr<value_t> null_value;
+    std::size_t node = this->find_node(key);
+    if (node == npos) throw std::out_of_range("Trie does not have the requested child");
+    if (!this->_has_value.get(node)) return null_value;
+    return this->_values.at(this->_has_value.rank1(node));
+}
+
+template<std::size_t children_count, typename value_t>
+std::size_t
+trie::succinct_trie<children_count, value_t>::memory_usage() const
+{
+    return this->_louds.memory_usage() + this->_has_value.memory_usage() + this->_labels.export_size()
+        + this->_values.capacity() * sizeof(std::shared_ptr<value_t>);
+}
+
+template<std::size_t children_count, typename value_t>
+trie::succinct_trie<children_count, value_t>::value_iterator::value_iterator(const succinct_trie* source, bool at_begin) : _trie(source)
+{
+    if (!at_begin) return;
+    this->push_node(0);
+    this->cur_node = 0;
+    if (!this->_trie->_has_value.get(0)) this->next_value();
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::succinct_trie<children_count, value_t>::value_iterator::push_node(std::size_t node)
+{
+    std::pair<std::size_t, std::size_t> range = this->_trie->edges(node);
+    this->_stack.push_back(frame{ node, range.first, range.second });
+}
+
+template<std::size_t children_count, typename value_t>
+void
+trie::succinct_trie<children_count, value_t>::value_iterator::next_value()
+{
+    std::size_t edge;
+    while (!this->_stack.empty())
+    {
+        frame& top = this->_stack.back();
+        if (top.next_edge < top.last_edge)
+        {
+            // descend into the next child, stop if it holds a value
+            edge = top.next_edge++;
+            this->cur_key.push_back(this->_trie->_labels.get_element(edge));
+            this->push_node(edge + 1);
+            if (this->_trie->_has_value.get(edge + 1))
+            {
+                this->cur_node = edge + 1;
+                return;
+            }
+        }
+        else
+        {
+            // all children visited, go back to the parent
+            this->_stack.pop_back();
+            if (!this->_stack.empty()) this->cur_key.pop_back();
+        }
+    }
+    this->cur_node = npos;
+    this->cur_key.clear();
+}
@@ -0,0 +1,160 @@
+/**
+* @file     trie/impl/work_stealing_pool_impl.hpp
+* @brief    include file for the implementations for the work-stealing thread pool
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <exception>
+
+#include "../work_stealing_pool.hpp"
+
+inline
+trie::work_stealing_pool::work_stealing_pool(std::size_t thread_count)
+{
+    if (thread_count == 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t i = 0; i < thread_count; i++)
+    {
+        this->_queues.push_back(std::make_unique<task_queue>());
+    }
+    try
+    {
+        for (std::size_t i = 0; i < thread_count; i++)
+        {
+            this->_threads.emplace_back(&work_stealing_pool::run_worker, this, i);
+        }
+    }
+    catch (...)
+    {
+        // stop the threads that could be started before the exception leaves the constructor
+        this->stop();
+        throw;
+    }
+}
+
+inline
+trie::work_stealing_pool::~work_stealing_pool()
+{
+    this->stop();
+}
+
+inline void
+trie::work_stealing_pool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_stopping = true;
+    }
+    this->_changed.notify_all();
+    for (std::thread& current : this->_threads)
+    {
+        if (current.joinable()) current.join();
+    }
+}
+
+inline bool
+trie::work_stealing_pool::take_task(std::size_t worker, std::function<void(std::size_t)>& task)
+{
+    for (std::size_t offset = 0; offset < this->_queues.size(); offset++)
+    {
+        task_queue& queue = *this->_queues[(worker + offset) % this->_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        if (offset == 0)
+        {
+            // the own queue is used like a stack, the most recently queued task is still warm in the cache
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            // steal the oldest task of another worker
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        --this->_queued;
+        return true;
+    }
+    return false;
+}
+
+inline void
+trie::work_stealing_pool::run_worker(std::size_t worker)
+{
+    std::function<void(std::size_t)> task;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(this->_mutex);
+            this->_changed.wait(lock, [this]() { return this->_queued > 0 || this->_stopping; });
+            if (this->_stopping) return;
+        }
+        while (this->take_task(worker, task))
+        {
+            task(worker);
+            task = nullptr;
+        }
+    }
+}
+
+inline void
+trie::work_stealing_pool::run(std::size_t count, const std::function<void(std::size_t index, std::size_t worker)>& task)
+{
+    struct batch_state
+    {
+        std::mutex mutex;
+        std::condition_variable done;
+        std::size_t remaining;
+        std::exception_ptr error;
+        std::atomic<bool> failed{ false };
+    } batch;
+    std::size_t first = this->_next_queue.fetch_add(1) % this->_queues.size();
+    if (count == 0) return;
+    batch.remaining = count;
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        std::function<void(std::size_t)> wrapper = [&batch, &task, i](std::size_t worker)
+        {
+            try
+            {
+                if (!batch.failed) task(i, worker);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(batch.mutex);
+                if (!batch.failed.exchange(true)) batch.error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(batch.mutex);
+            if (--batch.remaining == 0) batch.done.notify_all();
+        };
+        // the tasks are dealt to the queues in blocks, so neighbouring subtrees start on the same worker
+        task_queue& queue = *this->_queues[(first + i * this->_queues.size() / count) % this->_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(wrapper));
+        ++this->_queued; // counted under the queue's lock, so a worker taking the task can not count it down before
+    }
+    {
+        // a worker that saw no queued tasks holds the mutex until it waits, so it can not miss the notification
+        std::lock_guard<std::mutex> lock(this->_mutex);
+    }
+    this->_changed.notify_all();
+
+    std::unique_lock<std::mutex> lock(batch.mutex);
+    batch.done.wait(lock, [&batch]() { return batch.remaining == 0; });
+    if (batch.error) std::rethrow_exception(batch.error);
+}
+
+inline trie::work_stealing_pool&
+trie::work_stealing_pool::shared()
+{
+    static work_stealing_pool instance;
+    return instance;
+}
@@ -0,0 +1,158 @@
+/**
+* @file     trie/instrumentation.hpp
+* @brief    include file for the opt-in hot path counters of the trie classes
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * The counters are only compiled in if TRIE_ENABLE_INSTRUMENTATION is defined before the trie headers are included
+ * (e.g. with -DTRIE_ENABLE_INSTRUMENTATION). Otherwise all TRIE_INSTRUMENT_* macros expand to nothing
+ * and trie::instrumentation::snapshot() always returns zeros.
+ */
+
+namespace trie
+{
+    namespace instrumentation
+    {
+        /**
+         * @brief operations that are timed, every public basic_trie method maps to one of them
+         */
+        enum class operation : std::size_t
+        {
+            lookup, // at, has_node
+            insert, // insert, operator[]
+            erase,
+            merge,
+            subtrie,
+            clone,
+            operation_count
+        };
+
+        /**
+         * @brief copy of all counters at one point in time. All counters are process wide and summed over all tries and threads.
+         */
+        struct counters
+        {
+            uint64_t lookup_nodes_visited{ 0 }; // nodes visited while searching a node, this includes the searches of merges and iterators
+            uint64_t insert_nodes_visited{ 0 }; // nodes visited while searching or adding a node for an insert
+            uint64_t erase_nodes_visited{ 0 }; // nodes visited while searching a node to unlink
+            uint64_t node_allocations{ 0 };
+            uint64_t node_frees{ 0 };
+            uint64_t iterator_rewalks{ 0 }; // iterator steps back to a parent node, each one searches the parent from the root node
+            uint64_t merge_splices{ 0 }; // nodes moved from the source trie by a merge
+            uint64_t calls[(std::size_t)operation::operation_count]{};
+            uint64_t nanoseconds[(std::size_t)operation::operation_count]{}; // total time spent per operation
+
+            /**
+             * @brief average time of one call of an operation in nanoseconds
+             */
+            double average_ns(operation op) const { return calls[(std::size_t)op] == 0 ? 0.0 : (double)nanoseconds[(std::size_t)op] / (double)calls[(std::size_t)op]; }
+        };
+
+#ifdef TRIE_ENABLE_INSTRUMENTATION
+        static constexpr bool enabled = true;
+
+        /**
+         * @brief the live counters, updated with relaxed atomic increments so the tries can be used from several threads
+         */
+        struct live_counters
+        {
+            std::atomic<uint64_t> lookup_nodes_visited{ 0 }, insert_nodes_visited{ 0 }, erase_nodes_visited{ 0 };
+            std::atomic<uint64_t> node_allocations{ 0 }, node_frees{ 0 }, iterator_rewalks{ 0 }, merge_splices{ 0 };
+            std::atomic<uint64_t> calls[(std::size_t)operation::operation_count]{};
+            std::atomic<uint64_t> nanoseconds[(std::size_t)operation::operation_count]{};
+        };
+
+        inline live_counters& global()
+        {
+            static live_counters instance;
+            return instance;
+        }
+
+        /**
+         * @brief measures the lifetime of one public trie method call
+         */
+        class scoped_timer
+        {
+        protected:
+            operation _operation;
+            std::chrono::steady_clock::time_point _start;
+        public:
+            scoped_timer(operation op) : _operation(op), _start(std::chrono::steady_clock::now()) {}
+            ~scoped_timer()
+            {
+                uint64_t elapsed = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->_start).count();
+                global().calls[(std::size_t)this->_operation].fetch_add(1, std::memory_order_relaxed);
+                global().nanoseconds[(std::size_t)this->_operation].fetch_add(elapsed, std::memory_order_relaxed);
+            }
+            scoped_timer(const scoped_timer&) = delete;
+            scoped_timer& operator=(const scoped_timer&) = delete;
+        };
+
+        /**
+         * @brief read all counters, the counters are read one by one, so concurrent updates might only be partially included
+         */
+        inline counters snapshot()
+        {
+            counters result;
+            live_counters& source = global();
+            result.lookup_nodes_visited = source.lookup_nodes_visited.load(std::memory_order_relaxed);
+            result.insert_nodes_visited = source.insert_nodes_visited.load(std::memory_order_relaxed);
+            result.erase_nodes_visited = source.erase_nodes_visited.load(std::memory_order_relaxed);
+            result.node_allocations = source.node_allocations.load(std::memory_order_relaxed);
+            result.node_frees = source.node_frees.load(std::memory_order_relaxed);
+            result.iterator_rewalks = source.iterator_rewalks.load(std::memory_order_relaxed);
+            result.merge_splices = source.merge_splices.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i < (std::size_t)operation::operation_count; i++)
+            {
+                result.calls[i] = source.calls[i].load(std::memory_order_relaxed);
+                result.nanoseconds[i] = source.nanoseconds[i].load(std::memory_order_relaxed);
+            }
+            return result;
+        }
+
+        /**
+         * @brief set all counters to zero
+         */
+        inline void reset()
+        {
+            live_counters& target = global();
+            target.lookup_nodes_visited = 0;
+            target.insert_nodes_visited = 0;
+            target.erase_nodes_visited = 0;
+            target.node_allocations = 0;
+            target.node_frees = 0;
+            target.iterator_rewalks = 0;
+            target.merge_splices = 0;
+            for (std::size_t i = 0; i < (std::size_t)operation::operation_count; i++)
+            {
+                target.calls[i] = 0;
+                target.nanoseconds[i] = 0;
+            }
+        }
+
+#define TRIE_INSTRUMENT_COUNT(counter) ::trie::instrumentation::global().counter.fetch_add(1, std::memory_order_relaxed)
+#define TRIE_INSTRUMENT_TIME(op) ::trie::instrumentation::scoped_timer _trie_instrumentation_timer(::trie::instrumentation::operation::op)
+#else
+        static constexpr bool enabled = false;
+
+        inline counters snapshot() { return counters(); }
+        inline void reset() {}
+
+#define TRIE_INSTRUMENT_COUNT(counter) ((void)0)
+#define TRIE_INSTRUMENT_TIME(op) ((void)0)
+#endif
+    } // namespace instrumentation
+} // namespace trie
@@ -0,0 +1,207 @@
+/**
+* @file     trie/integer_trie.hpp
+* @brief    include file for the trie class with fixed-width integer keys
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+namespace trie
+{
+    /**
+     * @brief trie mapping fixed-width integers (e.g. uint32_t or uint64_t ids) to pointers.
+     *  Instead of a basic_key the key elements are taken directly from the integer, the number of levels is a compile-time constant
+     *  and every level has its own node type, so every operation is a fully unrolled descent without any heap allocated key.
+     *  The integer is split into key elements starting at the most significant bits (big-endian) and the sign bit of signed
+     *  integers is flipped, so iterating the trie visits the keys in numerical order.
+     *  All values are stored in the last level, the nodes above it only hold children.
+     *
+     * @tparam children_count number of possible states for one key element. MUST be one of: 2, 4, 16, 256
+     * @tparam integer_t the integral key type
+     * @tparam value_t the datatype stored by the std::shared_ptr's
+     */
+    template<std::size_t children_count, typename integer_t, typename value_t>
+    class integer_trie
+    {
+    public:
+        static_assert(std::is_integral<integer_t>::value && !std::is_same<integer_t, bool>::value, "integer_trie keys have to be integers");
+        static_assert(children_count == 2 || children_count == 4 || children_count == 16 || children_count == 256, "unsupported children count");
+
+        using key_t = integer_t;
+        using encoded_t = typename std::make_unsigned<integer_t>::type;
+
+        static constexpr std::size_t bits_per_element = (children_count == 2) ? 1 : (children_count == 4) ? 2 : (children_count == 16) ? 4 : 8;
+        static constexpr std::size_t key_bits = std::numeric_limits<encoded_t>::digits;
+        /**
+         * @brief number of key elements of every key, which is also the number of node levels
+         */
+        static constexpr std::size_t depth = key_bits / bits_per_element;
+
+        /**
+         * @brief convert a key into the unsigned integer whose order is the numerical order of the keys
+         */
+        static constexpr encoded_t encode(integer_t key);
+        /**
+         * @brief the inverse of encode()
+         */
+        static constexpr integer_t decode(encoded_t encoded);
+        /**
+         * @brief get the key element of an encoded key for the node level 'level'
+         */
+        template<std::size_t level>
+        static constexpr std::size_t get_element(encoded_t encoded) { return (std::size_t)(encoded >> (key_bits - (level + 1) * bits_per_element)) & (children_count - 1); }
+
+    protected:
+        template<std::size_t level, bool is_last = (level + 1 == depth)>
+        struct node;
+
+        template<std::size_t level>
+        struct node<level, false>
+        {
+            std::array<std::shared_ptr<node<level + 1> >, children_count> children;
+            std::size_t count{ 0 }; // number of children that are not a nullptr
+        };
+
+        template<std::size_t level>
+        struct node<level, true>
+        {
+            std::array<std::shared_ptr<value_t>, children_count> children; // the stored values
+            std::bitset<children_count> present; // the keys stored in this node, the values can be changed to a nullptr through at() and the iterators
+            std::size_t count{ 0 }; // number of stored keys
+        };
+
+        std::shared_ptr<node<0> > _root;
+        std::size_t _size;
+
+        /**
+         * @brief get a pointer to the data pointer stored at the key, nullptr if the key is not stored
+         */
+        template<std::size_t level>
+        static std::shared_ptr<value_t>* find(node<level>* current, encoded_t encoded);
+        /**
+         * @throws std::bad_alloc from std::make_shared()
+         */
+        template<std::size_t level>
+        static bool insert(node<level>* current, encoded_t encoded, std::shared_ptr<value_t>& value);
+        /**
+         * @brief remove the key from the subtree, nodes that become empty are removed from their parents
+         */
+        template<std::size_t level>
+        static bool erase(node<level>* current, encoded_t encoded);
+        /**
+         * @brief find the smallest stored key that is not smaller than 'encoded'. Only the first child on the path of 'encoded'
+         *  is bounded by it, all children to its right are searched from their smallest key.
+         *
+         * @param result the key elements of the found key are added to it
+         * @return a pointer to the data pointer of the found key, nullptr if there is no such key in the subtree
+         */
+        template<std::size_t level>
+        static std::shared_ptr<value_t>* lower_bound(node<level>* current, encoded_t encoded, bool bounded, encoded_t& result);
+
+    public:
+        integer_trie() { this->clear(); }
+        ~integer_trie() {}
+
+        integer_trie(integer_trie&& src) noexcept = default;
+        integer_trie& operator=(integer_trie&& src) noexcept = default;
+        integer_trie(const integer_trie& src) = delete; // disable copy constructing
+        integer_trie& operator=(const integer_trie& src) = delete; // disable copy assignments
+
+        /**
+         * @brief check if a value is stored at a key
+         */
+        bool contains(integer_t key) const { return find<0>(this->_root.get(), encode(key)) != nullptr; }
+        /**
+         * @brief get the pointer to the value stored at a key. The pointer can be replaced, even by a nullptr, the key stays stored until it is erased.
+         *
+         * @param key the key to the value
+         * @return reference to a std::shared_ptr of value type
+         * @throws std::out_of_range if the trie does not store the key
+         */
+        std::shared_ptr<value_t>& at(integer_t key);
+        /**
+         * @brief insert a pointer to a value into the trie
+         *
+         * @param key the key where to store the value
+         * @param value the pointer to the value that should be stored, a nullptr is not stored
+         * @return true if the value could be inserted, false if the key was already stored or the value is a nullptr
+         * @throws std::bad_alloc
+         */
+        bool insert(integer_t key, std::shared_ptr<value_t> value);
+        /**
+         * @brief remove a key from the trie
+         *
+         * @return true to indicate that the key has been removed, false if the key was not stored
+         */
+        bool erase(integer_t key);
+        /**
+         * @brief removes all keys from the trie and resets it into the valid empty state
+         */
+        void clear();
+        /**
+         * @brief returns the number of keys stored in the trie, this has a complexity of O(1)
+         */
+        std::size_t size() const { return this->_size; }
+
+        /**
+         * @brief forward iterator over all keys in numerical order. Every increment searches the successor of the current key
+         *  from the root, so the iterator stays valid while other keys are inserted or erased.
+         */
+        class value_iterator
+        {
+        protected:
+            node<0>* _root{ nullptr };
+            encoded_t _encoded{ 0 };
+            std::shared_ptr<value_t>* cur_data{ nullptr };
+
+            void next_value();
+
+        public:
+            value_iterator() {}
+            /**
+             * @brief create an iterator at the smallest stored key that is not smaller than 'encoded'
+             */
+            value_iterator(node<0>* root, encoded_t encoded);
+            ~value_iterator() {}
+
+            inline bool operator==(const value_iterator& other) const { return this->cur_data == other.cur_data; }
+            inline bool operator!=(const value_iterator& other) const { return !(*this == other); }
+
+            inline bool is_null() const { return this->cur_data == nullptr; }
+            inline operator bool() const { return !this->is_null(); }
+            inline bool operator!() const { return this->is_null(); }
+
+            /**
+             * @brief Get the key of where the iterator is currently at
+             */
+            inline integer_t get_key() const { return decode(this->_encoded); }
+            /**
+             * @brief Get the data pointer of where the iterator is currently at
+             */
+            inline std::shared_ptr<value_t>& get_data() const { return *this->cur_data; }
+
+            value_iterator& operator++() { this->next_value(); return *this; }
+            value_iterator operator++(int) { value_iterator copy = *this; this->next_value(); return copy; }
+        }; // class value_iterator
+
+        value_iterator begin() { return value_iterator(this->_root.get(), 0); }
+        value_iterator end() { return value_iterator(); }
+        /**
+         * @brief get an iterator at the smallest stored key that is not smaller than the key, end() if there is no such key
+         */
+        value_iterator lower_bound(integer_t key) { return value_iterator(this->_root.get(), encode(key)); }
+    }; // class integer_trie
+} // namespace trie
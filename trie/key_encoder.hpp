@@ -0,0 +1,131 @@
+/**
+* @file     trie/key_encoder.hpp
+* @brief    include file for the order preserving encoder and decoder of composite keys
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#include "basic_key.hpp"
+
+namespace trie
+{
+    /**
+     * @brief builds keys from several columns (integers, floating point numbers, strings, std::chrono durations and time points),
+     *  so that the order of the keys in a trie is the order of the column tuples. This makes range scans over leading columns
+     *  possible with basic_trie::for_each (all keys starting with the encoded columns) and basic_trie::for_each_range.
+     *  - integers are stored big-endian with the sign bit flipped
+     *  - floating point numbers are stored big-endian, all bits of negative numbers and only the sign bit of positive numbers are flipped
+     *    (-0.0 is ordered before 0.0, NaNs with the sign bit cleared are ordered after infinity)
+     *  - strings escape the byte 0x00 as 0x00 0xFF and end with 0x00 0x01, so a string is ordered before all strings it is a prefix of
+     *  - durations and time points are stored as their tick count
+     */
+    class key_encoder
+    {
+    protected:
+        std::string _bytes;
+
+    public:
+        key_encoder() {}
+        ~key_encoder() {}
+
+        /**
+         * @brief append a column to the key
+         * @throws std::bad_alloc from std::string::push_back
+         */
+        template<typename column_t>
+        key_encoder& add(const column_t& value);
+        /**
+         * @brief append a string without its terminator, keys starting with the result are all keys whose column starts with the string.
+         *  No column can be added after this.
+         * @throws std::bad_alloc from std::string::append
+         */
+        key_encoder& add_prefix(std::string_view value);
+
+        /**
+         * @brief get the encoded bytes
+         */
+        const std::string& bytes() const { return this->_bytes; }
+        /**
+         * @brief get the encoded bytes as key of a trie
+         * @throws std::bad_alloc
+         */
+        template<std::size_t children_count>
+        trie::basic_key<children_count> key() const { return to_key<children_count>(this->_bytes); }
+        /**
+         * @brief removes all columns
+         */
+        void clear() { this->_bytes.clear(); }
+
+        /**
+         * @brief convert encoded bytes into a key whose element order is the byte order.
+         *  The nibbles of every byte are swapped for a basic_key<16>, which uses the lower nibble of a byte first.
+         * @throws std::bad_alloc
+         */
+        template<std::size_t children_count>
+        static trie::basic_key<children_count> to_key(const std::string& bytes);
+        /**
+         * @brief the inverse of to_key, e.g. for the keys of a trie's iterators
+         * @throws std::bad_alloc
+         */
+        template<std::size_t children_count>
+        static std::string from_key(const trie::basic_key<children_count>& key);
+    };
+
+    /**
+     * @brief reads the columns of a key built by a key_encoder, the columns have to be read with the types they were added with
+     */
+    class key_decoder
+    {
+    protected:
+        std::string _bytes;
+        std::size_t _position{ 0 };
+
+        /**
+         * @throws std::out_of_range if there are less than 'count' bytes left
+         */
+        void require(std::size_t count) const;
+
+    public:
+        key_decoder(std::string bytes) : _bytes(std::move(bytes)) {}
+        template<std::size_t children_count>
+        key_decoder(const trie::basic_key<children_count>& key) : _bytes(key_encoder::from_key(key)) {}
+        ~key_decoder() {}
+
+        /**
+         * @brief read the next column
+         * @throws std::out_of_range if the key ends inside of the column
+         * @throws std::invalid_argument if a string column contains an invalid escape sequence
+         */
+        template<typename column_t>
+        column_t read();
+        /**
+         * @brief check if all columns have been read
+         */
+        bool at_end() const { return this->_position == this->_bytes.size(); }
+    };
+
+    /**
+     * @brief encode all columns into a key
+     * @throws std::bad_alloc
+     */
+    template<std::size_t children_count, typename... column_t>
+    trie::basic_key<children_count> encode_key(const column_t&... values);
+    /**
+     * @brief decode all columns of a key
+     * @throws std::out_of_range, std::invalid_argument from key_decoder::read
+     */
+    template<typename... column_t, std::size_t children_count>
+    std::tuple<column_t...> decode_key(const trie::basic_key<children_count>& key);
+} // namespace trie
@@ -0,0 +1,100 @@
+/**
+* @file     trie/key_pattern.hpp
+* @brief    include file for the glob and regular expression patterns compiled to automatons over key bytes
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace trie
+{
+    /**
+     * @brief a glob or regular expression compiled into a deterministic automaton over the bytes of a key.
+     *  basic_trie::for_each_match() runs the automaton along the trie and does not enter subtrees in which the automaton
+     *  can no longer reach an accepting state, so selective patterns only visit a small part of the trie.
+     *  Every state knows if it is live (an accepting state can still be reached), a dead state rejects every continuation.
+     */
+    class key_pattern
+    {
+    public:
+        static constexpr std::size_t default_max_states = 1 << 14;
+    protected:
+        struct syntax_node
+        {
+            enum class kind { bytes, concat, alternation, repeat } type;
+            std::bitset<256> set; // for bytes: the bytes matched by this node
+            std::vector<std::unique_ptr<syntax_node> > children;
+            std::size_t min{ 0 }, max{ 0 }; // for repeat: number of repetitions of the only child, max == npos for no upper bound
+        };
+        class parser;
+        using syntax_ptr = std::unique_ptr<syntax_node>;
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        std::vector<uint32_t> _transitions; // state * 256 + byte -> next state, state 0 is the start state
+        std::vector<uint8_t> _accepting;
+        std::vector<uint8_t> _live;
+
+        static syntax_ptr make_bytes(const std::bitset<256>& set);
+        static syntax_ptr make_node(syntax_node::kind type, std::vector<syntax_ptr> children, std::size_t min = 0, std::size_t max = 0);
+        /**
+         * @brief build the automaton from the syntax tree (Thompson construction, then subset construction)
+         * @throws std::length_error if the automaton has more than max_states states
+         */
+        void compile(const syntax_node& root, std::size_t max_states);
+
+        key_pattern() {}
+
+    public:
+        /**
+         * @brief compile a glob matching the whole key: '*' matches any sequence of bytes, '?' a single byte,
+         *  '[abc]', '[a-z]' and '[!a-z]' (or '[^a-z]') a byte of a set, '\' escapes the next character
+         * @throws std::invalid_argument for an invalid pattern
+         * @throws std::length_error if the automaton has more than max_states states
+         */
+        static key_pattern glob(std::string_view pattern, std::size_t max_states = default_max_states);
+        /**
+         * @brief compile a regular expression. Supported are literals, '.' (any byte), classes with ranges and negation, the escapes
+         *  \d \w \s \D \W \S \n \r \t \xHH, groups, '|', the quantifiers * + ? {m} {m,} {m,n} and the anchors '^' at the start and '$' at the end.
+         *  Like std::regex_search, a pattern without anchors matches keys containing a match anywhere.
+         * @throws std::invalid_argument for an invalid or unsupported pattern
+         * @throws std::length_error if the automaton has more than max_states states
+         */
+        static key_pattern regex(std::string_view pattern, std::size_t max_states = default_max_states);
+
+        /**
+         * @brief get the start state
+         */
+        uint32_t start() const { return 0; }
+        /**
+         * @brief get the state after reading a byte
+         */
+        uint32_t next(uint32_t state, uint8_t byte) const { return this->_transitions[(std::size_t)state * 256 + byte]; }
+        /**
+         * @brief check if the bytes read so far are a match
+         */
+        bool accepting(uint32_t state) const { return this->_accepting[state] != 0; }
+        /**
+         * @brief check if a match can still be reached from a state
+         */
+        bool live(uint32_t state) const { return this->_live[state] != 0; }
+        /**
+         * @brief get the number of states of the automaton
+         */
+        std::size_t state_count() const { return this->_accepting.size(); }
+        /**
+         * @brief check if a byte string matches the pattern
+         */
+        bool matches(std::string_view bytes) const;
+    };
+} // namespace trie
@@ -0,0 +1,86 @@
+/**
+* @file     trie/kv_loader.hpp
+* @brief    include file for the streaming loader for key/value text files
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "basic_trie.hpp"
+
+namespace trie
+{
+    /**
+     * @brief read-only view of a whole file. The file is memory mapped where possible, otherwise it is read into a buffer in large blocks.
+     */
+    class mapped_file
+    {
+    protected:
+        const char* _data{ nullptr };
+        std::size_t _size{ 0 };
+        bool _mapped{ false };
+        std::vector<char> _buffer; // only used if the file could not be mapped
+
+    public:
+        /**
+         * @throws std::runtime_error if the file can not be opened or read
+         */
+        mapped_file(const std::string& filename);
+        ~mapped_file();
+
+        mapped_file(const mapped_file& src) = delete; // disable copy constructing
+        mapped_file& operator=(const mapped_file& src) = delete; // disable copy assignments
+
+        std::string_view contents() const { return std::string_view(this->_data, this->_size); }
+        bool is_mapped() const { return this->_mapped; }
+    };
+
+    /**
+     * @brief parser for text files with one pair per line, formatted like `*"key"*:*"value"*` (e.g. a flat *.json file).
+     *  The first two quoted strings of a line are the key and the value, lines with less than two quoted strings are ignored.
+     *  There are no escape sequences, the strings are returned as views into the text without copying them.
+     */
+    class kv_parser
+    {
+    protected:
+        const char* _position;
+        const char* _end;
+
+        /**
+         * @brief get the first '"' or '\n' in [begin, end), end if there is none. Uses SSE2 to test 16 characters at once if it is available.
+         */
+        static const char* find_special(const char* begin, const char* end);
+
+    public:
+        kv_parser(std::string_view text) : _position(text.data()), _end(text.data() + text.size()) {}
+
+        /**
+         * @brief parse the next pair
+         * @return false if the end of the text is reached
+         */
+        bool next(std::string_view& key, std::string_view& value);
+    };
+
+    /**
+     * @brief load all pairs of a key/value text file into a trie. The file is parsed in batches of 'batch_size' pairs,
+     *  each batch is stored with basic_trie::insert_batch. If 'pipelined' is set, the file is parsed by a second thread
+     *  while the calling thread inserts the previous batches, otherwise both steps run on the calling thread.
+     *
+     * @param filename the file to load
+     * @param output the trie to store the pairs into, pairs with keys that are already stored are skipped
+     * @return the number of pairs found in the file
+     * @throws std::runtime_error if the file can not be opened or read
+     * @throws std::bad_alloc
+     */
+    template<std::size_t children_count>
+    std::size_t load_kv_file(const std::string& filename, trie::basic_trie<children_count, std::string>& output, bool pipelined = false, std::size_t batch_size = 4096);
+} // namespace trie
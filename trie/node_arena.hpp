@@ -0,0 +1,120 @@
+/**
+* @file     trie/node_arena.hpp
+* @brief    include file for the bump allocated arena holding the nodes of a compacted trie
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace trie
+{
+    /**
+     * @brief memory arena that hands out consecutive addresses from large chunks. Freed memory is not reused,
+     *  the chunks are released when the arena is destroyed. Objects created with std::allocate_shared and a node_arena::allocator
+     *  keep the arena alive through the allocator copy in their control block, so the arena lives until the last of its objects is released.
+     *  The chunks can be backed by huge pages, so a lookup through a large trie needs far fewer TLB entries.
+     *  The arena is not thread-safe, all allocations have to come from one thread.
+     */
+    class node_arena
+    {
+    public:
+        /**
+         * @brief how the chunks are backed. Huge pages are only available on Linux, everywhere else the chunks always use normal pages.
+         */
+        enum class page_mode
+        {
+            normal, // chunks are allocated with operator new
+            transparent_huge, // 2 MiB aligned anonymous mappings advised with MADV_HUGEPAGE, the kernel promotes them in the background
+            explicit_huge // MAP_HUGETLB mappings from the reserved huge page pool, falls back to transparent_huge if the pool is empty
+        };
+        static constexpr std::size_t huge_page_size = std::size_t(2) << 20;
+
+    protected:
+        struct chunk
+        {
+            char* address;
+            std::size_t length;
+            page_mode mode; // the backing the chunk actually got
+            bool mapped; // true if the chunk is a mapping, false if it is from operator new
+        };
+
+        std::vector<chunk> _chunks;
+        std::size_t _chunk_size;
+        page_mode _mode;
+        std::size_t _used{ 0 }; // bytes used in the last chunk
+        std::size_t _total{ 0 }; // bytes of all chunks
+
+        /**
+         * @brief get a new chunk of at least 'bytes' bytes, every huge page backing that fails falls back to the next simpler one
+         * @throws std::bad_alloc
+         */
+        chunk allocate_chunk(std::size_t bytes);
+        static void release_chunk(const chunk& current);
+
+    public:
+        /**
+         * @param chunk_size size of the first chunk in bytes, every further chunk has the same size (or the size of the allocation, if it is bigger).
+         *  Huge page backed chunks are rounded up to a multiple of the huge page size.
+         * @param mode the preferred backing of the chunks
+         */
+        node_arena(std::size_t chunk_size, page_mode mode = page_mode::normal);
+        ~node_arena();
+
+        node_arena(const node_arena& src) = delete; // disable copy constructing
+        node_arena& operator=(const node_arena& src) = delete; // disable copy assignments
+
+        /**
+         * @throws std::bad_alloc
+         */
+        void* allocate(std::size_t bytes, std::size_t alignment);
+        std::size_t chunk_count() const { return this->_chunks.size(); }
+        /**
+         * @brief get the bytes of all chunks, including the unused end of the last chunk
+         */
+        std::size_t memory_usage() const { return this->_total; }
+        /**
+         * @brief get the number of chunk bytes that got a backing of the given mode
+         */
+        std::size_t backed_bytes(page_mode mode) const;
+        /**
+         * @brief get the number of chunk bytes that are currently backed by huge pages. Explicit huge page chunks always count completely,
+         *  for transparent huge page chunks the AnonHugePages of their mappings are read from /proc/self/smaps.
+         *  The kernel may merge a chunk's mapping with neighbouring mappings, so the result is limited to the size of the chunks.
+         */
+        std::size_t promoted_bytes() const;
+        std::size_t promoted_pages() const { return this->promoted_bytes() / huge_page_size; }
+
+        /**
+         * @brief standard allocator handing out memory of a shared node_arena, deallocate() does nothing
+         */
+        template<typename type_t>
+        class allocator
+        {
+        public:
+            using value_type = type_t;
+
+            std::shared_ptr<node_arena> arena;
+
+            allocator(std::shared_ptr<node_arena> source) : arena(std::move(source)) {}
+            template<typename other_t>
+            allocator(const allocator<other_t>& other) : arena(other.arena) {}
+
+            type_t* allocate(std::size_t count) { return static_cast<type_t*>(this->arena->allocate(count * sizeof(type_t), alignof(type_t))); }
+            void deallocate(type_t*, std::size_t) {}
+
+            template<typename other_t>
+            bool operator==(const allocator<other_t>& other) const { return this->arena == other.arena; }
+            template<typename other_t>
+            bool operator!=(const allocator<other_t>& other) const { return this->arena != other.arena; }
+        };
+    };
+} // namespace trie
@@ -0,0 +1,153 @@
+/**
+* @file     trie/scored_trie.hpp
+* @brief    include file for the trie class with scored keys and top-k completion
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <array>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "basic_key.hpp"
+
+namespace trie
+{
+    /**
+     * @brief trie mapping keys to pointers and scores, made for autocompletion. Every node caches the best score of its subtree,
+     *  which is kept up to date by insert(), erase() and update_score(). complete() expands the subtrees best-first,
+     *  so finding the k best completions of a prefix only touches the nodes on the paths to those k keys and their siblings,
+     *  no matter how many keys start with the prefix.
+     *  Like in basic_trie, a subtree holding a single key is stored as one node with a key tail.
+     *
+     * @tparam children_count number of possible states for one key element. MUST be one of: 2, 4, 16, 256
+     * @tparam value_t the datatype stored by the std::shared_ptr's
+     * @tparam score_t the type of the scores, higher scores are better
+     */
+    template<std::size_t children_count, typename value_t, typename score_t = double>
+    class scored_trie
+    {
+    public:
+        using key_t = trie::basic_key<children_count>;
+
+        /**
+         * @brief a key found by complete()
+         */
+        struct completion
+        {
+            key_t key;
+            score_t score;
+            std::shared_ptr<value_t> data;
+        };
+    protected:
+        struct node
+        {
+            std::array<std::shared_ptr<node>, children_count> children;
+            std::shared_ptr<value_t> data;
+            bool has_data{ false }; // true if a key ends at this node, the data pointer itself may be a nullptr
+            score_t score{}; // score of the key ending at this node
+            score_t best{ std::numeric_limits<score_t>::lowest() }; // best score of all keys in this subtree, including this node's key
+            std::shared_ptr<key_t> tail; // remaining key elements of the only key in this subtree, a node with a tail has no children
+
+            /**
+             * @brief get the node's child with the index key_element
+             * @throws std::out_of_range from std::array::at if the parameter is bigger than the number of children supported by the trie
+             */
+            std::shared_ptr<node>& child(std::size_t key_element) { return this->children.at(key_element); }
+            /**
+             * @brief calculate the best score of this subtree from the node's own score and the cached scores of its children
+             */
+            score_t subtree_best() const;
+        };
+
+        std::shared_ptr<node> _root;
+        std::size_t _size;
+
+        /**
+         * @brief get all nodes from the root to the node storing a key, empty if the key is not stored
+         * @throws std::bad_alloc from std::vector::push_back
+         */
+        std::vector<node*> find_path(const key_t& _key) const;
+        /**
+         * @brief get the node storing a key, nullptr if the key is not stored
+         */
+        node* find(const key_t& _key) const;
+        /**
+         * @brief move the tail of a node one level down into a new child node
+         * @throws std::bad_alloc from std::make_shared()
+         */
+        static void push_down(node* _node);
+        /**
+         * @brief recalculate the cached best scores along a path from the bottom up, stops once a best score does not change
+         */
+        static void refresh_path(const std::vector<node*>& path);
+
+    public:
+        scored_trie() { this->clear(); }
+        ~scored_trie() {}
+
+        scored_trie(scored_trie&& src) noexcept = default;
+        scored_trie& operator=(scored_trie&& src) noexcept = default;
+        scored_trie(const scored_trie& src) = delete; // disable copy constructing
+        scored_trie& operator=(const scored_trie& src) = delete; // disable copy assignments
+
+        /**
+         * @brief check if a key is stored
+         */
+        bool contains(const key_t& key) const;
+        /**
+         * @brief get the pointer to the value stored at a key
+         * @throws std::out_of_range if the trie does not store the key
+         */
+        std::shared_ptr<value_t>& at(const key_t& key);
+        /**
+         * @brief get the score of a key
+         * @throws std::out_of_range if the trie does not store the key
+         */
+        score_t score(const key_t& key) const;
+        /**
+         * @brief insert a pointer to a value with a score into the trie
+         *
+         * @return true if the value could be inserted, false if the key was already stored
+         * @throws std::bad_alloc
+         */
+        bool insert(const key_t& key, std::shared_ptr<value_t> value, score_t score);
+        /**
+         * @brief change the score of a stored key
+         *
+         * @return true if the score was changed, false if the key is not stored
+         * @throws std::bad_alloc
+         */
+        bool update_score(const key_t& key, score_t score);
+        /**
+         * @brief remove a key from the trie, nodes that are no longer needed are removed as well
+         *
+         * @return true to indicate that the key has been removed, false if the key was not stored
+         * @throws std::bad_alloc
+         */
+        bool erase(const key_t& key);
+        /**
+         * @brief removes all keys from the trie and resets it into the valid empty state
+         */
+        void clear();
+        /**
+         * @brief returns the number of keys stored in the trie, this has a complexity of O(1)
+         */
+        std::size_t size() const { return this->_size; }
+
+        /**
+         * @brief get the k keys with the best scores starting with a prefix (including the prefix itself)
+         *
+         * @return the completions ordered by score from best to worst, completions with the same score are ordered by key
+         * @throws std::bad_alloc
+         */
+        std::vector<completion> complete(const key_t& prefix, std::size_t k) const;
+    }; // class scored_trie
+} // namespace trie
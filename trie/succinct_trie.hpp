@@ -0,0 +1,150 @@
+/**
+* @file     trie/succinct_trie.hpp
+* @brief    include file for the read-only LOUDS encoded trie class
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include "basic_key.hpp"
+#include "basic_trie.hpp"
+#include "bit_vector.hpp"
+
+namespace trie
+{
+    /**
+     * @brief static (read-only) trie that is built from a basic_trie and stores the trie topology as a LOUDS bit vector.
+     *  Every node is numbered in breadth-first order, the LOUDS bit vector contains the degree of every node in unary ("1...10").
+     *  The edge labels are stored in breadth-first order as a packed key (so a trie2 only needs 1 bit per label),
+     *  the values are stored in a packed array that is indexed by the rank of the node's "has value" bit.
+     *  A node costs about 2 bits of topology, log2(children_count) bits of label and 1 bit of value flag,
+     *  lookups have a complexity of O(key length * log2(children_count)).
+     *  INFO: only nodes that lead to a value are kept, empty leaf nodes of the source trie are dropped
+     *
+     * @tparam children_count number of possible states for one key element. MUST be one of: 2, 4, 16, 256
+     * @tparam value_t the datatype stored by the std::shared_ptr's
+     */
+    template<std::size_t children_count, typename value_t>
+    class succinct_trie
+    {
+    public:
+        using key_t = trie::basic_key<children_count>;
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    protected:
+        trie::bit_vector _louds; // unary node degrees in breadth-first order
+        trie::bit_vector _has_value; // one bit per node, set if the node holds a value
+        key_t _labels; // one key element per edge in breadth-first order, edge i leads to node i+1
+        std::vector<std::shared_ptr<value_t> > _values; // values in breadth-first order of their nodes
+
+        /**
+         * @brief get the range of edge indices [first, last) of a node's children
+         */
+        std::pair<std::size_t, std::size_t> edges(std::size_t node) const;
+        /**
+         * @brief get the child node of 'node' with the label 'key_element', npos if the child does not exist
+         */
+        std::size_t child(std::size_t node, uint8_t key_element) const;
+        /**
+         * @brief get the number of the node at key '_key', npos if the node does not exist
+         */
+        std::size_t find_node(const key_t& _key) const;
+
+    public:
+        succinct_trie() { this->clear(); }
+        /**
+         * @brief construct a succinct trie holding all values of the source trie
+         * @throws std::bad_alloc
+         */
+        succinct_trie(trie::basic_trie<children_count, value_t>& source) { this->build(source); }
+        ~succinct_trie() {}
+
+        /**
+         * @brief rebuild this trie from all values stored in the source trie. The source trie is not modified
+         *
+         * @param source which trie to encode
+         * @throws std::bad_alloc
+         */
+        void build(trie::basic_trie<children_count, value_t>& source);
+        /**
+         * @brief resets the trie into the valid empty state
+         */
+        void clear();
+
+        /**
+         * @brief check if the trie has a specific node (every prefix of a stored key has a node)
+         */
+        bool has_node(const key_t& _key) const;
+        /**
+         * @brief get the pointer to the value stored at a key, this pointer can be a nullptr!
+         *
+         * @param key the key to the value
+         * @return reference to a std::shared_ptr of value type
+         * @throws std::out_of_range if the trie does not have the requested node
+         */
+        const std::shared_ptr<value_t>& at(const key_t& key) const;
+        /**
+         * @brief get the number of values stored in the trie, this has a complexity of O(1)
+         */
+        std::size_t size() const { return this->_values.size(); }
+        /**
+         * @brief get the number of nodes (including the root node) of the trie
+         */
+        std::size_t node_count() const { return this->_has_value.size(); }
+        /**
+         * @brief get the number of bytes used by the topology, the labels and the value array (not including the values themselves)
+         */
+        std::size_t memory_usage() const;
+
+        /**
+         * @brief forward iterator over all values in key order. The iterator keeps a stack of the
+         *  current path, so stepping does not need to search the parent node.
+         */
+        class value_iterator
+        {
+        protected:
+            struct frame
+            {
+                std::size_t node, next_edge, last_edge;
+            };
+            const succinct_trie* _trie{ nullptr };
+            std::vector<frame> _stack;
+            key_t cur_key;
+            std::size_t cur_node{ npos };
+
+            void push_node(std::size_t node);
+            void next_value();
+
+        public:
+            value_iterator() {}
+            value_iterator(const succinct_trie* source, bool at_begin);
+            ~value_iterator() {}
+
+            inline bool operator==(const value_iterator& other) const { return this->cur_node == other.cur_node; }
+            inline bool operator!=(const value_iterator& other) const { return !(*this == other); }
+
+            inline bool is_null() const { return this->cur_node == npos; }
+            inline operator bool() const { return !this->is_null(); }
+            inline bool operator!() const { return this->is_null(); }
+
+            /**
+             * @brief Get the key of where the iterator is currently at
+             */
+            inline const key_t& get_key() const { return this->cur_key; }
+            /**
+             * @brief Get the data pointer of where the iterator is currently at
+             */
+            inline const std::shared_ptr<value_t>& get_data() const { return this->_trie->_values.at(this->_trie->_has_value.rank1(this->cur_node)); }
+
+            value_iterator& operator++() { this->next_value(); return *this; }
+            value_iterator operator++(int) { value_iterator copy = *this; this->next_value(); return copy; }
+        }; // class value_iterator
+
+        value_iterator begin() const { return value_iterator(this, true); }
+        value_iterator end() const { return value_iterator(this, false); }
+    }; // class succinct_trie
+} // namespace trie
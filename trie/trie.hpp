@@ -13,16 +13,47 @@
 
 // definitions include files
 #include "basic_key.hpp"
+#include "instrumentation.hpp"
+#include "key_pattern.hpp"
+#include "background_reclaimer.hpp"
+#include "work_stealing_pool.hpp"
+#include "bloom_filter.hpp"
+#include "node_arena.hpp"
 #include "basic_trie.hpp"
+#include "bit_vector.hpp"
+#include "succinct_trie.hpp"
+#include "double_array_trie.hpp"
+#include "dawg.hpp"
+#include "aho_corasick.hpp"
+#include "hat_trie.hpp"
+#include "integer_trie.hpp"
+#include "scored_trie.hpp"
+#include "kv_loader.hpp"
+#include "key_encoder.hpp"
 
 // implementation include files
 #include "impl/key256_impl.hpp"
 #include "impl/key16_impl.hpp"
 #include "impl/key4_impl.hpp"
 #include "impl/key2_impl.hpp"
+#include "impl/key_pattern_impl.hpp"
+#include "impl/background_reclaimer_impl.hpp"
+#include "impl/work_stealing_pool_impl.hpp"
+#include "impl/bloom_filter_impl.hpp"
+#include "impl/node_arena_impl.hpp"
 #include "impl/basic_trie_impl.hpp"
 #include "impl/basic_node_iterator_impl.hpp"
 #include "impl/basic_value_iterator_impl.hpp"
+#include "impl/bit_vector_impl.hpp"
+#include "impl/succinct_trie_impl.hpp"
+#include "impl/double_array_trie_impl.hpp"
+#include "impl/dawg_impl.hpp"
+#include "impl/aho_corasick_impl.hpp"
+#include "impl/hat_trie_impl.hpp"
+#include "impl/integer_trie_impl.hpp"
+#include "impl/scored_trie_impl.hpp"
+#include "impl/kv_loader_impl.hpp"
+#include "impl/key_encoder_impl.hpp"
 
 namespace trie
 {
@@ -32,6 +63,30 @@ namespace trie
     template<typename value_t> using trie4 = trie::basic_trie<4, value_t>;
     template<typename value_t> using trie2 = trie::basic_trie<2, value_t>;
 
+    // succinct trie usings
+    template<typename value_t> using succinct_trie256 = trie::succinct_trie<256, value_t>;
+    template<typename value_t> using succinct_trie16 = trie::succinct_trie<16, value_t>;
+    template<typename value_t> using succinct_trie4 = trie::succinct_trie<4, value_t>;
+    template<typename value_t> using succinct_trie2 = trie::succinct_trie<2, value_t>;
+
+    // automaton usings
+    template<typename value_t> using dawg256 = trie::dawg<256, value_t>;
+    template<typename value_t> using dawg16 = trie::dawg<16, value_t>;
+    template<typename value_t> using dawg4 = trie::dawg<4, value_t>;
+    template<typename value_t> using dawg2 = trie::dawg<2, value_t>;
+
+    // hybrid trie usings
+    template<typename value_t> using hat_trie256 = trie::hat_trie<256, value_t>;
+    template<typename value_t> using hat_trie16 = trie::hat_trie<16, value_t>;
+    template<typename value_t> using hat_trie4 = trie::hat_trie<4, value_t>;
+    template<typename value_t> using hat_trie2 = trie::hat_trie<2, value_t>;
+
+    // integer key trie usings
+    template<typename integer_t, typename value_t> using integer_trie256 = trie::integer_trie<256, integer_t, value_t>;
+    template<typename integer_t, typename value_t> using integer_trie16 = trie::integer_trie<16, integer_t, value_t>;
+    template<typename integer_t, typename value_t> using integer_trie4 = trie::integer_trie<4, integer_t, value_t>;
+    template<typename integer_t, typename value_t> using integer_trie2 = trie::integer_trie<2, integer_t, value_t>;
+
     // key usings
     using key256 = trie::basic_key<256>;
     using key16 = trie::basic_key<16>;
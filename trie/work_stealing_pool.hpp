@@ -0,0 +1,86 @@
+/**
+* @file     trie/work_stealing_pool.hpp
+* @brief    include file for the work-stealing thread pool used by the parallel trie traversals
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace trie
+{
+    /**
+     * @brief fixed size thread pool with one task queue per worker. The tasks of a batch are distributed over all queues,
+     *  a worker takes tasks from the back of its own queue and steals from the front of the other queues once its own queue is empty.
+     *  This balances batches of subtrees with very different sizes.
+     */
+    class work_stealing_pool
+    {
+    protected:
+        struct task_queue
+        {
+            std::mutex mutex;
+            std::deque<std::function<void(std::size_t)> > tasks;
+        };
+
+        std::vector<std::unique_ptr<task_queue> > _queues; // one queue per worker
+        std::vector<std::thread> _threads;
+        std::mutex _mutex;
+        std::condition_variable _changed;
+        std::atomic<std::size_t> _queued{ 0 }; // number of tasks in all queues
+        std::atomic<std::size_t> _next_queue{ 0 }; // the next batch starts distributing its tasks at this queue
+        bool _stopping{ false };
+
+        /**
+         * @brief take a task from the worker's own queue or steal one from another queue
+         * @return false if all queues are empty
+         */
+        bool take_task(std::size_t worker, std::function<void(std::size_t)>& task);
+        void run_worker(std::size_t worker);
+        /**
+         * @brief stop and join all worker threads, tasks that are still queued are not run
+         */
+        void stop();
+
+    public:
+        /**
+         * @param thread_count number of worker threads, 0 uses the number of hardware threads
+         * @throws std::system_error if a thread can not be started
+         */
+        work_stealing_pool(std::size_t thread_count = 0);
+        ~work_stealing_pool();
+
+        work_stealing_pool(const work_stealing_pool& src) = delete; // disable copy constructing
+        work_stealing_pool& operator=(const work_stealing_pool& src) = delete; // disable copy assignments
+
+        /**
+         * @brief get the number of worker threads, worker indices passed to the tasks are smaller than this
+         */
+        std::size_t thread_count() const { return this->_threads.size(); }
+        /**
+         * @brief run task(index, worker) for every index in [0, count) on the worker threads and wait until all of them are done.
+         *  The calling thread only waits, so run() must not be called from inside of a task of the same pool.
+         *
+         * @throws the first exception thrown by a task, the tasks that did not start yet are skipped after an exception
+         */
+        void run(std::size_t count, const std::function<void(std::size_t index, std::size_t worker)>& task);
+
+        /**
+         * @brief get a process wide pool with one worker per hardware thread, it is created on the first call
+         */
+        static work_stealing_pool& shared();
+    };
+} // namespace trie
@@ -0,0 +1,455 @@
+/**
+* @file     trie_bench.cpp
+* @brief    benchmark suite comparing the trie fan-outs against the standard library containers
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "trie.hpp"
+#include "bench_keys.hpp"
+
+/**
+ * @brief one measured operation, the peak RSS is taken from the process that ran the container
+ */
+struct bench_result
+{
+    std::string dataset, container, operation;
+    std::size_t count; // number of operations
+    double ns_per_op;
+    long peak_rss_kb;
+};
+
+/**
+ * @brief input of one benchmark run, all key lists are prepared before any container is built
+ */
+struct bench_input
+{
+    std::string name;
+    std::vector<std::string> keys; // unique keys in random order
+    std::vector<std::string> misses; // keys that are not stored
+    std::vector<std::string> prefixes; // prefixes of stored keys for the prefix scans
+};
+
+/**
+ * @brief adapter for the basic_trie classes
+ */
+template<std::size_t children_count>
+struct trie_adapter
+{
+    using container_t = trie::basic_trie<children_count, std::string>;
+    using key_t = trie::basic_key<children_count>;
+    static constexpr bool has_prefix_scan = true, has_merge = true, has_clone = true, has_visit = true, has_compact = true;
+
+    static key_t make_key(const std::string& key) { return key_t(key); }
+    static bool insert(container_t& container, const key_t& key, std::shared_ptr<std::string> value) { return container.insert(key, value); }
+    // find() searches the trie once and does not throw for missing keys
+    static bool find_hit(container_t& container, const key_t& key) { return container.find(key) != nullptr; }
+    static bool find_miss(container_t& container, const key_t& key) { return container.find(key) != nullptr; }
+    static std::size_t prefix_scan(container_t& container, const key_t& prefix)
+    {
+        std::size_t counter = 0;
+        container.for_each(prefix, [&counter](const key_t&, std::shared_ptr<std::string>&) { ++counter; });
+        return counter;
+    }
+    static std::size_t iterate(container_t& container)
+    {
+        std::size_t counter = 0;
+        for (auto iter = container.begin(); iter != container.end(); iter++) ++counter;
+        return counter;
+    }
+    static std::size_t visit(container_t& container)
+    {
+        std::size_t counter = 0;
+        container.for_each(key_t(), [&counter](const key_t&, std::shared_ptr<std::string>&) { ++counter; });
+        return counter;
+    }
+    static void merge(container_t& container, container_t& source) { container.merge(source); }
+    static container_t clone(container_t& container) { return container.clone(); }
+    static void compact(container_t& container) { container.compact(); }
+    // erasing a trie key also removes all keys below it, later erases of those keys are still counted as operations
+    static bool erase(container_t& container, const key_t& key) { return container.erase(key); }
+};
+
+/**
+ * @brief adapter for the hybrid trie classes, they do not support prefix scans, merging or cloning
+ */
+template<std::size_t children_count>
+struct hat_trie_adapter
+{
+    using container_t = trie::hat_trie<children_count, std::string>;
+    using key_t = trie::basic_key<children_count>;
+    static constexpr bool has_prefix_scan = false, has_merge = false, has_clone = false, has_visit = false, has_compact = false;
+
+    static key_t make_key(const std::string& key) { return key_t(key); }
+    static bool insert(container_t& container, const key_t& key, std::shared_ptr<std::string> value) { return container.insert(key, value); }
+    static bool find_hit(container_t& container, const key_t& key) { return container.contains(key); }
+    static bool find_miss(container_t& container, const key_t& key) { return container.contains(key); }
+    static std::size_t prefix_scan(container_t&, const key_t&) { return 0; }
+    static std::size_t iterate(container_t& container)
+    {
+        std::size_t counter = 0;
+        for (auto iter = container.begin(); iter != container.end(); iter++) ++counter;
+        return counter;
+    }
+    static std::size_t visit(container_t&) { return 0; }
+    static void merge(container_t&, container_t&) {}
+    static container_t clone(container_t&) { return container_t(); }
+    static void compact(container_t&) {}
+    static bool erase(container_t& container, const key_t& key) { return container.erase(key); }
+};
+
+/**
+ * @brief adapter for std::map, the prefix scan starts at the lower bound of the prefix
+ */
+struct map_adapter
+{
+    using container_t = std::map<std::string, std::shared_ptr<std::string> >;
+    using key_t = std::string;
+    static constexpr bool has_prefix_scan = true, has_merge = true, has_clone = true, has_visit = false, has_compact = false;
+
+    static key_t make_key(const std::string& key) { return key; }
+    static bool insert(container_t& container, const key_t& key, std::shared_ptr<std::string> value) { return container.emplace(key, value).second; }
+    static bool find_hit(container_t& container, const key_t& key) { return container.find(key) != container.end(); }
+    static bool find_miss(container_t& container, const key_t& key) { return container.find(key) != container.end(); }
+    static std::size_t prefix_scan(container_t& container, const key_t& prefix)
+    {
+        std::size_t counter = 0;
+        for (auto iter = container.lower_bound(prefix); iter != container.end() && iter->first.compare(0, prefix.size(), prefix) == 0; iter++) ++counter;
+        return counter;
+    }
+    static std::size_t iterate(container_t& container)
+    {
+        std::size_t counter = 0;
+        for (auto iter = container.begin(); iter != container.end(); iter++) ++counter;
+        return counter;
+    }
+    static std::size_t visit(container_t&) { return 0; }
+    static void merge(container_t& container, container_t& source) { container.merge(source); }
+    static container_t clone(container_t& container) { return container; }
+    static void compact(container_t&) {}
+    static bool erase(container_t& container, const key_t& key) { return container.erase(key) != 0; }
+};
+
+/**
+ * @brief adapter for std::unordered_map, a prefix scan has to test every key
+ */
+struct unordered_map_adapter
+{
+    using container_t = std::unordered_map<std::string, std::shared_ptr<std::string> >;
+    using key_t = std::string;
+    static constexpr bool has_prefix_scan = true, has_merge = true, has_clone = true, has_visit = false, has_compact = false;
+
+    static key_t make_key(const std::string& key) { return key; }
+    static bool insert(container_t& container, const key_t& key, std::shared_ptr<std::string> value) { return container.emplace(key, value).second; }
+    static bool find_hit(container_t& container, const key_t& key) { return container.find(key) != container.end(); }
+    static bool find_miss(container_t& container, const key_t& key) { return container.find(key) != container.end(); }
+    static std::size_t prefix_scan(container_t& container, const key_t& prefix)
+    {
+        std::size_t counter = 0;
+        for (auto iter = container.begin(); iter != container.end(); iter++)
+        {
+            if (iter->first.compare(0, prefix.size(), prefix) == 0) ++counter;
+        }
+        return counter;
+    }
+    static std::size_t iterate(container_t& container)
+    {
+        std::size_t counter = 0;
+        for (auto iter = container.begin(); iter != container.end(); iter++) ++counter;
+        return counter;
+    }
+    static std::size_t visit(container_t&) { return 0; }
+    static void merge(container_t& container, container_t& source) { container.merge(source); }
+    static container_t clone(container_t& container) { return container; }
+    static void compact(container_t&) {}
+    static bool erase(container_t& container, const key_t& key) { return container.erase(key) != 0; }
+};
+
+/**
+ * @brief get the peak resident set size of this process in kilobytes
+ */
+long peak_rss_kb()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/**
+ * @brief time a function doing 'count' operations, the result is the average time per operation in nanoseconds
+ */
+template<typename function_t>
+double measure(std::size_t count, function_t function)
+{
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / (double)std::max<std::size_t>(count, 1);
+}
+
+/**
+ * @brief run all operations on one container type and write one line per operation: `operation count ns_per_op`
+ *
+ * @param checksum accumulates the results of the operations, so the compiler can not drop them
+ */
+template<typename adapter_t>
+void run_container(const bench_input& input, std::ostream& output, std::size_t& checksum)
+{
+    using container_t = typename adapter_t::container_t;
+    using key_t = typename adapter_t::key_t;
+    std::vector<key_t> keys, misses, prefixes, first_half, second_half;
+    std::vector<std::shared_ptr<std::string> > values;
+    for (const std::string& key : input.keys)
+    {
+        keys.push_back(adapter_t::make_key(key));
+        values.push_back(std::make_shared<std::string>(key));
+    }
+    for (const std::string& key : input.misses) misses.push_back(adapter_t::make_key(key));
+    for (const std::string& key : input.prefixes) prefixes.push_back(adapter_t::make_key(key));
+
+    container_t container;
+    auto report = [&output](const char* operation, std::size_t count, double ns_per_op)
+    {
+        output << operation << " " << count << " " << ns_per_op << "\n";
+    };
+
+    report("insert", keys.size(), measure(keys.size(), [&]()
+        {
+            for (std::size_t i = 0; i < keys.size(); i++) checksum += adapter_t::insert(container, keys[i], values[i]) ? 1 : 0;
+        }));
+    report("lookup_hit", keys.size(), measure(keys.size(), [&]()
+        {
+            for (const key_t& key : keys) checksum += adapter_t::find_hit(container, key) ? 1 : 0;
+        }));
+    report("lookup_miss", misses.size(), measure(misses.size(), [&]()
+        {
+            for (const key_t& key : misses) checksum += adapter_t::find_miss(container, key) ? 1 : 0;
+        }));
+    if constexpr (adapter_t::has_prefix_scan)
+    {
+        report("prefix_scan", prefixes.size(), measure(prefixes.size(), [&]()
+            {
+                for (const key_t& prefix : prefixes) checksum += adapter_t::prefix_scan(container, prefix);
+            }));
+    }
+    report("iterate", keys.size(), measure(keys.size(), [&]()
+        {
+            checksum += adapter_t::iterate(container);
+        }));
+    if constexpr (adapter_t::has_visit)
+    {
+        report("for_each", keys.size(), measure(keys.size(), [&]()
+            {
+                checksum += adapter_t::visit(container);
+            }));
+    }
+    if constexpr (adapter_t::has_clone)
+    {
+        container_t copy;
+        report("clone", keys.size(), measure(keys.size(), [&]()
+            {
+                copy = adapter_t::clone(container);
+            }));
+    }
+    if constexpr (adapter_t::has_merge)
+    {
+        // the halves are built outside of the measurement, only the merge itself is timed
+        container_t target, source;
+        for (std::size_t i = 0; i < keys.size(); i++) adapter_t::insert((i % 2 == 0) ? target : source, keys[i], values[i]);
+        report("merge", keys.size() / 2, measure(keys.size() / 2, [&]()
+            {
+                adapter_t::merge(target, source);
+            }));
+    }
+    report("erase", keys.size(), measure(keys.size(), [&]()
+        {
+            for (const key_t& key : keys) checksum += adapter_t::erase(container, key) ? 1 : 0;
+        }));
+    if constexpr (adapter_t::has_compact)
+    {
+        // compacting relays all nodes, so it runs on a container of its own after the other operations,
+        // the keys are inserted in random order again and the lookups are repeated on the relaid nodes
+        container_t compacted;
+        for (std::size_t i = 0; i < keys.size(); i++) adapter_t::insert(compacted, keys[i], values[i]);
+        report("compact", keys.size(), measure(keys.size(), [&]()
+            {
+                adapter_t::compact(compacted);
+            }));
+        report("lookup_hit_compacted", keys.size(), measure(keys.size(), [&]()
+            {
+                for (const key_t& key : keys) checksum += adapter_t::find_hit(compacted, key) ? 1 : 0;
+            }));
+        report("lookup_miss_compacted", misses.size(), measure(misses.size(), [&]()
+            {
+                for (const key_t& key : misses) checksum += adapter_t::find_miss(compacted, key) ? 1 : 0;
+            }));
+    }
+}
+
+/**
+ * @brief run one container type in a child process, so the peak RSS only covers this container
+ */
+template<typename adapter_t>
+void run_isolated(const std::string& container_name, const bench_input& input, std::vector<bench_result>& results)
+{
+    int channel[2];
+    if (pipe(channel) != 0) throw std::runtime_error("Error creating pipe");
+    pid_t child = fork();
+    if (child < 0) throw std::runtime_error("Error forking benchmark process");
+    if (child == 0)
+    {
+        std::ostringstream output;
+        std::size_t checksum = 0;
+        close(channel[0]);
+        run_container<adapter_t>(input, output, checksum);
+        output << "peak_rss " << peak_rss_kb() << " " << checksum << "\n";
+        std::string buffer = output.str();
+        for (std::size_t written = 0; written < buffer.size(); )
+        {
+            ssize_t result = write(channel[1], buffer.data() + written, buffer.size() - written);
+            if (result <= 0) _exit(1);
+            written += (std::size_t)result;
+        }
+        close(channel[1]);
+        _exit(0);
+    }
+
+    std::string buffer, operation;
+    char chunk[4096];
+    ssize_t length;
+    int status = 0;
+    close(channel[1]);
+    while ((length = read(channel[0], chunk, sizeof(chunk))) > 0) buffer.append(chunk, (std::size_t)length);
+    close(channel[0]);
+    waitpid(child, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) throw std::runtime_error("Benchmark process for " + container_name + " failed");
+
+    std::istringstream input_lines(buffer);
+    std::size_t first = results.size(), count;
+    double ns_per_op;
+    long rss = 0;
+    while (input_lines >> operation)
+    {
+        if (operation == "peak_rss")
+        {
+            input_lines >> rss >> count; // the checksum is only read to consume the line
+            continue;
+        }
+        input_lines >> count >> ns_per_op;
+        results.push_back(bench_result{ input.name, container_name, operation, count, ns_per_op, 0 });
+    }
+    for (std::size_t i = first; i < results.size(); i++)
+    {
+        results[i].peak_rss_kb = rss;
+        std::cout << input.name << " / " << container_name << " / " << results[i].operation << ": "
+            << results[i].ns_per_op << " ns/op, " << 1e9 / results[i].ns_per_op << " ops/s, peak RSS " << rss << " kB" << std::endl;
+    }
+}
+
+/**
+ * @brief shuffle the keys and derive the miss keys and the prefixes from them
+ */
+bench_input make_input(const std::string& name, const std::vector<std::string>& raw_keys, std::size_t count)
+{
+    bench_input input;
+    std::mt19937_64 rng(7);
+    input.name = name;
+    input.keys = unique_keys(raw_keys);
+    std::shuffle(input.keys.begin(), input.keys.end(), rng);
+    if (input.keys.size() > count) input.keys.resize(count);
+    std::unordered_set<std::string> stored(input.keys.begin(), input.keys.end());
+    for (const std::string& key : input.keys)
+    {
+        // a miss key follows a stored key to its end, which is the most expensive miss for a trie
+        std::string miss = key + "#";
+        if (stored.count(miss) == 0) input.misses.push_back(miss);
+    }
+    for (std::size_t i = 0; i < input.keys.size() && input.prefixes.size() < 1000; i += 1 + input.keys.size() / 1000)
+    {
+        input.prefixes.push_back(input.keys[i].substr(0, input.keys[i].size() / 2));
+    }
+    return input;
+}
+
+/**
+ * @brief write all results as a JSON array of objects
+ */
+void write_json(std::ostream& output, const std::vector<bench_result>& results)
+{
+    output << "[\n";
+    for (std::size_t i = 0; i < results.size(); i++)
+    {
+        const bench_result& result = results[i];
+        output << "  {\"dataset\": \"" << result.dataset << "\", \"container\": \"" << result.container
+            << "\", \"operation\": \"" << result.operation << "\", \"count\": " << result.count
+            << ", \"ns_per_op\": " << result.ns_per_op << ", \"ops_per_s\": " << 1e9 / result.ns_per_op
+            << ", \"peak_rss_kb\": " << result.peak_rss_kb << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    output << "]\n";
+}
+
+int main(int argc, char** argv)
+{
+    std::string filename = "test_data.txt", json_filename;
+    std::size_t count = 5000;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "--json" && i + 1 < argc) json_filename = argv[++i];
+        else if (argument == "--count" && i + 1 < argc) count = std::stoull(argv[++i]);
+        else if (argument == "--help")
+        {
+            std::cout << "usage: " << argv[0] << " [test_data.txt] [--count keys] [--json output.json]" << std::endl;
+            return 0;
+        }
+        else filename = argument;
+    }
+
+    std::vector<bench_input> inputs;
+    std::ifstream ifile(filename);
+    if (ifile) inputs.push_back(make_input("test_data", read_keys(ifile), count));
+    else std::cout << "could not open " << filename << ", only using generated keys" << std::endl;
+    inputs.push_back(make_input("uniform", generate_uniform_keys(count), count));
+    inputs.push_back(make_input("shared_prefix", generate_shared_prefix_keys(count), count));
+    inputs.push_back(make_input("long", generate_long_keys(count), count));
+
+    std::vector<bench_result> results;
+    for (const bench_input& input : inputs)
+    {
+        std::cout << std::endl << "Dataset " << input.name << " (" << input.keys.size() << " keys)" << std::endl
+            << "================================" << std::endl;
+        run_isolated<trie_adapter<256> >("trie256", input, results);
+        run_isolated<trie_adapter<16> >("trie16", input, results);
+        run_isolated<trie_adapter<4> >("trie4", input, results);
+        run_isolated<trie_adapter<2> >("trie2", input, results);
+        run_isolated<hat_trie_adapter<256> >("hat_trie256", input, results);
+        run_isolated<map_adapter>("std::map", input, results);
+        run_isolated<unordered_map_adapter>("std::unordered_map", input, results);
+    }
+
+    if (!json_filename.empty())
+    {
+        std::ofstream ofile(json_filename);
+        if (!ofile) throw std::runtime_error("Error opening " + json_filename);
+        write_json(ofile, results);
+        std::cout << std::endl << "wrote " << results.size() << " results to " << json_filename << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,270 @@
+/**
+* @file     trie_load.cpp
+* @brief    load generator replaying a mixed workload against a trie and reporting latency percentiles
+* @author   Clemens Pruggmayer
+* (c) 2021 by Clemens Pruggmayer
+*
+* This code is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <cmath>
+
+#include "trie.hpp"
+#include "bench_keys.hpp"
+
+/**
+ * @brief log-linear latency histogram in the style of HdrHistogram. Values below 2^sub_bucket_bits are stored exactly,
+ *  every larger power of two range is split into 2^(sub_bucket_bits - 1) buckets, so the relative error stays below 1/64.
+ */
+class latency_histogram
+{
+protected:
+    static constexpr unsigned sub_bucket_bits = 7;
+    static constexpr uint64_t sub_bucket_count = 1ull << sub_bucket_bits;
+    static constexpr uint64_t half_count = sub_bucket_count / 2;
+    std::vector<uint64_t> _buckets;
+    uint64_t _count{ 0 }, _max{ 0 };
+
+    static std::size_t index_of(uint64_t value)
+    {
+        if (value < sub_bucket_count) return (std::size_t)value;
+        unsigned bits = 0;
+        for (uint64_t helper = value; helper != 0; helper >>= 1) ++bits;
+        unsigned shift = bits - sub_bucket_bits;
+        return (std::size_t)(sub_bucket_count + (shift - 1) * half_count + ((value >> shift) - half_count));
+    }
+    static uint64_t highest_value_of(std::size_t index)
+    {
+        if (index < sub_bucket_count) return index;
+        unsigned shift = (unsigned)((index - sub_bucket_count) / half_count) + 1;
+        uint64_t lowest = (((index - sub_bucket_count) % half_count) + half_count) << shift;
+        return lowest + (1ull << shift) - 1;
+    }
+
+public:
+    latency_histogram() : _buckets(index_of(~0ull) + 1, 0) {}
+
+    void record(uint64_t value)
+    {
+        ++this->_buckets[index_of(value)];
+        ++this->_count;
+        this->_max = std::max(this->_max, value);
+    }
+    void add(const latency_histogram& other)
+    {
+        for (std::size_t i = 0; i < this->_buckets.size(); i++) this->_buckets[i] += other._buckets[i];
+        this->_count += other._count;
+        this->_max = std::max(this->_max, other._max);
+    }
+    uint64_t count() const { return this->_count; }
+    uint64_t max() const { return this->_max; }
+    /**
+     * @brief get the highest value that is equivalent to the value at the percentile, 0 for an empty histogram
+     */
+    uint64_t percentile(double percent) const
+    {
+        uint64_t target = (uint64_t)std::ceil(percent / 100.0 * (double)this->_count), seen = 0;
+        if (target == 0) target = 1;
+        for (std::size_t i = 0; i < this->_buckets.size(); i++)
+        {
+            seen += this->_buckets[i];
+            if (seen >= target) return std::min(highest_value_of(i), this->_max);
+        }
+        return this->_max;
+    }
+};
+
+/**
+ * @brief samples key ranks with a Zipfian distribution, rank 0 is the most popular key
+ */
+class zipf_distribution
+{
+protected:
+    std::vector<double> _cdf;
+public:
+    zipf_distribution(std::size_t count, double exponent) : _cdf(count)
+    {
+        double sum = 0;
+        for (std::size_t i = 0; i < count; i++) _cdf[i] = (sum += 1.0 / std::pow((double)(i + 1), exponent));
+        for (double& value : _cdf) value /= sum;
+    }
+    template<typename rng_t>
+    std::size_t operator()(rng_t& rng) const
+    {
+        double sample = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return std::min<std::size_t>(std::lower_bound(_cdf.begin(), _cdf.end(), sample) - _cdf.begin(), _cdf.size() - 1);
+    }
+};
+
+enum operation_type { op_get, op_insert, op_erase, op_scan, op_count };
+static const char* operation_names[op_count] = { "get", "insert", "erase", "scan" };
+
+struct load_config
+{
+    std::string filename = "test_data.txt";
+    std::size_t fanout = 256, threads = 4, operations = 200000, keys = 20000, scan_limit = 100;
+    unsigned mix[op_count] = { 80, 10, 5, 5 }; // percentages of the operations
+    double zipf_exponent = 0.99;
+};
+
+/**
+ * @brief replay the workload on one trie shared by all threads. basic_trie is not thread safe for writers, so inserts and erases
+ *  take the mutex exclusively, while gets (find()) and scans (for_each()) do not modify the trie and share it.
+ *  The measured latency includes the time waiting for the mutex, the wait is also recorded on its own and reported next to it.
+ */
+template<std::size_t children_count>
+void run_load(const load_config& config, const std::vector<std::string>& keys)
+{
+    using key_t = trie::basic_key<children_count>;
+    trie::basic_trie<children_count, std::string> data;
+    std::vector<key_t> trie_keys, prefixes;
+    std::shared_mutex trie_mutex;
+    zipf_distribution popularity(keys.size(), config.zipf_exponent);
+    std::vector<latency_histogram> histograms(config.threads * op_count), wait_histograms(config.threads * op_count);
+    std::vector<std::thread> workers;
+
+    for (const std::string& key : keys)
+    {
+        trie_keys.push_back(key_t(key));
+        prefixes.push_back(key_t(key.substr(0, key.size() / 2)));
+        data.insert(trie_keys.back(), std::make_shared<std::string>(key));
+    }
+
+    auto worker = [&](std::size_t thread_index)
+    {
+        std::mt19937_64 rng(thread_index + 1);
+        std::size_t operations = config.operations / config.threads + (thread_index < config.operations % config.threads ? 1 : 0);
+        unsigned selector, bound;
+        int type;
+        for (std::size_t i = 0; i < operations; i++)
+        {
+            std::size_t rank = popularity(rng);
+            selector = (unsigned)(rng() % 100);
+            for (type = 0, bound = config.mix[0]; type + 1 < op_count && selector >= bound; bound += config.mix[++type]);
+
+            auto start = std::chrono::steady_clock::now();
+            std::chrono::steady_clock::time_point acquired;
+            if (type == op_get || type == op_scan)
+            {
+                std::shared_lock<std::shared_mutex> lock(trie_mutex);
+                acquired = std::chrono::steady_clock::now();
+                if (type == op_get)
+                {
+                    (void)data.find(trie_keys[rank]);
+                }
+                else if (prefixes[rank].size() > 0)
+                {
+                    std::size_t counter = 0;
+                    data.for_each(prefixes[rank], [&counter, &config](const key_t&, std::shared_ptr<std::string>&)
+                        {
+                            return (++counter < config.scan_limit) ? trie::visit_result::proceed : trie::visit_result::stop;
+                        });
+                }
+            }
+            else
+            {
+                std::unique_lock<std::shared_mutex> lock(trie_mutex);
+                acquired = std::chrono::steady_clock::now();
+                if (type == op_insert) data.insert(trie_keys[rank], std::make_shared<std::string>(keys[rank]));
+                else data.erase(trie_keys[rank]);
+            }
+            auto stop = std::chrono::steady_clock::now();
+            histograms[thread_index * op_count + type].record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count());
+            wait_histograms[thread_index * op_count + type].record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(acquired - start).count());
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < config.threads; i++) workers.emplace_back(worker, i);
+    for (std::thread& current : workers) current.join();
+    auto stop = std::chrono::steady_clock::now();
+
+    latency_histogram total, total_wait;
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    std::cout << "trie" << children_count << ", " << config.threads << " threads, " << keys.size() << " keys, zipf " << config.zipf_exponent << ": "
+        << config.operations << " operations in " << seconds << " s (" << config.operations / seconds << " ops/s)" << std::endl
+        << "latencies include the wait for the trie lock (shared for get and scan, exclusive for insert and erase), the wait is listed after them" << std::endl;
+    for (int type = 0; type < op_count; type++)
+    {
+        latency_histogram merged, merged_wait;
+        for (std::size_t i = 0; i < config.threads; i++)
+        {
+            merged.add(histograms[i * op_count + type]);
+            merged_wait.add(wait_histograms[i * op_count + type]);
+        }
+        total.add(merged);
+        total_wait.add(merged_wait);
+        if (merged.count() == 0) continue;
+        std::cout << operation_names[type] << ": " << merged.count() << " ops, p50 " << merged.percentile(50) << " ns, p99 " << merged.percentile(99)
+            << " ns, p999 " << merged.percentile(99.9) << " ns, max " << merged.max() << " ns; lock wait p50 " << merged_wait.percentile(50)
+            << " ns, p99 " << merged_wait.percentile(99) << " ns, max " << merged_wait.max() << " ns" << std::endl;
+    }
+    std::cout << "all: p50 " << total.percentile(50) << " ns, p99 " << total.percentile(99) << " ns, p999 " << total.percentile(99.9)
+        << " ns, max " << total.max() << " ns; lock wait p50 " << total_wait.percentile(50) << " ns, p99 " << total_wait.percentile(99)
+        << " ns, max " << total_wait.max() << " ns" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    load_config config;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        bool has_value = i + 1 < argc;
+        if (argument == "--fanout" && has_value) config.fanout = std::stoull(argv[++i]);
+        else if (argument == "--threads" && has_value) config.threads = std::max<std::size_t>(1, std::stoull(argv[++i]));
+        else if (argument == "--ops" && has_value) config.operations = std::stoull(argv[++i]);
+        else if (argument == "--keys" && has_value) config.keys = std::stoull(argv[++i]);
+        else if (argument == "--zipf" && has_value) config.zipf_exponent = std::stod(argv[++i]);
+        else if (argument == "--scan-limit" && has_value) config.scan_limit = std::stoull(argv[++i]);
+        else if (argument == "--mix" && has_value)
+        {
+            // percentages as get,insert,erase,scan
+            std::string mix = argv[++i];
+            std::size_t position = 0;
+            for (int type = 0; type < op_count; type++)
+            {
+                config.mix[type] = (unsigned)std::stoul(mix.substr(position));
+                position = mix.find(',', position);
+                if (position == std::string::npos && type + 1 < op_count) throw std::runtime_error("--mix needs four comma separated percentages");
+                ++position;
+            }
+        }
+        else if (argument == "--help")
+        {
+            std::cout << "usage: " << argv[0] << " [test_data.txt] [--fanout 256|16|4|2] [--threads n] [--ops n] [--keys n]"
+                << " [--mix get,insert,erase,scan] [--zipf exponent] [--scan-limit n]" << std::endl;
+            return 0;
+        }
+        else config.filename = argument;
+    }
+    if (config.mix[op_get] + config.mix[op_insert] + config.mix[op_erase] + config.mix[op_scan] != 100) throw std::runtime_error("The operation mix has to add up to 100");
+
+    std::ifstream ifile(config.filename);
+    std::vector<std::string> keys = unique_keys(ifile ? read_keys(ifile) : generate_keys(config.keys));
+    if (!ifile) std::cout << "could not open " << config.filename << ", using generated keys" << std::endl;
+    if (keys.empty()) throw std::runtime_error("No keys to replay");
+    // the key order decides the popularity, shuffle it so the popular keys are not all in one subtree
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(3));
+    if (keys.size() > config.keys) keys.resize(config.keys);
+
+    switch (config.fanout)
+    {
+    case 256: run_load<256>(config, keys); break;
+    case 16: run_load<16>(config, keys); break;
+    case 4: run_load<4>(config, keys); break;
+    case 2: run_load<2>(config, keys); break;
+    default: throw std::runtime_error("The fan-out has to be one of 256, 16, 4, 2");
+    }
+    return 0;
+}